@@ -0,0 +1,239 @@
+﻿#include "assetpack.h"
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+
+namespace {
+    bool NamesEqual(const char* a, const char* b) {
+        for (; *a && *b; a++, b++) {
+            if (std::tolower((unsigned char)*a) != std::tolower((unsigned char)*b)) return false;
+        }
+        return *a == *b;
+    }
+
+    const Sprite EMPTY_SPRITE;
+}
+
+void DrawSprite(const Sprite& sprite, int posX, int posY, Color tint) {
+    DrawTextureRec(sprite.texture, sprite.source, { (float)posX, (float)posY }, tint);
+}
+
+SpriteHandle AssetLoader::Request(const char* fileName) {
+    Slot slot;
+    slot.name = fileName;
+    slots.push_back(slot);
+
+    SpriteHandle handle;
+    handle.index = (int)slots.size() - 1;
+    return handle;
+}
+
+bool AssetLoader::OpenPack(const char* fileName) {
+    if (!packFile.Open(fileName)) return false;
+
+    const unsigned char* data = packFile.GetData();
+    size_t size = packFile.GetSize();
+
+    AssetPackHeader header = {};
+    if (size >= sizeof(header)) std::memcpy(&header, data, sizeof(header));
+    if (header.magic != ASSET_PACK_MAGIC || header.version != ASSET_PACK_VERSION) {
+        TraceLog(LOG_WARNING, "ASSETS: [%s] unsupported pack format", fileName);
+        packFile.Close();
+        return false;
+    }
+
+    size_t tablesSize = sizeof(AssetPackHeader) + (size_t)header.pageCount * sizeof(AssetPackPage) +
+        (size_t)header.regionCount * sizeof(AssetPackRegion);
+    if (size < tablesSize) {
+        packFile.Close();
+        return false;
+    }
+
+    packPages.resize(header.pageCount);
+    std::memcpy(packPages.data(), data + sizeof(AssetPackHeader), header.pageCount * sizeof(AssetPackPage));
+
+    packRegions.resize(header.regionCount);
+    std::memcpy(packRegions.data(), data + sizeof(AssetPackHeader) + header.pageCount * sizeof(AssetPackPage),
+        header.regionCount * sizeof(AssetPackRegion));
+
+    for (const auto& page : packPages) {
+        if (page.offset + (unsigned long long)page.width * page.height * 4 > size) {
+            TraceLog(LOG_WARNING, "ASSETS: [%s] page data out of bounds", fileName);
+            packPages.clear();
+            packRegions.clear();
+            packFile.Close();
+            return false;
+        }
+    }
+
+    for (auto& region : packRegions) {
+        region.name[ASSET_NAME_LENGTH - 1] = '\0';
+    }
+    return true;
+}
+
+void AssetLoader::Start(const char* packFileName, int workerCount) {
+    if (OpenPack(packFileName)) {
+        // Спрайты ищутся в таблице регионов сразу; чего нет в паке - считается не найденным
+        for (int i = 0; i < (int)slots.size(); i++) {
+            for (int r = 0; r < (int)packRegions.size(); r++) {
+                if (NamesEqual(packRegions[r].name, slots[i].name.c_str()) && packRegions[r].page < packPages.size()) {
+                    slots[i].region = r;
+                    break;
+                }
+            }
+            if (slots[i].region < 0) {
+                slots[i].finished = true;
+                finishedCount++;
+            }
+        }
+        // Грузятся только страницы, на которых есть запрошенные спрайты
+        for (int page = 0; page < (int)packPages.size(); page++) {
+            bool needed = false;
+            for (const auto& slot : slots) {
+                if (slot.region >= 0 && (int)packRegions[slot.region].page == page) needed = true;
+            }
+            if (!needed) continue;
+
+            Job job;
+            job.page = page;
+            jobs.push_back(job);
+        }
+        TraceLog(LOG_INFO, "ASSETS: [%s] streaming %i pages, %i regions", packFileName,
+            (int)packPages.size(), (int)packRegions.size());
+    }
+    else {
+        for (int i = 0; i < (int)slots.size(); i++) {
+            Job job;
+            job.slot = i;
+            jobs.push_back(job);
+        }
+    }
+
+    // Все задания поставлены до запуска потоков: поток завершается, когда очередь пуста
+    int count = std::max(1, std::min(workerCount, (int)jobs.size()));
+    if (jobs.empty()) count = 0;
+    for (int i = 0; i < count; i++) {
+        workers.emplace_back(&AssetLoader::WorkerLoop, this);
+    }
+}
+
+void AssetLoader::WorkerLoop() {
+    while (!stopping) {
+        Job job;
+        {
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            if (jobs.empty()) return;
+            job = jobs.front();
+            jobs.pop_front();
+        }
+
+        DecodedImage result;
+        result.job = job;
+        if (job.page >= 0) {
+            // Копия страницы из отображения: чтение с диска случается здесь, а не в главном потоке
+            const AssetPackPage& page = packPages[job.page];
+            unsigned int bytes = page.width * page.height * 4;
+            void* pixels = MemAlloc(bytes);
+            std::memcpy(pixels, packFile.GetData() + page.offset, bytes);
+
+            result.image.data = pixels;
+            result.image.width = (int)page.width;
+            result.image.height = (int)page.height;
+            result.image.mipmaps = 1;
+            result.image.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+        }
+        else if (FileExists(slots[job.slot].name.c_str())) {
+            result.image = LoadImage(slots[job.slot].name.c_str());
+        }
+
+        std::lock_guard<std::mutex> lock(decodedMutex);
+        decoded.push_back(result);
+    }
+}
+
+void AssetLoader::FinishSlot(int slot, Texture2D texture, Rectangle source) {
+    slots[slot].sprite.texture = texture;
+    slots[slot].sprite.source = source;
+    slots[slot].finished = true;
+    finishedCount++;
+}
+
+void AssetLoader::UploadPending(double budgetSeconds) {
+    if (IsComplete() && workers.empty()) return;
+
+    double startTime = GetTime();
+    while (true) {
+        DecodedImage item;
+        {
+            std::lock_guard<std::mutex> lock(decodedMutex);
+            if (decoded.empty()) break;
+            item = decoded.front();
+            decoded.pop_front();
+        }
+
+        if (item.image.data == nullptr) {
+            // Файл не найден: отрисовка останется на запасных прямоугольниках
+            slots[item.job.slot].finished = true;
+            finishedCount++;
+        }
+        else {
+            Texture2D texture = LoadTextureFromImage(item.image);
+            UnloadImage(item.image);
+            textures.push_back(texture);
+
+            if (item.job.page >= 0) {
+                for (int i = 0; i < (int)slots.size(); i++) {
+                    if (slots[i].region < 0 || slots[i].finished) continue;
+
+                    const AssetPackRegion& region = packRegions[slots[i].region];
+                    if ((int)region.page != item.job.page) continue;
+                    FinishSlot(i, texture, { region.x, region.y, region.width, region.height });
+                }
+            }
+            else {
+                FinishSlot(item.job.slot, texture, { 0, 0, (float)texture.width, (float)texture.height });
+            }
+        }
+
+        if (GetTime() - startTime >= budgetSeconds) break;
+    }
+
+    if (IsComplete()) {
+        for (auto& worker : workers) worker.join();
+        workers.clear();
+        packFile.Close();
+    }
+}
+
+void AssetLoader::Unload() {
+    stopping = true;
+    for (auto& worker : workers) worker.join();
+    workers.clear();
+    stopping = false;
+
+    jobs.clear();
+    for (auto& item : decoded) {
+        if (item.image.data) UnloadImage(item.image);
+    }
+    decoded.clear();
+
+    for (const auto& texture : textures) {
+        if (texture.id != 0) UnloadTexture(texture);
+    }
+    textures.clear();
+    slots.clear();
+    packPages.clear();
+    packRegions.clear();
+    packFile.Close();
+    finishedCount = 0;
+}
+
+bool AssetLoader::IsReady(SpriteHandle handle) const {
+    return Get(handle).IsReady();
+}
+
+const Sprite& AssetLoader::Get(SpriteHandle handle) const {
+    if (handle.index < 0 || handle.index >= (int)slots.size()) return EMPTY_SPRITE;
+    return slots[handle.index].sprite;
+}
@@ -0,0 +1,124 @@
+﻿#pragma once
+#include "raylib.h"
+#include <vector>
+#include <string>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include "platform.h"
+
+// Формат пака ассетов (assets.pak), собирается утилитой tools/assetpack.
+// Заголовок, таблица страниц, таблица регионов, затем пиксели страниц в RGBA8.
+// Страница 0 - атлас мелких спрайтов, крупные картинки (фоны) лежат отдельными страницами.
+const char* const ASSET_PACK_FILE = "assets.pak";
+const unsigned int ASSET_PACK_MAGIC = 0x4b50444f; // "ODPK"
+const unsigned int ASSET_PACK_VERSION = 1;
+const int ASSET_NAME_LENGTH = 32;
+const int ASSET_PIXEL_ALIGNMENT = 16;
+
+const double ASSET_UPLOAD_BUDGET_SECONDS = 0.002; // Загрузка в GPU за кадр
+const int ASSET_LOADER_MAX_WORKERS = 4;
+
+#pragma pack(push, 1)
+struct AssetPackHeader {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int pageCount;
+    unsigned int regionCount;
+};
+
+struct AssetPackPage {
+    unsigned int width;
+    unsigned int height;
+    unsigned long long offset; // Смещение пикселей от начала файла
+};
+
+struct AssetPackRegion {
+    char name[ASSET_NAME_LENGTH]; // Имя исходного файла в нижнем регистре
+    unsigned int page;
+    float x;
+    float y;
+    float width;
+    float height;
+};
+#pragma pack(pop)
+
+// Спрайт - регион текстуры (атласа или отдельной картинки)
+struct Sprite {
+    Texture2D texture = {};
+    Rectangle source = { 0, 0, 0, 0 };
+
+    bool IsReady() const { return texture.id != 0; }
+};
+
+void DrawSprite(const Sprite& sprite, int posX, int posY, Color tint);
+
+// Хендл спрайта в AssetLoader; пока загрузка не дошла, спрайт не готов
+struct SpriteHandle {
+    int index = -1;
+};
+
+// Асинхронный загрузчик: чтение файлов и декодирование идут на рабочих потоках,
+// загрузка в GPU - на главном потоке порциями в пределах бюджета на кадр.
+// Если есть пак, потоки читают его страницы из отображения, иначе грузят PNG по одному.
+class AssetLoader {
+public:
+    AssetLoader() : stopping(false), finishedCount(0) {}
+    ~AssetLoader() { Unload(); }
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // Регистрирует спрайт; вызывать до Start
+    SpriteHandle Request(const char* fileName);
+    void Start(const char* packFileName, int workerCount);
+
+    // Главный поток: выгружает готовые картинки в текстуры, пока не выйдет бюджет
+    void UploadPending(double budgetSeconds);
+
+    // Останавливает потоки и освобождает все текстуры
+    void Unload();
+
+    bool IsReady(SpriteHandle handle) const;
+    const Sprite& Get(SpriteHandle handle) const;
+    bool IsComplete() const { return finishedCount == (int)slots.size(); }
+    float GetProgress() const { return slots.empty() ? 1.0f : (float)finishedCount / slots.size(); }
+
+private:
+    struct Slot {
+        std::string name;
+        Sprite sprite;
+        int region = -1;       // Регион в паке
+        bool finished = false; // Загружен или не найден
+    };
+
+    // Задание для потока: страница пака (page >= 0) или отдельный файл (slot >= 0)
+    struct Job {
+        int page = -1;
+        int slot = -1;
+    };
+
+    struct DecodedImage {
+        Job job;
+        Image image = {};
+    };
+
+    bool OpenPack(const char* fileName);
+    void WorkerLoop();
+    void FinishSlot(int slot, Texture2D texture, Rectangle source);
+
+    std::vector<Slot> slots;
+    std::vector<Texture2D> textures;
+    std::vector<AssetPackPage> packPages;
+    std::vector<AssetPackRegion> packRegions;
+    MappedFile packFile;
+
+    std::vector<std::thread> workers;
+    std::mutex jobsMutex;
+    std::deque<Job> jobs;
+    std::mutex decodedMutex;
+    std::deque<DecodedImage> decoded;
+    std::atomic<bool> stopping;
+    int finishedCount;
+};
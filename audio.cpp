@@ -0,0 +1,207 @@
+﻿#include "audio.h"
+#include <cmath>
+#include <algorithm>
+
+void AudioSystem::Init() {
+    if (ready) return;
+
+    InitAudioDevice();
+    if (!IsAudioDeviceReady()) return;
+    ready = true;
+
+    // Пул голосов создается один раз: по алиасу на каждую допустимую копию звука
+    for (int s = 0; s < SOUND_COUNT; s++) {
+        lastPlayed[s] = -1000.0f;
+        if (!FileExists(SOUND_DESCS[s].fileName)) continue;
+
+        sounds[s] = LoadSound(SOUND_DESCS[s].fileName);
+        soundLoaded[s] = sounds[s].frameCount > 0;
+        if (!soundLoaded[s]) continue;
+
+        for (int v = 0; v < SOUND_DESCS[s].maxVoices; v++) {
+            Voice voice;
+            voice.sound = s;
+            voice.alias = LoadSoundAlias(sounds[s]);
+            voices.push_back(voice);
+        }
+    }
+}
+
+void AudioSystem::Shutdown() {
+    if (!ready) return;
+
+    StopMusic();
+    for (auto& voice : voices) {
+        StopSound(voice.alias);
+        UnloadSoundAlias(voice.alias);
+    }
+    voices.clear();
+
+    for (int s = 0; s < SOUND_COUNT; s++) {
+        if (soundLoaded[s]) UnloadSound(sounds[s]);
+        soundLoaded[s] = false;
+        pending[s] = PendingSound();
+    }
+
+    CloseAudioDevice();
+    ready = false;
+}
+
+void AudioSystem::Play(SoundId sound, Vector2 position) {
+    if (!ready || !soundLoaded[sound]) return;
+
+    // Расстояние считается до слушателя прошлого тика - за тик он сдвигается на единицы
+    float dx = position.x - listener.x;
+    float dy = position.y - listener.y;
+    float distance = sqrtf(dx * dx + dy * dy);
+    if (distance > AUDIO_HEARING_RADIUS) return;
+
+    PendingSound& event = pending[sound];
+    if (event.count == 0 || distance < event.nearestDistance) {
+        event.nearestDistance = distance;
+        event.position = position;
+    }
+    event.count++;
+}
+
+void AudioSystem::Update(float deltaTime, Vector2 newListener) {
+    time += deltaTime;
+    listener = newListener;
+    if (!ready) return;
+
+    if (musicLoaded) {
+        UpdateMusicStream(music);
+    }
+
+    for (auto& voice : voices) {
+        if (voice.active && !IsSoundPlaying(voice.alias)) {
+            voice.active = false;
+        }
+    }
+
+    for (int s = 0; s < SOUND_COUNT; s++) {
+        PendingSound& event = pending[s];
+        if (event.count == 0) continue;
+
+        int count = event.count;
+        event.count = 0;
+        coalescedEvents += count - 1;
+
+        const SoundDesc& desc = SOUND_DESCS[s];
+        if (time - lastPlayed[s] < desc.minInterval) {
+            droppedEvents++;
+            continue;
+        }
+
+        float attenuation = 1.0f - event.nearestDistance / AUDIO_HEARING_RADIUS;
+        float gain = desc.volume * attenuation * (1.0f + AUDIO_COALESCE_GAIN * log2f((float)count));
+        gain = std::min(gain, 1.0f);
+        float score = desc.priority * gain;
+
+        // В raylib панорама 0.5 - центр, 1.0 - левый канал
+        float pan = 0.5f - 0.5f * (event.position.x - listener.x) / AUDIO_HEARING_RADIUS;
+        pan = std::max(0.0f, std::min(1.0f, pan));
+
+        int victim = FindVictim(s);
+        if (victim >= 0) {
+            if (GetVoiceScore(voices[victim]) >= score) {
+                droppedEvents++;
+                continue;
+            }
+            StopSound(voices[victim].alias);
+            voices[victim].active = false;
+        }
+
+        StartVoice(s, gain, pan, score);
+    }
+}
+
+float AudioSystem::GetVoiceScore(const Voice& voice) const {
+    // Давно звучащий голос уступает новому событию того же веса
+    return voice.score / (1.0f + (time - voice.startTime));
+}
+
+int AudioSystem::FindVictim(int sound) const {
+    int freeOfSound = -1;
+    int weakestOfSound = -1;
+    int weakest = -1;
+    int activeCount = 0;
+
+    for (int i = 0; i < (int)voices.size(); i++) {
+        const Voice& voice = voices[i];
+        if (!voice.active) {
+            if (voice.sound == sound) freeOfSound = i;
+            continue;
+        }
+
+        activeCount++;
+        if (weakest < 0 || GetVoiceScore(voice) < GetVoiceScore(voices[weakest])) weakest = i;
+        if (voice.sound == sound &&
+            (weakestOfSound < 0 || GetVoiceScore(voice) < GetVoiceScore(voices[weakestOfSound]))) {
+            weakestOfSound = i;
+        }
+    }
+
+    // Все копии этого звука заняты - вытесняем самую слабую из них
+    if (freeOfSound < 0) return weakestOfSound;
+
+    // Свободная копия есть, но общий пул исчерпан - вытесняем самый слабый голос
+    if (activeCount >= AUDIO_VOICE_COUNT) return weakest;
+
+    return -1;
+}
+
+void AudioSystem::StartVoice(int sound, float gain, float pan, float score) {
+    for (auto& voice : voices) {
+        if (voice.sound != sound || voice.active) continue;
+
+        SetSoundVolume(voice.alias, gain);
+        SetSoundPan(voice.alias, pan);
+        PlaySound(voice.alias);
+
+        voice.score = score;
+        voice.startTime = time;
+        voice.active = true;
+        lastPlayed[sound] = time;
+        return;
+    }
+}
+
+void AudioSystem::PlayMusic(const char* fileName) {
+    if (!ready || !FileExists(fileName)) return;
+
+    StopMusic();
+
+    // Стрим: с диска декодируется только то, что нужно для заполнения буфера
+    music = LoadMusicStream(fileName);
+    musicLoaded = music.frameCount > 0;
+    if (!musicLoaded) return;
+
+    SetMusicVolume(musicVolume);
+    PlayMusicStream(music);
+}
+
+void AudioSystem::StopMusic() {
+    if (!musicLoaded) return;
+
+    StopMusicStream(music);
+    UnloadMusicStream(music);
+    musicLoaded = false;
+}
+
+void AudioSystem::SetMasterVolume(float volume) {
+    if (ready) ::SetMasterVolume(volume);
+}
+
+void AudioSystem::SetMusicVolume(float volume) {
+    musicVolume = volume;
+    if (musicLoaded) ::SetMusicVolume(music, volume);
+}
+
+int AudioSystem::GetActiveVoices() const {
+    int count = 0;
+    for (const auto& voice : voices) {
+        if (voice.active) count++;
+    }
+    return count;
+}
@@ -0,0 +1,102 @@
+﻿#pragma once
+#include "raylib.h"
+#include <vector>
+
+// Звуковые события игры
+enum SoundId {
+    SOUND_HIT = 0,
+    SOUND_KILL,
+    SOUND_CAST,
+    SOUND_PLAYER_HURT,
+    SOUND_COUNT
+};
+
+// Описание звука: сколько копий может звучать одновременно, приоритет
+// при вытеснении голосов и минимальный интервал между повторами
+struct SoundDesc {
+    const char* fileName;
+    int maxVoices;
+    float priority;
+    float volume;
+    float minInterval;
+};
+
+const SoundDesc SOUND_DESCS[SOUND_COUNT] = {
+    { "sounds/hit.wav",         6, 1.0f, 0.6f, 0.03f },
+    { "sounds/kill.wav",        6, 2.0f, 0.8f, 0.05f },
+    { "sounds/cast.wav",        3, 3.0f, 0.9f, 0.0f },
+    { "sounds/player_hurt.wav", 1, 4.0f, 1.0f, 0.25f },
+};
+
+const char* const MUSIC_FILE = "sounds/music.ogg";
+const int AUDIO_VOICE_COUNT = 12;                 // Общий пул одновременно звучащих голосов
+const float AUDIO_HEARING_RADIUS = 900.0f;        // Дальше этого события не слышны
+const float AUDIO_COALESCE_GAIN = 0.15f;          // Прибавка громкости за каждое удвоение слитых событий
+
+// Звуковая подсистема. События за тик копятся по типу звука и сливаются в одно
+// воспроизведение с ближайшей позицией, поэтому сотни попаданий за тик стоят
+// как одно. Голоса - заранее созданные алиасы звуков (LoadSoundAlias), лишние
+// события вытесняют самые тихие и давние голоса по приоритету и расстоянию.
+// Смешивание идет в потоке аудиоустройства raylib; главный поток только
+// запускает голоса и подкачивает буфер музыки, которая стримится с диска.
+class AudioSystem {
+public:
+    AudioSystem() : ready(false), music({}), musicLoaded(false), musicVolume(1.0f),
+        listener({ 0, 0 }), time(0), droppedEvents(0), coalescedEvents(0) {}
+    ~AudioSystem() { Shutdown(); }
+
+    void Init();
+    void Shutdown();
+
+    // Ставит событие в очередь текущего тика
+    void Play(SoundId sound, Vector2 position);
+
+    // Раз в тик: сливает события, раздает голоса, подкачивает музыку
+    void Update(float deltaTime, Vector2 listener);
+
+    void PlayMusic(const char* fileName);
+    void StopMusic();
+    bool IsMusicPlaying() const { return musicLoaded; }
+    void SetMasterVolume(float volume);
+    void SetMusicVolume(float volume);
+
+    int GetActiveVoices() const;
+    int GetDroppedEvents() const { return droppedEvents; }
+    int GetCoalescedEvents() const { return coalescedEvents; }
+
+private:
+    struct Voice {
+        int sound = -1;
+        Sound alias = {};
+        float score = 0;     // Приоритет * громкость на момент запуска
+        float startTime = 0;
+        bool active = false;
+    };
+
+    // Накопленные за тик события одного звука
+    struct PendingSound {
+        int count = 0;
+        float nearestDistance = 0;
+        Vector2 position = { 0, 0 };
+    };
+
+    float GetVoiceScore(const Voice& voice) const;
+    int FindVictim(int sound) const;
+    void StartVoice(int sound, float gain, float pan, float score);
+
+    bool ready;
+    Sound sounds[SOUND_COUNT] = {};
+    bool soundLoaded[SOUND_COUNT] = {};
+    float lastPlayed[SOUND_COUNT] = {};
+    PendingSound pending[SOUND_COUNT];
+    std::vector<Voice> voices;
+
+    Music music;
+    bool musicLoaded;
+    float musicVolume;
+
+    Vector2 listener;
+    float time;
+    int droppedEvents;
+    int coalescedEvents;
+};
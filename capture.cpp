@@ -0,0 +1,327 @@
+﻿#include "capture.h"
+#include "platform.h"
+#include "raylib.h"
+#include "rlgl.h"
+#include <chrono>
+#include <csignal>
+#include <cstring>
+
+#if defined(_WIN32)
+#define CAPTURE_GLAPI __stdcall
+#define CAPTURE_PIPE_MODE "wb"
+#define popen _popen
+#define pclose _pclose
+#else
+#define CAPTURE_GLAPI
+#define CAPTURE_PIPE_MODE "w"
+#endif
+
+namespace {
+    // rlgl не дает буферов упаковки пикселей, поэтому нужные функции
+    // GL берутся у драйвера напрямую. Константы - из спецификации OpenGL
+    const unsigned int GL_PIXEL_PACK_BUFFER = 0x88EB;
+    const unsigned int GL_STREAM_READ = 0x88E1;
+    const unsigned int GL_MAP_READ_BIT = 0x0001;
+    const unsigned int GL_RGBA = 0x1908;
+    const unsigned int GL_UNSIGNED_BYTE = 0x1401;
+}
+
+struct FrameCapture::GlFunctions {
+    void (CAPTURE_GLAPI* ReadPixels)(int x, int y, int width, int height, unsigned int format, unsigned int type, void* pixels);
+    void (CAPTURE_GLAPI* GenBuffers)(int count, unsigned int* buffers);
+    void (CAPTURE_GLAPI* DeleteBuffers)(int count, const unsigned int* buffers);
+    void (CAPTURE_GLAPI* BindBuffer)(unsigned int target, unsigned int buffer);
+    void (CAPTURE_GLAPI* BufferData)(unsigned int target, ptrdiff_t size, const void* data, unsigned int usage);
+    void* (CAPTURE_GLAPI* MapBufferRange)(unsigned int target, ptrdiff_t offset, ptrdiff_t length, unsigned int access);
+    unsigned char (CAPTURE_GLAPI* UnmapBuffer)(unsigned int target);
+};
+
+FrameCapture::FrameCapture()
+    : width(0), height(0), frameBytes(0), active(false), compressed(false), nextCaptureTime(0),
+    gl(nullptr), pboIndex(0), captured(0), dropped(0), readbackSeconds(0), reportTime(0), reportedDropped(0),
+    spareFrame(-1), stopping(false), written(0), writeFailed(false), output(nullptr) {
+    for (int i = 0; i < CAPTURE_PBO_COUNT; i++) {
+        pbos[i] = 0;
+        pboPending[i] = false;
+    }
+}
+
+bool FrameCapture::LoadGl() {
+    gl = new GlFunctions();
+    gl->ReadPixels = (decltype(gl->ReadPixels))GetGlProcAddress("glReadPixels");
+    gl->GenBuffers = (decltype(gl->GenBuffers))GetGlProcAddress("glGenBuffers");
+    gl->DeleteBuffers = (decltype(gl->DeleteBuffers))GetGlProcAddress("glDeleteBuffers");
+    gl->BindBuffer = (decltype(gl->BindBuffer))GetGlProcAddress("glBindBuffer");
+    gl->BufferData = (decltype(gl->BufferData))GetGlProcAddress("glBufferData");
+    gl->MapBufferRange = (decltype(gl->MapBufferRange))GetGlProcAddress("glMapBufferRange");
+    gl->UnmapBuffer = (decltype(gl->UnmapBuffer))GetGlProcAddress("glUnmapBuffer");
+    if (!gl->ReadPixels) return false;
+
+    // PBO есть с OpenGL 2.1, MapBufferRange - с 3.0; llvmpipe дает оба
+    if (gl->GenBuffers && gl->DeleteBuffers && gl->BindBuffer && gl->BufferData && gl->MapBufferRange && gl->UnmapBuffer) {
+        gl->GenBuffers(CAPTURE_PBO_COUNT, pbos);
+        for (int i = 0; i < CAPTURE_PBO_COUNT; i++) {
+            gl->BindBuffer(GL_PIXEL_PACK_BUFFER, pbos[i]);
+            gl->BufferData(GL_PIXEL_PACK_BUFFER, (ptrdiff_t)frameBytes, nullptr, GL_STREAM_READ);
+        }
+        gl->BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+    return true;
+}
+
+bool FrameCapture::Start(const CaptureConfig& newConfig, int newWidth, int newHeight) {
+    Stop();
+
+    config = newConfig;
+    config.fps = config.fps > 0 ? config.fps : CAPTURE_DEFAULT_FPS;
+    // 4:2:0 требует четных сторон
+    width = newWidth & ~1;
+    height = newHeight & ~1;
+    frameBytes = (size_t)width * height * 4;
+    if (width <= 0 || height <= 0 || config.fileName.empty()) return false;
+
+    size_t dot = config.fileName.rfind('.');
+    compressed = dot == std::string::npos || config.fileName.compare(dot, std::string::npos, ".y4m") != 0;
+
+    if (!LoadGl()) {
+        TraceLog(LOG_WARNING, "CAPTURE: glReadPixels is not available");
+        delete gl;
+        gl = nullptr;
+        return false;
+    }
+    if (!OpenOutput()) {
+        TraceLog(LOG_WARNING, "CAPTURE: cannot open %s", config.fileName.c_str());
+        Stop();
+        return false;
+    }
+
+    frames.assign(CAPTURE_QUEUE_FRAMES, std::vector<unsigned char>(frameBytes));
+    for (int i = 0; i < CAPTURE_QUEUE_FRAMES; i++) freeFrames.Push(i);
+
+    active = true;
+    nextCaptureTime = 0;
+    reportTime = 0;
+    stopping = false;
+    encoder = std::thread(&FrameCapture::EncoderLoop, this);
+
+    TraceLog(LOG_INFO, "CAPTURE: %dx%d at %d fps to %s (%s, %s readback)", width, height, config.fps,
+        config.fileName.c_str(), compressed ? "ffmpeg" : "raw y4m", IsAsync() ? "async PBO" : "synchronous");
+    return true;
+}
+
+bool FrameCapture::AcquireFrame(int& frame) {
+    if (spareFrame >= 0) {
+        frame = spareFrame;
+        spareFrame = -1;
+        return true;
+    }
+    if (freeFrames.Pop(frame)) return true;
+
+    dropped++;
+    return false;
+}
+
+void FrameCapture::Submit(int frame) {
+    // Очередь вмещает все кадры, поэтому Push не отказывает
+    filledFrames.Push(frame);
+}
+
+void FrameCapture::ReadIntoPbo(int pbo) {
+    gl->BindBuffer(GL_PIXEL_PACK_BUFFER, pbos[pbo]);
+    gl->ReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    gl->BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    pboPending[pbo] = true;
+}
+
+void FrameCapture::SubmitPbo(int pbo) {
+    if (!pboPending[pbo]) return;
+    pboPending[pbo] = false;
+
+    int frame;
+    if (!AcquireFrame(frame)) return;
+
+    gl->BindBuffer(GL_PIXEL_PACK_BUFFER, pbos[pbo]);
+    const void* pixels = gl->MapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (ptrdiff_t)frameBytes, GL_MAP_READ_BIT);
+    if (pixels) {
+        std::memcpy(frames[frame].data(), pixels, frameBytes);
+        gl->UnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        Submit(frame);
+    }
+    else {
+        spareFrame = frame;
+        dropped++;
+    }
+    gl->BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void FrameCapture::CaptureFrame(double time) {
+    if (!active || time < nextCaptureTime) return;
+
+    double period = 1.0 / config.fps;
+    // После долгого кадра не догоняем серией захватов подряд
+    nextCaptureTime = nextCaptureTime + period < time ? time + period : nextCaptureTime + period;
+
+    auto start = std::chrono::steady_clock::now();
+
+    // Пакет rlgl еще не отрисован: без этого в кадр не попадет его хвост
+    rlDrawRenderBatchActive();
+
+    if (IsAsync()) {
+        // Читаем в текущий буфер, забираем самый старый: его чтение
+        // закончилось, пока рисовались следующие кадры
+        ReadIntoPbo(pboIndex);
+        pboIndex = (pboIndex + 1) % CAPTURE_PBO_COUNT;
+        SubmitPbo(pboIndex);
+    }
+    else {
+        int frame;
+        if (AcquireFrame(frame)) {
+            gl->ReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, frames[frame].data());
+            Submit(frame);
+        }
+    }
+    captured++;
+
+    std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+    readbackSeconds += cost.count();
+
+    if (time >= reportTime) {
+        if (dropped > reportedDropped) {
+            TraceLog(LOG_WARNING, "CAPTURE: %d frames dropped, encoder queue full", dropped - reportedDropped);
+            reportedDropped = dropped;
+        }
+        reportTime = time + CAPTURE_REPORT_INTERVAL;
+    }
+}
+
+void FrameCapture::Stop() {
+    if (active) {
+        // Кадры, чье чтение еще в PBO, отдаются кодировщику от старых к новым
+        if (IsAsync()) {
+            for (int i = 0; i < CAPTURE_PBO_COUNT; i++) {
+                SubmitPbo((pboIndex + i) % CAPTURE_PBO_COUNT);
+            }
+        }
+        stopping = true;
+        if (encoder.joinable()) encoder.join();
+
+        TraceLog(LOG_INFO, "CAPTURE: %s - %d frames written, %d dropped of %d, %.2f ms per frame on the main thread",
+            config.fileName.c_str(), written.load(), dropped, captured,
+            captured > 0 ? readbackSeconds * 1000.0 / captured : 0.0);
+        if (writeFailed) {
+            TraceLog(LOG_WARNING, "CAPTURE: writing to %s failed", config.fileName.c_str());
+        }
+    }
+    active = false;
+    CloseOutput();
+
+    if (gl) {
+        if (pbos[0] != 0) gl->DeleteBuffers(CAPTURE_PBO_COUNT, pbos);
+        delete gl;
+        gl = nullptr;
+    }
+    for (int i = 0; i < CAPTURE_PBO_COUNT; i++) {
+        pbos[i] = 0;
+        pboPending[i] = false;
+    }
+
+    int frame;
+    while (freeFrames.Pop(frame)) {}
+    while (filledFrames.Pop(frame)) {}
+    frames.clear();
+    spareFrame = -1;
+    pboIndex = 0;
+    captured = 0;
+    dropped = 0;
+    reportedDropped = 0;
+    readbackSeconds = 0;
+    written = 0;
+    writeFailed = false;
+}
+
+bool FrameCapture::OpenOutput() {
+    if (compressed) {
+#if !defined(_WIN32)
+        // Если ffmpeg упал, запись в закрытый канал не должна убить игру
+        signal(SIGPIPE, SIG_IGN);
+#endif
+        char command[1024];
+        snprintf(command, sizeof(command),
+            "ffmpeg -loglevel error -y -f rawvideo -pix_fmt rgba -s %dx%d -r %d -i - "
+            "-vf vflip -c:v libx264 -preset ultrafast -pix_fmt yuv420p \"%s\"",
+            width, height, config.fps, config.fileName.c_str());
+        output = popen(command, CAPTURE_PIPE_MODE);
+        return output != nullptr;
+    }
+
+    output = fopen(config.fileName.c_str(), "wb");
+    if (!output) return false;
+    fprintf(output, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, config.fps);
+    planes.resize((size_t)width * height * 3 / 2);
+    return true;
+}
+
+void FrameCapture::CloseOutput() {
+    if (!output) return;
+    if (compressed) pclose(output);
+    else fclose(output);
+    output = nullptr;
+}
+
+bool FrameCapture::WriteFrame(const unsigned char* rgba) {
+    if (compressed) {
+        return fwrite(rgba, 1, frameBytes, output) == frameBytes;
+    }
+
+    // RGB -> YCbCr BT.601 полного диапазона; строки GL идут снизу вверх
+    unsigned char* yPlane = planes.data();
+    unsigned char* uPlane = yPlane + (size_t)width * height;
+    unsigned char* vPlane = uPlane + (size_t)width * height / 4;
+    for (int y = 0; y < height; y += 2) {
+        const unsigned char* row0 = rgba + (size_t)(height - 1 - y) * width * 4;
+        const unsigned char* row1 = row0 - (size_t)width * 4;
+        unsigned char* y0 = yPlane + (size_t)y * width;
+        unsigned char* y1 = y0 + width;
+        for (int x = 0; x < width; x += 2) {
+            int r = 0, g = 0, b = 0;
+            const unsigned char* pixels[4] = { row0 + x * 4, row0 + x * 4 + 4, row1 + x * 4, row1 + x * 4 + 4 };
+            unsigned char* luma[4] = { y0 + x, y0 + x + 1, y1 + x, y1 + x + 1 };
+            for (int i = 0; i < 4; i++) {
+                int pr = pixels[i][0], pg = pixels[i][1], pb = pixels[i][2];
+                *luma[i] = (unsigned char)((77 * pr + 150 * pg + 29 * pb) >> 8);
+                r += pr;
+                g += pg;
+                b += pb;
+            }
+            r /= 4;
+            g /= 4;
+            b /= 4;
+            size_t chroma = (size_t)(y / 2) * (width / 2) + x / 2;
+            uPlane[chroma] = (unsigned char)(((-43 * r - 85 * g + 128 * b) >> 8) + 128);
+            vPlane[chroma] = (unsigned char)(((128 * r - 107 * g - 21 * b) >> 8) + 128);
+        }
+    }
+
+    return fwrite("FRAME\n", 1, 6, output) == 6 && fwrite(planes.data(), 1, planes.size(), output) == planes.size();
+}
+
+void FrameCapture::EncoderLoop() {
+    while (true) {
+        int frame;
+        if (filledFrames.Pop(frame)) {
+            if (!writeFailed) {
+                if (WriteFrame(frames[frame].data())) written++;
+                else writeFailed = true;
+            }
+            freeFrames.Push(frame);
+            continue;
+        }
+        // Флаг ставится после последнего Push, поэтому повторная проверка очереди
+        // после него увидит все кадры
+        if (stopping) {
+            if (filledFrames.GetSize() == 0) break;
+            continue;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
@@ -0,0 +1,97 @@
+﻿#pragma once
+#include "spsc.h"
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+const int CAPTURE_PBO_COUNT = 2;          // Чтение кадра N идет, пока копируется кадр N-1
+const int CAPTURE_QUEUE_FRAMES = 8;       // Кадров в очереди кодировщика; при полной очереди кадр сбрасывается
+const int CAPTURE_DEFAULT_FPS = 30;
+const float CAPTURE_REPORT_INTERVAL = 5.0f;
+
+// Запись геймплея в файл. ".y4m" - несжатый YUV 4:2:0 (его понимают
+// ffmpeg и плееры), любое другое расширение - сжатое видео через ffmpeg из PATH
+struct CaptureConfig {
+    std::string fileName;
+    int fps = CAPTURE_DEFAULT_FPS;
+};
+
+// Захват кадров без остановки отрисовки. Главный поток ставит чтение
+// заднего буфера в пиксельный буфер (PBO) и забирает прошлый, уже готовый
+// кадр, поэтому не ждет GPU. Копии уходят кодировщику на свой поток через
+// очередь фиксированной длины; если он не успевает, кадр выбрасывается, а
+// не тормозит игру. Без PBO (старый GL) чтение синхронное.
+class FrameCapture {
+public:
+    FrameCapture();
+    ~FrameCapture() { Stop(); }
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    // Нужен GL-контекст; width и height - размер заднего буфера в пикселях
+    bool Start(const CaptureConfig& config, int width, int height);
+
+    // Главный поток, после отрисовки кадра и до EndDrawing. Кадры берутся
+    // с частотой fps по времени time, лишние вызовы ничего не делают
+    void CaptureFrame(double time);
+
+    // Дописывает очередь, закрывает файл и выводит итог
+    void Stop();
+
+    bool IsActive() const { return active; }
+    bool IsAsync() const { return pbos[0] != 0; }
+    int GetCapturedCount() const { return captured; }
+    int GetDroppedCount() const { return dropped; }
+    int GetWrittenCount() const { return written.load(std::memory_order_relaxed); }
+
+private:
+    struct GlFunctions;
+
+    bool LoadGl();
+    void ReadIntoPbo(int pbo);
+    void SubmitPbo(int pbo);
+    void Submit(int frame);
+    bool AcquireFrame(int& frame);
+
+    void EncoderLoop();
+    bool OpenOutput();
+    void CloseOutput();
+    bool WriteFrame(const unsigned char* rgba);
+
+    CaptureConfig config;
+    int width;
+    int height;
+    size_t frameBytes;
+    bool active;
+    bool compressed;
+    double nextCaptureTime;
+
+    // Главный поток
+    GlFunctions* gl;
+    unsigned int pbos[CAPTURE_PBO_COUNT];
+    bool pboPending[CAPTURE_PBO_COUNT];
+    int pboIndex;
+    int captured;
+    int dropped;
+    double readbackSeconds;   // Время главного потока на захват, для отчета
+    double reportTime;
+    int reportedDropped;
+    int spareFrame;           // Взят из свободных, но не заполнен: отдать следующему захвату
+
+    // Кадры ходят по кругу: свободные - от кодировщика к главному потоку,
+    // заполненные - обратно. Оба направления - очереди без блокировок
+    std::vector<std::vector<unsigned char>> frames;
+    SpscQueue<int, 16> freeFrames;
+    SpscQueue<int, 16> filledFrames;
+
+    // Поток кодировщика
+    std::thread encoder;
+    std::atomic<bool> stopping;
+    std::atomic<int> written;
+    std::atomic<bool> writeFailed;
+    FILE* output;
+    std::vector<unsigned char> planes;   // Y, U и V одного кадра для y4m
+};
@@ -0,0 +1,102 @@
+﻿#pragma once
+#include "raylib.h"
+#include "world.h"
+
+// Компоненты игровых сущностей. Номера фиксированы: по ним собираются маски
+// архетипов в снимках перемотки и сейвах, новые компоненты добавляются в конец
+enum ComponentId {
+    COMPONENT_PLACEMENT = 0,
+    COMPONENT_MOTION,
+    COMPONENT_HEALTH,
+    COMPONENT_STATUS,
+    COMPONENT_SIM_LOD,
+    COMPONENT_NET_IDENTITY,
+    COMPONENT_ENEMY,
+    COMPONENT_PROJECTILE,
+    COMPONENT_COMPANION,
+    COMPONENT_ELITE,
+    COMPONENT_COUNT
+};
+
+struct Placement {
+    static const int COMPONENT_ID = COMPONENT_PLACEMENT;
+    Vector2 position;
+    Vector2 previousPosition;  // Позиция на прошлом тике, для интерполяции при отрисовке
+};
+
+struct Motion {
+    static const int COMPONENT_ID = COMPONENT_MOTION;
+    Vector2 velocity;
+};
+
+struct Health {
+    static const int COMPONENT_ID = COMPONENT_HEALTH;
+    int current;
+    int max;
+};
+
+// Наложенные эффекты: заморозка и оглушение останавливают, горение жжет каждый кадр
+struct StatusEffects {
+    static const int COMPONENT_ID = COMPONENT_STATUS;
+    float frozenTimer;
+    float burnTimer;
+    float stunTimer;
+};
+
+// Уровень детализации симуляции и накопленное с прошлого обновления время
+struct SimLod {
+    static const int COMPONENT_ID = COMPONENT_SIM_LOD;
+    int level;
+    float time;
+    int frames;
+};
+
+struct NetIdentity {
+    static const int COMPONENT_ID = COMPONENT_NET_IDENTITY;
+    unsigned int id;   // Выдается сервером при первой отправке в снапшоте, 0 - еще не выдан
+};
+
+// Метка врага: по ней атаки и столкновения находят цели
+struct EnemyTag {
+    static const int COMPONENT_ID = COMPONENT_ENEMY;
+};
+
+struct ProjectileInfo {
+    static const int COMPONENT_ID = COMPONENT_PROJECTILE;
+    bool isFreezing;
+    bool isBurning;
+    bool isElectrifying;
+    bool isMarsSpear;
+    bool isMarsWave;
+    float size;
+    int damage;
+    int companionType;
+    unsigned int expireTick;   // Тик, на котором кончается дальность; 0 - без срока
+    int expireEffect;          // ProjectileExpireEffect
+};
+
+// Элитный враг: больше здоровья и награда, в рои не сливается
+struct EliteTag {
+    static const int COMPONENT_ID = COMPONENT_ELITE;
+};
+
+// Компаньоны перебираются в порядке покупки, первый задает основную атаку
+struct Companion {
+    static const int COMPONENT_ID = COMPONENT_COMPANION;
+    int type;           // 1 - melee, 2 - range, 3 - mars, 4 - ice, 5 - fire, 6 - lightning
+    int starLevel;      // Уровень звезды (1-6)
+    float attackTimer;
+};
+
+inline void RegisterGameComponents(World& world) {
+    world.RegisterComponent<Placement>();
+    world.RegisterComponent<Motion>();
+    world.RegisterComponent<Health>();
+    world.RegisterComponent<StatusEffects>();
+    world.RegisterComponent<SimLod>();
+    world.RegisterComponent<NetIdentity>();
+    world.RegisterComponent<EnemyTag>();
+    world.RegisterComponent<ProjectileInfo>();
+    world.RegisterComponent<Companion>();
+    world.RegisterComponent<EliteTag>();
+}
@@ -0,0 +1,128 @@
+﻿#include "economy.h"
+#include "raylib.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+EconomyPolicyReport::EconomyPolicyReport() : runs(0), survived(0), starSum(0) {
+    for (int i = 0; i < ECONOMY_MAX_SAMPLES; i++) {
+        killsSum[i] = 0;
+        goldSum[i] = 0;
+        aliveAtSample[i] = 0;
+    }
+    for (int i = 0; i < ECONOMY_PURCHASE_KINDS; i++) {
+        purchaseSum[i] = 0;
+    }
+}
+
+void EconomyPolicyReport::Add(const EconomyRunResult& result) {
+    runs++;
+    if (result.survived) survived++;
+    survivalSeconds.push_back(result.survivalSeconds);
+    for (int i = 0; i < result.samples; i++) {
+        killsSum[i] += result.killsEarned[i];
+        goldSum[i] += result.goldEarned[i];
+        aliveAtSample[i]++;
+    }
+    for (int i = 0; i < ECONOMY_PURCHASE_KINDS; i++) {
+        purchaseSum[i] += result.purchases[i];
+    }
+    starSum += result.companionStars;
+}
+
+void EconomyPolicyReport::Merge(const EconomyPolicyReport& other) {
+    runs += other.runs;
+    survived += other.survived;
+    survivalSeconds.insert(survivalSeconds.end(), other.survivalSeconds.begin(), other.survivalSeconds.end());
+    for (int i = 0; i < ECONOMY_MAX_SAMPLES; i++) {
+        killsSum[i] += other.killsSum[i];
+        goldSum[i] += other.goldSum[i];
+        aliveAtSample[i] += other.aliveAtSample[i];
+    }
+    for (int i = 0; i < ECONOMY_PURCHASE_KINDS; i++) {
+        purchaseSum[i] += other.purchaseSum[i];
+    }
+    starSum += other.starSum;
+}
+
+void EconomyPolicyReport::Print(const BotPolicy& policy, float maxSeconds, const std::vector<ShopItem>& items) {
+    if (runs == 0) return;
+
+    std::sort(survivalSeconds.begin(), survivalSeconds.end());
+    auto percentile = [this](float fraction) {
+        return survivalSeconds[std::min(runs - 1, (int)(fraction * runs))];
+    };
+    double mean = 0;
+    for (float seconds : survivalSeconds) mean += seconds;
+    mean /= runs;
+
+    TraceLog(LOG_INFO, "ECONOMY: [%s] %d runs, %.1f%% reach %.0f s, survival mean %.0f s, p10 %.0f s, p50 %.0f s, p90 %.0f s, %.2f stars",
+        policy.name, runs, survived * 100.0f / runs, maxSeconds, mean, percentile(0.1f), percentile(0.5f), percentile(0.9f),
+        (double)starSum / runs);
+
+    // Средние по забегам, живым на момент точки
+    for (int i = 0; i < ECONOMY_MAX_SAMPLES && aliveAtSample[i] > 0; i++) {
+        TraceLog(LOG_INFO, "ECONOMY: [%s]   %4.0f s: %5.1f%% alive, kills %.0f, gold %.0f", policy.name,
+            (i + 1) * ECONOMY_SAMPLE_INTERVAL, aliveAtSample[i] * 100.0f / runs,
+            (double)killsSum[i] / aliveAtSample[i], (double)goldSum[i] / aliveAtSample[i]);
+    }
+
+    TraceLog(LOG_INFO, "ECONOMY: [%s]   purchases per run: companion %.2f, refresh %.2f", policy.name,
+        (double)purchaseSum[ECONOMY_PURCHASE_COMPANION] / runs, (double)purchaseSum[ECONOMY_PURCHASE_REFRESH] / runs);
+    for (int id = 1; id <= SHOP_ITEM_COUNT; id++) {
+        if (purchaseSum[id] == 0) continue;
+        TraceLog(LOG_INFO, "ECONOMY: [%s]   %s %.2f", policy.name, GetShopItemName(items, id), (double)purchaseSum[id] / runs);
+    }
+}
+
+int GetEconomyWorkerCount(const EconomySimConfig& config) {
+    if (config.threads > 0) return config.threads;
+    return std::max(1, (int)std::thread::hardware_concurrency());
+}
+
+void RunEconomySimulation(const EconomySimConfig& config, const EconomyRunFunction& runOne) {
+    std::vector<int> policies = config.policies;
+    if (policies.empty()) {
+        for (int i = 0; i < BOT_POLICY_COUNT; i++) policies.push_back(i);
+    }
+
+    int workerCount = GetEconomyWorkerCount(config);
+    int jobCount = (int)policies.size() * config.runs;
+    std::atomic<int> nextJob(0);
+
+    // Отчеты воркеров: [воркер][политика]
+    std::vector<std::vector<EconomyPolicyReport>> reports(workerCount, std::vector<EconomyPolicyReport>(policies.size()));
+
+    auto startTime = std::chrono::steady_clock::now();
+    auto work = [&](int worker) {
+        EconomyRunResult result;
+        for (int job = nextJob++; job < jobCount; job = nextJob++) {
+            int policy = job / config.runs;
+            int run = job % config.runs;
+            result = EconomyRunResult();
+            runOne(worker, BOT_POLICIES[policies[policy]], config.seed + (unsigned int)run, result);
+            reports[worker][policy].Add(result);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int worker = 1; worker < workerCount; worker++) {
+        threads.emplace_back(work, worker);
+    }
+    work(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+
+    TraceLog(LOG_INFO, "ECONOMY: %d runs on %d threads in %.1f s", jobCount, workerCount, elapsed.count());
+    std::vector<ShopItem> items;
+    BuildShopItems(config.pricing, items);
+    for (int policy = 0; policy < (int)policies.size(); policy++) {
+        for (int worker = 1; worker < workerCount; worker++) {
+            reports[0][policy].Merge(reports[worker][policy]);
+        }
+        reports[0][policy].Print(BOT_POLICIES[policies[policy]], config.maxSeconds, items);
+    }
+}
@@ -1 +1,97 @@
-#pragma once
+﻿#pragma once
+#include "shop.h"
+#include <vector>
+#include <functional>
+
+// Что бот покупает. Веса по id предмета магазина: из доступного бот берет
+// самое весомое, 0 - не покупать никогда.
+struct BotPolicy {
+    const char* name;
+    float itemWeights[SHOP_ITEM_COUNT + 1];   // [0] не используется
+    float companionWeight;                    // Случайный компаньон за золото или убийства
+    int goldReserve;                          // Ниже этого золото не тратится
+    bool refreshForItems;                     // Обновлять магазин, если в слотах нечего брать
+    bool mergeCompanions;
+};
+
+const BotPolicy BOT_POLICIES[] = {
+    { "hoarder",    { 0, 0, 0, 0, 0, 0, 0 }, 0, 0,   false, false },
+    { "companions", { 0, 0, 0, 0, 0, 1, 0 }, 2, 0,   false, true },
+    { "items",      { 0, 3, 2, 0, 3, 1, 1 }, 0, 0,   true,  true },
+    { "balanced",   { 0, 2, 1, 0, 2, 2, 1 }, 2, 200, false, true },
+    { "greedy",     { 0, 1, 1, 1, 1, 1, 1 }, 1, 0,   false, true },
+};
+const int BOT_POLICY_COUNT = sizeof(BOT_POLICIES) / sizeof(BOT_POLICIES[0]);
+
+const int ECONOMY_DEFAULT_RUNS = 1000;          // На каждую политику
+const float ECONOMY_DEFAULT_MAX_SECONDS = 900.0f;
+const float ECONOMY_SAMPLE_INTERVAL = 30.0f;    // Шаг кривых убийств и золота
+const int ECONOMY_MAX_SAMPLES = 64;
+const float ECONOMY_SHOP_INTERVAL = 1.0f;       // Как часто бот заглядывает в магазин
+const int BOT_DIRECTIONS = 9;                    // Стоять и восемь направлений клавиш
+const float BOT_LOOKAHEAD = 0.5f;               // Сек, на сколько вперед бот оценивает направление
+const float BOT_CONTACT_RADIUS = 100.0f;        // Касание врага - 40, плюс полсекунды его хода; дальше бот не отступает
+const float BOT_ENGAGE_FRACTION = 0.8f;         // Доля радиуса атаки основного компаньона, на которой бот держит ближнего врага
+const float BOT_ENGAGE_PULL = 0.000001f;        // Вес лишнего расстояния до ближнего врага против близости врагов
+const float BOT_CENTER_PULL = 0.0005f;          // Вес расстояния до центра карты против близости врагов
+const int BOT_MAX_SHOP_ACTIONS = 16;            // Покупок и обновлений за один заход
+
+// Виды покупок: 0 - случайный компаньон, 1..SHOP_ITEM_COUNT - предметы по id,
+// последний - ручное обновление магазина
+const int ECONOMY_PURCHASE_COMPANION = 0;
+const int ECONOMY_PURCHASE_REFRESH = SHOP_ITEM_COUNT + 1;
+const int ECONOMY_PURCHASE_KINDS = SHOP_ITEM_COUNT + 2;
+
+struct EconomySimConfig {
+    int runs = ECONOMY_DEFAULT_RUNS;
+    float maxSeconds = ECONOMY_DEFAULT_MAX_SECONDS;
+    unsigned int seed = 1;
+    int threads = 0;                              // 0 - все ядра
+    std::vector<int> policies;                    // Индексы BOT_POLICIES; пусто - все
+    ShopPricing pricing;
+};
+
+// Итог одного забега. Кривые - заработанное с начала (потраченное тоже
+// учитывается), точка на каждые ECONOMY_SAMPLE_INTERVAL секунд жизни.
+struct EconomyRunResult {
+    float survivalSeconds = 0;
+    bool survived = false;
+    int samples = 0;
+    int killsEarned[ECONOMY_MAX_SAMPLES] = {};
+    int goldEarned[ECONOMY_MAX_SAMPLES] = {};
+    int purchases[ECONOMY_PURCHASE_KINDS] = {};
+    int companionStars = 0;                       // Сумма звезд к концу забега
+};
+
+// Сводка по политике. Воркеры копят свои сводки без блокировок и
+// сливаются в конце.
+class EconomyPolicyReport {
+public:
+    EconomyPolicyReport();
+
+    void Add(const EconomyRunResult& result);
+    void Merge(const EconomyPolicyReport& other);
+    // Имена покупок берутся из таблицы предметов магазина
+    void Print(const BotPolicy& policy, float maxSeconds, const std::vector<ShopItem>& items);
+
+private:
+    int runs;
+    int survived;
+    std::vector<float> survivalSeconds;
+    long long killsSum[ECONOMY_MAX_SAMPLES];
+    long long goldSum[ECONOMY_MAX_SAMPLES];
+    int aliveAtSample[ECONOMY_MAX_SAMPLES];
+    long long purchaseSum[ECONOMY_PURCHASE_KINDS];
+    long long starSum;
+};
+
+// Прогон одного забега на мире воркера: мир создается заранее, по одному
+// на поток, и переиспользуется между забегами
+typedef std::function<void(int worker, const BotPolicy& policy, unsigned int seed, EconomyRunResult& result)> EconomyRunFunction;
+
+int GetEconomyWorkerCount(const EconomySimConfig& config);
+
+// Раздает забеги воркерам и печатает сводку по каждой политике. Забег с
+// номером i получает сид seed + i в каждой политике: политики сравниваются
+// на одних и тех же раскладах.
+void RunEconomySimulation(const EconomySimConfig& config, const EconomyRunFunction& runOne);
@@ -0,0 +1,230 @@
+﻿#pragma once
+#include "raylib.h"
+#include <vector>
+#include "globals.h"
+#include "rng.h"
+#include "components.h"
+
+// Уровни детализации симуляции врагов
+enum EnemyLod {
+    ENEMY_LOD_FULL = 0,   // Каждый кадр: поле потоков и расталкивание
+    ENEMY_LOD_REDUCED,    // Реже, с накопленным шагом
+    ENEMY_LOD_ANALYTIC,   // Редко, прямо к игроку одним шагом
+    ENEMY_LOD_COUNT
+};
+
+// Интервалы обновления по уровням (сек). За самый длинный шаг враг и игрок
+// сближаются не больше чем на (110 + ~200) * 0.25 = ~80 единиц,
+// поэтому запасы ниже гарантируют переход на полную частоту заранее.
+const float ENEMY_LOD_INTERVALS[ENEMY_LOD_COUNT] = { 0.0f, 0.05f, 0.25f };
+const float ENEMY_LOD_ACTIVE_RADIUS = 500.0f;   // Радиус боя (300 у Fire Mage) + запас
+const float ENEMY_LOD_REDUCED_RADIUS = 1200.0f;
+const float ENEMY_LOD_SCREEN_MARGIN = 150.0f;
+const float ENEMY_LOD_REDUCED_SCREEN_MARGIN = 600.0f;
+
+// Выбирает уровень детализации по расстоянию до игрока и видимой области;
+// радиус полной симуляции задается уровнем качества
+int ClassifyEnemyLod(Vector2 enemyPosition, Vector2 playerPosition, Rectangle view,
+    float activeRadius = ENEMY_LOD_ACTIVE_RADIUS);
+
+// Враг в мире сущностей: метка, позиция, здоровье, эффекты, уровень детализации и сетевой id
+Entity CreateEnemy(World& world, Vector2 position, int health = ENEMY_MAX_HEALTH, int lodLevel = ENEMY_LOD_FULL);
+
+const int ELITE_HEALTH_MULTIPLIER = 5;
+const int ELITE_GOLD_BONUS = 50;
+
+// Элитный враг: обычный враг с меткой EliteTag и запасом здоровья в ELITE_HEALTH_MULTIPLIER раз
+Entity CreateEliteEnemy(World& world, Vector2 position);
+
+// Константы агрегации орды
+const float SWARM_CELL_SIZE = 250.0f;
+const int SWARM_MIN_MEMBERS = 4;
+const float SWARM_MERGE_INTERVAL = 0.5f;
+const float SWARM_MERGE_HYSTERESIS = 400.0f; // Запас, чтобы рой не сливался сразу после разбиения
+const float SWARM_SPEED = 110.0f;
+
+// Прокси для плотного скопления дальних врагов: одна сущность вместо count записей
+struct EnemySwarm {
+    Vector2 position;   // Центроид
+    float spread;       // Радиус скопления вокруг центроида
+    int count;
+    int totalHealth;
+};
+
+// Сливает дальних врагов без статусов в рои и разбивает рои обратно в обычных
+// врагов, когда рой приближается к игроку или камере
+class EnemySwarms {
+public:
+    EnemySwarms() : mergeTimer(0), memberCount(0) {}
+
+    void Clear();
+
+    // Двигает рои, разбивает близкие и раз в SWARM_MERGE_INTERVAL сливает дальних врагов.
+    // Слитые враги удаляются из мира, разбитые создаются заново.
+    void Update(float deltaTime, Vector2 playerPosition, Rectangle view, World& world);
+
+    int GetMemberCount() const { return memberCount; }
+    const std::vector<EnemySwarm>& GetSwarms() const { return swarms; }
+
+    // Для снимков состояния (перемотка)
+    float GetMergeTimer() const { return mergeTimer; }
+    void Restore(float newMergeTimer, int newMemberCount, const EnemySwarm* data, int count);
+
+private:
+    void Merge(Vector2 playerPosition, Rectangle view, World& world);
+    void Split(const EnemySwarm& swarm, World& world);
+
+    float mergeTimer;
+    int memberCount;
+    std::vector<EnemySwarm> swarms;
+    std::vector<std::pair<long long, int>> candidates;   // Клетка, индекс в candidateEntities
+    std::vector<Entity> candidateEntities;
+};
+
+// Настройки режиссера спавна
+struct SpawnDirectorConfig {
+    float frameBudgetMs = 4.0f;     // Бюджет CPU на тик симуляции
+    int maxSpawnsPerFrame = 8;      // Партия спавна за один кадр
+    int maxPendingSpawns = 64;      // Сверх этого запросы отбрасываются
+    float ringMargin = 120.0f;      // Насколько дальше края камеры ставить врагов
+    bool benchmark = false;         // Спавнить без лимита и искать предел железа
+    bool unbudgeted = false;        // Спавнить по графику игры, не глядя на стоимость тика (симуляция экономики)
+};
+
+const int SPAWN_POSITION_BUFFER = 32;
+const float SPAWN_COST_SMOOTHING = 0.1f;
+const float SPAWN_BENCHMARK_SATURATION_TIME = 2.0f;
+
+// Состояние режиссера для снимков (перемотка, сейвы); настройки в снимок не входят
+struct SpawnDirectorState {
+    double averageTickCost;
+    double averageEntityCost;
+    int pendingSpawns;
+    float saturatedTime;
+    int nextPosition;
+    int preparedPositions;
+    Vector2 spawnDirections[SPAWN_POSITION_BUFFER];
+};
+
+// Решает, сколько врагов спавнить в этом кадре, по измеренной стоимости тика.
+// Запросы копятся и выдаются партиями в пределах бюджета, позиции заранее
+// разложены по кольцу за пределами камеры.
+class SpawnDirector {
+public:
+    SpawnDirector() { Reset(); }
+
+    void Reset();
+    void Configure(const SpawnDirectorConfig& newConfig) { config = newConfig; }
+    const SpawnDirectorConfig& GetConfig() const { return config; }
+
+    // Стоимость последнего тика и число сущностей, которые он обработал
+    void RecordTickCost(double seconds, int entityCount, float deltaTime);
+
+    // Ставит врагов в очередь; сверх maxPendingSpawns запросы отбрасываются.
+    // Возвращает, сколько принято
+    int Request(int count);
+
+    // Сколько врагов можно заспавнить в этом кадре, не выходя за бюджет
+    int TakeSpawnsThisFrame(int entityCount);
+
+    // Смещение очередной точки спавна от центра камеры
+    Vector2 NextSpawnOffset(Rectangle view, GameRandom& rng);
+
+    float GetAverageTickMs() const { return (float)(averageTickCost * 1000.0); }
+    int GetPendingSpawns() const { return pendingSpawns; }
+
+    // Оценка максимального числа сущностей, укладывающихся в бюджет
+    int GetSustainableEntityCount() const;
+    bool IsSaturated() const { return saturatedTime >= SPAWN_BENCHMARK_SATURATION_TIME; }
+
+    SpawnDirectorState Snapshot() const;
+    void Restore(const SpawnDirectorState& state);
+
+private:
+    void RefillPositions(GameRandom& rng);
+
+    SpawnDirectorConfig config;
+    double averageTickCost;
+    double averageEntityCost;
+    int pendingSpawns;
+    float saturatedTime;
+
+    Vector2 spawnDirections[SPAWN_POSITION_BUFFER];
+    int nextPosition;
+    int preparedPositions;
+};
+
+// Константы навигации
+const float FLOW_FIELD_CELL_SIZE = 100.0f;
+const float ENEMY_SEPARATION_RADIUS = 40.0f;
+const float ENEMY_SEPARATION_STRENGTH = 80.0f;
+const int MAX_SEPARATION_NEIGHBOURS = 12;
+
+// Момент t из [0, 1], в который точка, идущая по отрезку from-to, впервые
+// оказывается ближе radius к center. Точка, уже бывшая внутри, дает t = 0
+bool SweepPointCircle(Vector2 from, Vector2 to, Vector2 center, float radius, float& t);
+
+// Поле потоков на грубой сетке поверх карты.
+// Пересчитывается (Дейкстра от клетки игрока) только когда игрок меняет клетку
+// или меняются препятствия; каждый враг просто читает направление своей клетки.
+// Та же сетка используется как бакеты для дешевого расталкивания соседей
+// и как широкая фаза столкновений снарядов.
+class FlowField {
+public:
+    FlowField() : cellSize(FLOW_FIELD_CELL_SIZE), width(0), height(0),
+        targetCellX(-1), targetCellY(-1), dirty(true), stamp(0) {}
+
+    void Init(Vector2 worldSize, float newCellSize);
+
+    // Возвращает true, если поле было пересчитано
+    bool Update(Vector2 target);
+
+    // Препятствия (для подсистемы уровней)
+    void SetBlocked(int cellX, int cellY, bool blocked);
+    bool IsBlocked(int cellX, int cellY) const;
+    void ClearBlocked();
+
+    // Единичное направление к цели; {0, 0} в клетке цели или если цель недостижима
+    Vector2 GetDirection(Vector2 position) const;
+
+    // Раскладывает позиции врагов по клеткам (сортировка подсчетом), вызывается раз за кадр
+    void BuildAgentGrid(const std::vector<Vector2>& positions);
+
+    // Вектор расталкивания для позиции с индексом index по соседям из той же сетки
+    Vector2 GetSeparation(const std::vector<Vector2>& positions, int index) const;
+
+    // Дописывает в out индексы из сетки, которые может задеть круг радиуса radius,
+    // идущий по отрезку from-to: клетки вдоль отрезка (обход DDA) и их соседи
+    // в пределах radius. Каждый индекс попадает в out один раз
+    void GatherAgentsAlongSegment(Vector2 from, Vector2 to, float radius, std::vector<int>& out);
+
+    int GetWidth() const { return width; }
+    int GetHeight() const { return height; }
+    float GetCellSize() const { return cellSize; }
+
+private:
+    int CellIndexX(float x) const;
+    int CellIndexY(float y) const;
+    void Rebuild();
+
+    float cellSize;
+    int width;
+    int height;
+    int targetCellX;
+    int targetCellY;
+    bool dirty;
+
+    std::vector<unsigned char> blockedCells;
+    std::vector<int> distances;
+    std::vector<Vector2> directions;
+
+    // Бакеты врагов: индексы в positions, сгруппированные по клеткам
+    std::vector<int> cellStart;
+    std::vector<int> cellCount;
+    std::vector<int> agentIndices;
+    std::vector<int> agentCells;
+
+    // Метки уже просмотренных клеток для GatherAgentsAlongSegment
+    std::vector<unsigned int> cellStamps;
+    unsigned int stamp;
+};
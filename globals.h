@@ -0,0 +1,12 @@
+﻿#pragma once
+
+// Размеры окна
+const int SCREEN_WIDTH = 1024;
+const int SCREEN_HEIGHT = 1024;
+
+// Константы для баланса игры
+const int MAX_ENEMIES = 70;
+const int PLAYER_MAX_HEALTH = 100;
+const int ENEMY_MAX_HEALTH = 100;
+const int GAME_OVER_TIMER = 5;
+const int MAX_INVENTORY_SLOTS = 6;
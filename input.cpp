@@ -0,0 +1,145 @@
+﻿#include "input.h"
+#include "platform.h"
+#include <chrono>
+
+namespace {
+    // Привязка действия: клавиша или кнопка raylib и тот же ключ в кодах платформы
+    struct InputBinding {
+        int raylibCode;
+        bool mouse;
+        int virtualKey;
+    };
+
+    const InputBinding INPUT_BINDINGS[INPUT_ACTION_COUNT] = {
+        { KEY_W, false, 'W' },
+        { KEY_S, false, 'S' },
+        { KEY_A, false, 'A' },
+        { KEY_D, false, 'D' },
+        { MOUSE_RIGHT_BUTTON, true, 0x02 },   // VK_RBUTTON
+        { MOUSE_LEFT_BUTTON, true, 0x01 },    // VK_LBUTTON
+        { KEY_ENTER, false, 0x0D },           // VK_RETURN
+        { KEY_F, false, 'F' },
+        { KEY_M, false, 'M' },
+        { KEY_BACKSPACE, false, 0x08 },       // VK_BACK
+        { KEY_F9, false, 0x78 },
+        { KEY_F5, false, 0x74 },
+        { KEY_F8, false, 0x77 },
+        { KEY_LEFT, false, 0x25 },
+        { KEY_RIGHT, false, 0x27 },
+    };
+}
+
+double InputClock() {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+InputSampler::InputSampler() : window(nullptr), sampleRate(INPUT_SAMPLE_RATE), running(false), retries(0) {
+    for (int i = 0; i < INPUT_ACTION_COUNT; i++) previousDown[i] = false;
+}
+
+void InputSampler::Start(void* newWindow, int newSampleRate) {
+    Stop();
+    window = newWindow;
+    sampleRate = newSampleRate > 0 ? newSampleRate : INPUT_SAMPLE_RATE;
+    if (!IsAsyncInputSupported() || !window) return;
+
+    running = true;
+    thread = std::thread(&InputSampler::SampleLoop, this);
+}
+
+void InputSampler::Stop() {
+    running = false;
+    if (thread.joinable()) thread.join();
+}
+
+void InputSampler::SampleFrame() {
+    if (IsThreaded()) return;
+
+    bool down[INPUT_ACTION_COUNT];
+    for (int i = 0; i < INPUT_ACTION_COUNT; i++) {
+        const InputBinding& binding = INPUT_BINDINGS[i];
+        down[i] = binding.mouse ? IsMouseButtonDown(binding.raylibCode) : IsKeyDown(binding.raylibCode);
+    }
+    Sample(InputClock(), down, GetMousePosition());
+}
+
+void InputSampler::SampleLoop() {
+    // Период опроса держится по абсолютным моментам, чтобы не копить опоздания
+    // sleep_for. Точность сна на Windows - 1 мс: raylib включает timeBeginPeriod(1)
+    auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / sampleRate));
+    auto next = std::chrono::steady_clock::now();
+
+    while (running) {
+        bool down[INPUT_ACTION_COUNT] = {};
+        Vector2 cursor = { 0, 0 };
+        // Без фокуса все отпущено: чужие нажатия в игру не попадают
+        if (IsAsyncWindowFocused(window)) {
+            for (int i = 0; i < INPUT_ACTION_COUNT; i++) {
+                down[i] = IsAsyncKeyDown(INPUT_BINDINGS[i].virtualKey);
+            }
+            GetAsyncCursor(window, cursor.x, cursor.y);
+        }
+        Sample(InputClock(), down, cursor);
+
+        next += period;
+        auto now = std::chrono::steady_clock::now();
+        if (next < now) next = now;
+        std::this_thread::sleep_until(next);
+    }
+}
+
+void InputSampler::Sample(double time, const bool* down, Vector2 cursor) {
+    for (int i = 0; i < INPUT_ACTION_COUNT; i++) {
+        if (down[i] == previousDown[i]) continue;
+
+        InputEvent event = { time, cursor, (unsigned char)i, down[i] };
+        // Состояние запоминается только для ушедшего события: иначе смена
+        // повторится на следующем опросе, и нажатие не потеряется
+        if (events.Push(event)) {
+            previousDown[i] = down[i];
+        }
+        else {
+            retries.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+void InputState::Reset() {
+    for (int i = 0; i < INPUT_ACTION_COUNT; i++) {
+        down[i] = false;
+        pressed[i] = false;
+        pressCursor[i] = { 0, 0 };
+    }
+    hasPending = false;
+}
+
+void InputState::BeginTick() {
+    for (int i = 0; i < INPUT_ACTION_COUNT; i++) pressed[i] = false;
+}
+
+void InputState::ConsumeUntil(InputSampler& sampler, double time) {
+    if (hasPending) {
+        if (pending.time > time) return;
+        Apply(pending);
+        hasPending = false;
+    }
+
+    InputEvent event;
+    while (sampler.Pop(event)) {
+        if (event.time > time) {
+            pending = event;
+            hasPending = true;
+            return;
+        }
+        Apply(event);
+    }
+}
+
+void InputState::Apply(const InputEvent& event) {
+    down[event.action] = event.down;
+    if (event.down) {
+        pressed[event.action] = true;
+        pressCursor[event.action] = event.cursor;
+    }
+}
@@ -0,0 +1,109 @@
+﻿#pragma once
+#include "raylib.h"
+#include "spsc.h"
+#include <atomic>
+#include <thread>
+
+const int INPUT_SAMPLE_RATE = 1000;       // Опросов в секунду на потоке ввода
+const int INPUT_QUEUE_CAPACITY = 1024;
+
+// Игровые действия; клавиши и кнопки мыши привязаны к ним в input.cpp
+enum InputAction {
+    INPUT_MOVE_UP = 0,
+    INPUT_MOVE_DOWN,
+    INPUT_MOVE_LEFT,
+    INPUT_MOVE_RIGHT,
+    INPUT_ATTACK,        // Правая кнопка мыши
+    INPUT_CLICK,         // Левая кнопка мыши: кнопки интерфейса
+    INPUT_CONFIRM,       // Enter
+    INPUT_MERGE,         // F
+    INPUT_MINIMAP,       // M
+    INPUT_REWIND_STEP,   // Backspace
+    INPUT_REWIND_HITCH,  // F9
+    INPUT_QUICK_SAVE,    // F5
+    INPUT_QUICK_LOAD,    // F8
+    INPUT_VOLUME_DOWN,   // Стрелка влево в настройках
+    INPUT_VOLUME_UP,     // Стрелка вправо в настройках
+    INPUT_ACTION_COUNT
+};
+
+// Смена состояния действия с моментом опроса и курсором в этот момент
+struct InputEvent {
+    double time;         // InputClock()
+    Vector2 cursor;
+    unsigned char action;
+    bool down;
+};
+
+// Часы меток событий: монотонные и одинаковые для всех потоков
+double InputClock();
+
+// Источник событий ввода. Где платформа умеет опрашивать клавиатуру из
+// любого потока (см. IsAsyncInputSupported), опрос идет на своем потоке
+// с частотой sampleRate и не зависит от длины кадра: нажатие и отпускание
+// внутри одного кадра дают два события. Иначе состояние раз в кадр берется
+// у raylib в SampleFrame. В обоих случаях события идут в одну очередь
+class InputSampler {
+public:
+    InputSampler();
+    ~InputSampler() { Stop(); }
+
+    InputSampler(const InputSampler&) = delete;
+    InputSampler& operator=(const InputSampler&) = delete;
+
+    // window - хендл окна raylib (GetWindowHandle)
+    void Start(void* window, int sampleRate);
+    void Stop();
+
+    // Главный поток, раз в кадр после опроса событий окна; при потоке опроса ничего не делает
+    void SampleFrame();
+
+    // Читатель очереди - главный поток
+    bool Pop(InputEvent& event) { return events.Pop(event); }
+
+    bool IsThreaded() const { return thread.joinable(); }
+    // Смены состояния, не влезшие в очередь с первого раза (повторяются на следующем опросе)
+    int GetRetryCount() const { return retries.load(std::memory_order_relaxed); }
+
+private:
+    void SampleLoop();
+    void Sample(double time, const bool* down, Vector2 cursor);
+
+    void* window;
+    int sampleRate;
+    bool previousDown[INPUT_ACTION_COUNT];
+    std::thread thread;
+    std::atomic<bool> running;
+    std::atomic<int> retries;
+    SpscQueue<InputEvent, INPUT_QUEUE_CAPACITY> events;
+};
+
+// Состояние действий со стороны симуляции. Тик забирает события до своего
+// момента включительно, в порядке опроса; более поздние ждут следующего тика
+class InputState {
+public:
+    InputState() { Reset(); }
+
+    // Все отпущено, отложенное событие выброшено
+    void Reset();
+
+    // Сбрасывает нажатия прошлого тика
+    void BeginTick();
+    void ConsumeUntil(InputSampler& sampler, double time);
+
+    bool IsDown(InputAction action) const { return down[action]; }
+    bool WasPressed(InputAction action) const { return pressed[action]; }
+    // Зажато сейчас или нажималось за тик: короткое касание тоже сдвинет игрока
+    bool IsHeld(InputAction action) const { return down[action] || pressed[action]; }
+    // Курсор при последнем нажатии за тик
+    Vector2 GetPressCursor(InputAction action) const { return pressCursor[action]; }
+
+private:
+    void Apply(const InputEvent& event);
+
+    bool down[INPUT_ACTION_COUNT];
+    bool pressed[INPUT_ACTION_COUNT];
+    Vector2 pressCursor[INPUT_ACTION_COUNT];
+    bool hasPending;
+    InputEvent pending;   // Прочитано из очереди, но относится к будущему тику
+};
@@ -0,0 +1,303 @@
+﻿#include "level.h"
+#include "enemy.h"
+#include "globals.h"
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <algorithm>
+
+namespace {
+    const bool TILE_SOLID[TILE_COUNT] = { false, false, true, true };
+
+    const Color TILE_COLORS[TILE_COUNT] = {
+        BLANK,
+        Color{ 94, 72, 48, 255 },
+        Color{ 96, 96, 104, 255 },
+        Color{ 32, 72, 140, 255 }
+    };
+
+    unsigned int HashCoords(int x, int y, unsigned int salt) {
+        unsigned int h = (unsigned int)x * 374761393u + (unsigned int)y * 668265263u + salt * 2246822519u;
+        h = (h ^ (h >> 13)) * 1274126177u;
+        return h ^ (h >> 16);
+    }
+
+    std::string ChunkFileName(int chunkX, int chunkY) {
+        return "levels/chunk_" + std::to_string(chunkX) + "_" + std::to_string(chunkY) + ".bin";
+    }
+}
+
+void Level::Init(Vector2 newWorldSize, unsigned int newSeed) {
+    Unload();
+    worldSize = newWorldSize;
+    seed = newSeed;
+    frameCounter = 0;
+    BuildCollision();
+    collisionVersion++;
+}
+
+void Level::Unload() {
+    for (auto& entry : chunks) {
+        if (entry.second.hasTexture) {
+            UnloadRenderTexture(entry.second.texture);
+        }
+    }
+    chunks.clear();
+}
+
+bool Level::IsChunkInWorld(int chunkX, int chunkY) const {
+    return chunkX >= 0 && chunkY >= 0 &&
+        chunkX * LEVEL_CHUNK_SIZE < worldSize.x && chunkY * LEVEL_CHUNK_SIZE < worldSize.y;
+}
+
+LevelChunk* Level::FindChunk(int chunkX, int chunkY) {
+    auto it = chunks.find(ChunkKey(chunkX, chunkY));
+    return it != chunks.end() ? &it->second : nullptr;
+}
+
+const LevelChunk* Level::FindChunk(int chunkX, int chunkY) const {
+    auto it = chunks.find(ChunkKey(chunkX, chunkY));
+    return it != chunks.end() ? &it->second : nullptr;
+}
+
+void Level::Update(Vector2 cameraOffset) {
+    frameCounter++;
+
+    int minX = (int)std::floor(cameraOffset.x / LEVEL_CHUNK_SIZE);
+    int minY = (int)std::floor(cameraOffset.y / LEVEL_CHUNK_SIZE);
+    int maxX = (int)std::floor((cameraOffset.x + SCREEN_WIDTH - 1) / LEVEL_CHUNK_SIZE);
+    int maxY = (int)std::floor((cameraOffset.y + SCREEN_HEIGHT - 1) / LEVEL_CHUNK_SIZE);
+
+    // Видимые чанки нужны в этом же кадре
+    for (int cy = minY; cy <= maxY; cy++) {
+        for (int cx = minX; cx <= maxX; cx++) {
+            if (!IsChunkInWorld(cx, cy)) continue;
+
+            LevelChunk* chunk = FindChunk(cx, cy);
+            if (!chunk) chunk = &LoadChunk(cx, cy);
+            chunk->lastUsedFrame = frameCounter;
+        }
+    }
+
+    // Кольцо вокруг экрана догружается заранее, не больше N чанков за кадр
+    int prefetched = 0;
+    for (int cy = minY - 1; cy <= maxY + 1 && prefetched < MAX_CHUNK_PREFETCH_PER_FRAME; cy++) {
+        for (int cx = minX - 1; cx <= maxX + 1 && prefetched < MAX_CHUNK_PREFETCH_PER_FRAME; cx++) {
+            if (!IsChunkInWorld(cx, cy) || FindChunk(cx, cy)) continue;
+            LoadChunk(cx, cy).lastUsedFrame = frameCounter;
+            prefetched++;
+        }
+    }
+
+    EvictChunks(minX, minY, maxX, maxY);
+}
+
+void Level::EvictChunks(int minVisibleX, int minVisibleY, int maxVisibleX, int maxVisibleY) {
+    while ((int)chunks.size() > MAX_RESIDENT_CHUNKS) {
+        auto oldest = chunks.end();
+        for (auto it = chunks.begin(); it != chunks.end(); ++it) {
+            const LevelChunk& chunk = it->second;
+            bool visible = chunk.chunkX >= minVisibleX && chunk.chunkX <= maxVisibleX &&
+                chunk.chunkY >= minVisibleY && chunk.chunkY <= maxVisibleY;
+            if (visible) continue;
+
+            if (oldest == chunks.end() || chunk.lastUsedFrame < oldest->second.lastUsedFrame) {
+                oldest = it;
+            }
+        }
+
+        if (oldest == chunks.end()) break;
+
+        if (oldest->second.hasTexture) {
+            UnloadRenderTexture(oldest->second.texture);
+        }
+        chunks.erase(oldest);
+    }
+}
+
+LevelChunk& Level::LoadChunk(int chunkX, int chunkY) {
+    LevelChunk& chunk = chunks[ChunkKey(chunkX, chunkY)];
+    chunk.chunkX = chunkX;
+    chunk.chunkY = chunkY;
+
+    if (!LoadChunkFromDisk(chunk)) {
+        GenerateChunk(chunk);
+    }
+
+    if (rendering) RenderChunk(chunk);
+    return chunk;
+}
+
+bool Level::LoadChunkFromDisk(LevelChunk& chunk) const {
+    std::string fileName = ChunkFileName(chunk.chunkX, chunk.chunkY);
+    if (!FileExists(fileName.c_str())) return false;
+
+    int dataSize = 0;
+    unsigned char* data = LoadFileData(fileName.c_str(), &dataSize);
+    bool ok = data && dataSize == (int)sizeof(chunk.tiles);
+
+    if (ok) {
+        std::memcpy(chunk.tiles, data, sizeof(chunk.tiles));
+        for (auto& tile : chunk.tiles) {
+            if (tile >= TILE_COUNT) tile = TILE_EMPTY;
+        }
+    }
+
+    if (data) UnloadFileData(data);
+    return ok;
+}
+
+float Level::Noise(float x, float y, unsigned int salt) const {
+    // Value noise с билинейной интерполяцией
+    int x0 = (int)std::floor(x);
+    int y0 = (int)std::floor(y);
+    float fx = x - x0;
+    float fy = y - y0;
+    fx = fx * fx * (3 - 2 * fx);
+    fy = fy * fy * (3 - 2 * fy);
+
+    unsigned int s = seed ^ salt;
+    float v00 = (HashCoords(x0, y0, s) & 0xffff) / 65535.0f;
+    float v10 = (HashCoords(x0 + 1, y0, s) & 0xffff) / 65535.0f;
+    float v01 = (HashCoords(x0, y0 + 1, s) & 0xffff) / 65535.0f;
+    float v11 = (HashCoords(x0 + 1, y0 + 1, s) & 0xffff) / 65535.0f;
+
+    float top = v00 + (v10 - v00) * fx;
+    float bottom = v01 + (v11 - v01) * fx;
+    return top + (bottom - top) * fy;
+}
+
+void Level::GenerateChunk(LevelChunk& chunk) const {
+    Vector2 center = { worldSize.x / 2, worldSize.y / 2 };
+
+    for (int ty = 0; ty < LEVEL_CHUNK_TILES; ty++) {
+        for (int tx = 0; tx < LEVEL_CHUNK_TILES; tx++) {
+            int worldTileX = chunk.chunkX * LEVEL_CHUNK_TILES + tx;
+            int worldTileY = chunk.chunkY * LEVEL_CHUNK_TILES + ty;
+
+            float rock = Noise(worldTileX / 8.0f, worldTileY / 8.0f, 0x51u);
+            float water = Noise(worldTileX / 12.0f, worldTileY / 12.0f, 0xa7u);
+            float dirt = Noise(worldTileX / 5.0f, worldTileY / 5.0f, 0x3cu);
+
+            unsigned char tile = TILE_EMPTY;
+            if (water > 0.82f) tile = TILE_WATER;
+            else if (rock > 0.8f) tile = TILE_ROCK;
+            else if (dirt > 0.7f) tile = TILE_DIRT;
+
+            // Игрок стартует в центре карты, там препятствий быть не должно
+            float px = (worldTileX + 0.5f) * LEVEL_TILE_SIZE - center.x;
+            float py = (worldTileY + 0.5f) * LEVEL_TILE_SIZE - center.y;
+            if (TILE_SOLID[tile] && px * px + py * py < LEVEL_SPAWN_CLEARING * LEVEL_SPAWN_CLEARING) {
+                tile = TILE_DIRT;
+            }
+
+            chunk.tiles[ty * LEVEL_CHUNK_TILES + tx] = tile;
+        }
+    }
+}
+
+void Level::BuildCollision() {
+    tilesX = (int)std::ceil(worldSize.x / LEVEL_TILE_SIZE);
+    tilesY = (int)std::ceil(worldSize.y / LEVEL_TILE_SIZE);
+    collision.assign(((size_t)tilesX * tilesY + 7) / 8, 0);
+
+    // Тайлы проходят через временный чанк тем же путем, что и при стриминге:
+    // файл с диска или генерация по сиду, поэтому коллизия совпадает с картинкой
+    LevelChunk chunk;
+    for (int chunkY = 0; IsChunkInWorld(0, chunkY); chunkY++) {
+        for (int chunkX = 0; IsChunkInWorld(chunkX, chunkY); chunkX++) {
+            chunk.chunkX = chunkX;
+            chunk.chunkY = chunkY;
+            if (!LoadChunkFromDisk(chunk)) {
+                GenerateChunk(chunk);
+            }
+
+            for (int ty = 0; ty < LEVEL_CHUNK_TILES; ty++) {
+                int worldTileY = chunkY * LEVEL_CHUNK_TILES + ty;
+                if (worldTileY >= tilesY) break;
+
+                for (int tx = 0; tx < LEVEL_CHUNK_TILES; tx++) {
+                    int worldTileX = chunkX * LEVEL_CHUNK_TILES + tx;
+                    if (worldTileX >= tilesX) break;
+                    if (!TILE_SOLID[chunk.tiles[ty * LEVEL_CHUNK_TILES + tx]]) continue;
+
+                    size_t index = (size_t)worldTileY * tilesX + worldTileX;
+                    collision[index >> 3] |= (unsigned char)(1 << (index & 7));
+                }
+            }
+        }
+    }
+}
+
+void Level::RenderChunk(LevelChunk& chunk) const {
+    if (!chunk.hasTexture) {
+        chunk.texture = LoadRenderTexture(LEVEL_CHUNK_TEXTURE_SIZE, LEVEL_CHUNK_TEXTURE_SIZE);
+        chunk.hasTexture = chunk.texture.id != 0;
+        if (!chunk.hasTexture) return;
+    }
+
+    float tilePixels = (float)LEVEL_CHUNK_TEXTURE_SIZE / LEVEL_CHUNK_TILES;
+
+    BeginTextureMode(chunk.texture);
+    ClearBackground(BLANK);
+    for (int ty = 0; ty < LEVEL_CHUNK_TILES; ty++) {
+        for (int tx = 0; tx < LEVEL_CHUNK_TILES; tx++) {
+            unsigned char tile = chunk.tiles[ty * LEVEL_CHUNK_TILES + tx];
+            if (tile == TILE_EMPTY) continue;
+
+            DrawRectangleRec({ tx * tilePixels, ty * tilePixels, tilePixels, tilePixels }, TILE_COLORS[tile]);
+        }
+    }
+    EndTextureMode();
+}
+
+void Level::Draw(Vector2 cameraOffset) const {
+    int minX = (int)std::floor(cameraOffset.x / LEVEL_CHUNK_SIZE);
+    int minY = (int)std::floor(cameraOffset.y / LEVEL_CHUNK_SIZE);
+    int maxX = (int)std::floor((cameraOffset.x + SCREEN_WIDTH - 1) / LEVEL_CHUNK_SIZE);
+    int maxY = (int)std::floor((cameraOffset.y + SCREEN_HEIGHT - 1) / LEVEL_CHUNK_SIZE);
+
+    // Текстуры рендер-таргетов перевернуты по Y
+    Rectangle source = { 0, 0, (float)LEVEL_CHUNK_TEXTURE_SIZE, -(float)LEVEL_CHUNK_TEXTURE_SIZE };
+
+    for (int cy = minY; cy <= maxY; cy++) {
+        for (int cx = minX; cx <= maxX; cx++) {
+            const LevelChunk* chunk = FindChunk(cx, cy);
+            if (!chunk || !chunk->hasTexture) continue;
+
+            Rectangle dest = {
+                cx * LEVEL_CHUNK_SIZE - cameraOffset.x,
+                cy * LEVEL_CHUNK_SIZE - cameraOffset.y,
+                LEVEL_CHUNK_SIZE, LEVEL_CHUNK_SIZE
+            };
+            DrawTexturePro(chunk->texture.texture, source, dest, { 0, 0 }, 0, WHITE);
+        }
+    }
+}
+
+bool Level::IsSolid(Vector2 worldPos) const {
+    if (worldPos.x < 0 || worldPos.y < 0 || worldPos.x >= worldSize.x || worldPos.y >= worldSize.y) {
+        return true;
+    }
+
+    int tileX = std::min(tilesX - 1, (int)(worldPos.x / LEVEL_TILE_SIZE));
+    int tileY = std::min(tilesY - 1, (int)(worldPos.y / LEVEL_TILE_SIZE));
+    size_t index = (size_t)tileY * tilesX + tileX;
+    return (collision[index >> 3] >> (index & 7)) & 1;
+}
+
+bool Level::ApplyObstacles(FlowField& flowField) {
+    if (appliedVersion == collisionVersion) return false;
+    appliedVersion = collisionVersion;
+
+    // Клетка поля заблокирована, если тайл в ее центре твердый
+    float cellSize = flowField.GetCellSize();
+    for (int cy = 0; cy < flowField.GetHeight(); cy++) {
+        for (int cx = 0; cx < flowField.GetWidth(); cx++) {
+            Vector2 center = { (cx + 0.5f) * cellSize, (cy + 0.5f) * cellSize };
+            bool inWorld = center.x < worldSize.x && center.y < worldSize.y;
+            flowField.SetBlocked(cx, cy, inWorld && IsSolid(center));
+        }
+    }
+    return true;
+}
@@ -0,0 +1,91 @@
+﻿#pragma once
+#include "raylib.h"
+#include <vector>
+#include <unordered_map>
+
+class FlowField;
+
+// Параметры чанков
+const int LEVEL_CHUNK_TILES = 32;
+const int LEVEL_TILE_SIZE = 32;
+const float LEVEL_CHUNK_SIZE = (float)(LEVEL_CHUNK_TILES * LEVEL_TILE_SIZE);
+const int LEVEL_CHUNK_TEXTURE_SIZE = 512;   // Чанк пререндерится в половинном разрешении
+const int MAX_RESIDENT_CHUNKS = 16;         // LRU-бюджет чанков с текстурами
+const int MAX_CHUNK_PREFETCH_PER_FRAME = 1; // Чанки вокруг экрана догружаются по одному
+const float LEVEL_SPAWN_CLEARING = 400.0f;  // Свободная зона вокруг центра карты
+
+enum TileType : unsigned char {
+    TILE_EMPTY = 0, // Прозрачный, под ним виден фон
+    TILE_DIRT,
+    TILE_ROCK,
+    TILE_WATER,
+    TILE_COUNT
+};
+
+// Один чанк: слой тайлов и закешированная текстура
+struct LevelChunk {
+    int chunkX = 0;
+    int chunkY = 0;
+    unsigned char tiles[LEVEL_CHUNK_TILES * LEVEL_CHUNK_TILES] = {};
+    RenderTexture2D texture = {};
+    bool hasTexture = false;
+    unsigned long long lastUsedFrame = 0;
+};
+
+// Тайловая карта из чанков фиксированного размера.
+// Коллизия всей карты строится в Init и хранится битами на тайл (~3 КБ для карты 5000x5000),
+// поэтому не зависит от камеры. Чанки с тайлами и текстурами грузятся с диска
+// (levels/chunk_X_Y.bin) или генерируются по сиду вокруг камеры и выгружаются по LRU.
+class Level {
+public:
+    Level() : worldSize({ 0, 0 }), seed(0), frameCounter(0), tilesX(0), tilesY(0), collisionVersion(0), appliedVersion(0), rendering(true) {}
+    ~Level() { Unload(); }
+
+    void Init(Vector2 newWorldSize, unsigned int newSeed);
+    void Unload();
+
+    // Без отрисовки чанки не получают текстур: только тайлы и коллизия (сервер без окна)
+    void SetRendering(bool enabled) { rendering = enabled; }
+
+    // Подгружает видимые чанки, догружает соседние и выгружает лишние
+    void Update(Vector2 cameraOffset);
+
+    // Рисует видимые чанки: не больше четырех блитов при чанке размером с экран
+    void Draw(Vector2 cameraOffset) const;
+
+    // Коллизия по всей карте независимо от загруженных чанков; за пределами карты всегда твердо
+    bool IsSolid(Vector2 worldPos) const;
+
+    // Переносит препятствия карты в поле потоков.
+    // Работает только после смены карты; возвращает true при изменении.
+    bool ApplyObstacles(FlowField& flowField);
+
+    int GetResidentChunkCount() const { return (int)chunks.size(); }
+
+private:
+    static long long ChunkKey(int chunkX, int chunkY) {
+        return ((long long)chunkX << 32) ^ (unsigned int)chunkY;
+    }
+
+    bool IsChunkInWorld(int chunkX, int chunkY) const;
+    LevelChunk* FindChunk(int chunkX, int chunkY);
+    const LevelChunk* FindChunk(int chunkX, int chunkY) const;
+    LevelChunk& LoadChunk(int chunkX, int chunkY);
+    bool LoadChunkFromDisk(LevelChunk& chunk) const;
+    void GenerateChunk(LevelChunk& chunk) const;
+    void BuildCollision();
+    void RenderChunk(LevelChunk& chunk) const;
+    void EvictChunks(int minVisibleX, int minVisibleY, int maxVisibleX, int maxVisibleY);
+    float Noise(float x, float y, unsigned int salt) const;
+
+    Vector2 worldSize;
+    unsigned int seed;
+    unsigned long long frameCounter;
+    int tilesX;
+    int tilesY;
+    unsigned int collisionVersion;
+    unsigned int appliedVersion;
+    bool rendering;
+    std::vector<unsigned char> collision; // Бит на тайл всей карты, строка за строкой
+    std::unordered_map<long long, LevelChunk> chunks;
+};
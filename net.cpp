@@ -0,0 +1,555 @@
+﻿#include "net.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+// Запись и чтение: целые little-endian, переменная длина для id и разностей
+
+static void WriteU8(std::vector<unsigned char>& out, unsigned int value) {
+    out.push_back((unsigned char)value);
+}
+
+static void WriteU16(std::vector<unsigned char>& out, unsigned int value) {
+    out.push_back((unsigned char)value);
+    out.push_back((unsigned char)(value >> 8));
+}
+
+static void WriteU32(std::vector<unsigned char>& out, unsigned int value) {
+    for (int i = 0; i < 4; i++) out.push_back((unsigned char)(value >> (i * 8)));
+}
+
+static void PatchU32(std::vector<unsigned char>& out, size_t offset, unsigned int value) {
+    for (int i = 0; i < 4; i++) out[offset + i] = (unsigned char)(value >> (i * 8));
+}
+
+static void WriteVarint(std::vector<unsigned char>& out, unsigned int value) {
+    while (value >= 0x80) {
+        out.push_back((unsigned char)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((unsigned char)value);
+}
+
+static void WriteSignedVarint(std::vector<unsigned char>& out, int value) {
+    // zigzag: маленькие по модулю отрицательные тоже занимают один байт
+    WriteVarint(out, ((unsigned int)value << 1) ^ (unsigned int)(value >> 31));
+}
+
+struct NetReader {
+    const unsigned char* data;
+    int size;
+    int offset;
+    bool failed;
+
+    NetReader(const unsigned char* newData, int newSize) : data(newData), size(newSize), offset(0), failed(false) {}
+
+    bool Has(int count) {
+        if (offset + count > size) failed = true;
+        return !failed;
+    }
+
+    unsigned int U8() {
+        if (!Has(1)) return 0;
+        return data[offset++];
+    }
+
+    unsigned int U16() {
+        if (!Has(2)) return 0;
+        unsigned int value = data[offset] | (data[offset + 1] << 8);
+        offset += 2;
+        return value;
+    }
+
+    unsigned int U32() {
+        if (!Has(4)) return 0;
+        unsigned int value = 0;
+        for (int i = 0; i < 4; i++) value |= (unsigned int)data[offset + i] << (i * 8);
+        offset += 4;
+        return value;
+    }
+
+    unsigned int Varint() {
+        unsigned int value = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            if (!Has(1)) return 0;
+            unsigned char byte = data[offset++];
+            value |= (unsigned int)(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        failed = true;
+        return 0;
+    }
+
+    int SignedVarint() {
+        unsigned int value = Varint();
+        return (int)(value >> 1) ^ -(int)(value & 1);
+    }
+};
+
+// Маска полей изменившейся сущности
+enum NetFieldMask {
+    NET_FIELD_NEW = 1,       // Сущности нет в базе: все поля целиком
+    NET_FIELD_POSITION = 2,
+    NET_FIELD_FLAGS = 4,
+    NET_FIELD_EXTRA = 8
+};
+
+unsigned short QuantizePosition(float value) {
+    float scaled = value * NET_POSITION_SCALE + 0.5f;
+    return (unsigned short)std::max(0.0f, std::min(65535.0f, scaled));
+}
+
+float DequantizePosition(unsigned short value) {
+    return value / NET_POSITION_SCALE;
+}
+
+unsigned int ChecksumSnapshot(const NetSnapshot& snapshot) {
+    // FNV-1a по квантованному состоянию: клиент сверяет с ней результат декодирования
+    unsigned int hash = 2166136261u;
+    auto mix = [&hash](unsigned int value) {
+        for (int i = 0; i < 4; i++) {
+            hash ^= (value >> (i * 8)) & 0xff;
+            hash *= 16777619u;
+        }
+    };
+
+    const NetPlayerState& player = snapshot.player;
+    mix(snapshot.levelSeed);
+    mix(player.x | (player.y << 16));
+    mix((unsigned short)player.health | ((unsigned short)player.maxHealth << 16));
+    mix(player.gold);
+    mix(player.kills);
+    mix(player.gameOver);
+    for (const auto& entity : snapshot.entities) {
+        mix(entity.id);
+        mix(entity.x | (entity.y << 16));
+        mix(entity.kind | (entity.flags << 8) | (entity.extra << 16));
+    }
+    return hash;
+}
+
+static void WriteEntityChange(std::vector<unsigned char>& out, const NetEntityState* before, const NetEntityState& after,
+    unsigned int& lastId) {
+    unsigned int mask = 0;
+    if (!before) {
+        mask = NET_FIELD_NEW;
+    }
+    else {
+        if (before->x != after.x || before->y != after.y) mask |= NET_FIELD_POSITION;
+        if (before->flags != after.flags) mask |= NET_FIELD_FLAGS;
+        if (before->extra != after.extra) mask |= NET_FIELD_EXTRA;
+        if (mask == 0) return;
+    }
+
+    WriteVarint(out, after.id - lastId);
+    lastId = after.id;
+    WriteU8(out, mask);
+
+    if (mask & NET_FIELD_NEW) {
+        WriteU8(out, after.kind);
+        WriteU16(out, after.x);
+        WriteU16(out, after.y);
+        WriteU8(out, after.flags);
+        WriteU8(out, after.extra);
+        return;
+    }
+    if (mask & NET_FIELD_POSITION) {
+        WriteSignedVarint(out, (int)after.x - (int)before->x);
+        WriteSignedVarint(out, (int)after.y - (int)before->y);
+    }
+    if (mask & NET_FIELD_FLAGS) WriteU8(out, after.flags);
+    if (mask & NET_FIELD_EXTRA) WriteU8(out, after.extra);
+}
+
+void EncodeSnapshot(const NetSnapshot* base, const NetSnapshot& current, std::vector<unsigned char>& out) {
+    out.clear();
+    WriteU32(out, current.tick);
+    WriteU32(out, base ? base->tick : NET_NO_BASE);
+    WriteU32(out, ChecksumSnapshot(current));
+    WriteU32(out, current.levelSeed);
+
+    const NetPlayerState& player = current.player;
+    WriteU16(out, player.x);
+    WriteU16(out, player.y);
+    WriteU16(out, (unsigned short)player.health);
+    WriteU16(out, (unsigned short)player.maxHealth);
+    WriteU32(out, player.gold);
+    WriteU32(out, player.kills);
+    WriteU8(out, player.gameOver);
+
+    static const std::vector<NetEntityState> empty;
+    const std::vector<NetEntityState>& before = base ? base->entities : empty;
+    const std::vector<NetEntityState>& after = current.entities;
+
+    // Оба списка отсортированы по id, поэтому разница находится одним слиянием.
+    // Сначала удаленные (размер заранее неизвестен - пишется на место заглушки)
+    size_t countOffset = out.size();
+    WriteU32(out, 0);
+    unsigned int removed = 0;
+    unsigned int lastId = 0;
+    size_t j = 0;
+    for (size_t i = 0; i < before.size(); i++) {
+        while (j < after.size() && after[j].id < before[i].id) j++;
+        if (j < after.size() && after[j].id == before[i].id) continue;
+        WriteVarint(out, before[i].id - lastId);
+        lastId = before[i].id;
+        removed++;
+    }
+    PatchU32(out, countOffset, removed);
+
+    countOffset = out.size();
+    WriteU32(out, 0);
+    unsigned int changed = 0;
+    lastId = 0;
+    size_t i = 0;
+    for (const auto& entity : after) {
+        while (i < before.size() && before[i].id < entity.id) i++;
+        const NetEntityState* previous = (i < before.size() && before[i].id == entity.id) ? &before[i] : nullptr;
+        size_t sizeBefore = out.size();
+        WriteEntityChange(out, previous, entity, lastId);
+        if (out.size() != sizeBefore) changed++;
+    }
+    PatchU32(out, countOffset, changed);
+}
+
+bool PeekSnapshotBase(const unsigned char* data, int size, unsigned int& tick, unsigned int& baseTick) {
+    NetReader reader(data, size);
+    tick = reader.U32();
+    baseTick = reader.U32();
+    return !reader.failed;
+}
+
+bool DecodeSnapshot(const unsigned char* data, int size, const NetSnapshot* base, NetSnapshot& out) {
+    NetReader reader(data, size);
+    out.tick = reader.U32();
+    unsigned int baseTick = reader.U32();
+    unsigned int checksum = reader.U32();
+    out.levelSeed = reader.U32();
+
+    if (baseTick != NET_NO_BASE && (!base || base->tick != baseTick)) return false;
+    if (baseTick == NET_NO_BASE) base = nullptr;
+
+    NetPlayerState& player = out.player;
+    player.x = (unsigned short)reader.U16();
+    player.y = (unsigned short)reader.U16();
+    player.health = (short)reader.U16();
+    player.maxHealth = (short)reader.U16();
+    player.gold = (int)reader.U32();
+    player.kills = (int)reader.U32();
+    player.gameOver = reader.U8() != 0;
+
+    // Удаленные id, тоже по возрастанию
+    unsigned int removedCount = reader.U32();
+    if (reader.failed || removedCount > (unsigned int)size) return false;
+    std::vector<unsigned int> removed(removedCount);
+    unsigned int lastId = 0;
+    for (unsigned int r = 0; r < removedCount; r++) {
+        lastId += reader.Varint();
+        removed[r] = lastId;
+    }
+
+    unsigned int changedCount = reader.U32();
+    if (reader.failed || changedCount > (unsigned int)size) return false;
+
+    // Слияние базы (без удаленных) с изменениями, результат снова по возрастанию id
+    static const std::vector<NetEntityState> empty;
+    const std::vector<NetEntityState>& before = base ? base->entities : empty;
+    out.entities.clear();
+    out.entities.reserve(before.size() + changedCount);
+
+    size_t b = 0;
+    size_t r = 0;
+    lastId = 0;
+    auto copyBaseUntil = [&](unsigned int id, bool inclusive) {
+        while (b < before.size() && (before[b].id < id || (inclusive && before[b].id == id))) {
+            while (r < removed.size() && removed[r] < before[b].id) r++;
+            bool isRemoved = r < removed.size() && removed[r] == before[b].id;
+            if (!isRemoved) out.entities.push_back(before[b]);
+            b++;
+        }
+    };
+
+    for (unsigned int c = 0; c < changedCount && !reader.failed; c++) {
+        unsigned int id = lastId + reader.Varint();
+        lastId = id;
+        unsigned int mask = reader.U8();
+
+        copyBaseUntil(id, false);
+
+        NetEntityState entity;
+        if (mask & NET_FIELD_NEW) {
+            entity.id = id;
+            entity.kind = (unsigned char)reader.U8();
+            entity.x = (unsigned short)reader.U16();
+            entity.y = (unsigned short)reader.U16();
+            entity.flags = (unsigned char)reader.U8();
+            entity.extra = (unsigned char)reader.U8();
+            if (b < before.size() && before[b].id == id) b++;
+        }
+        else {
+            if (b >= before.size() || before[b].id != id) return false;
+            entity = before[b++];
+            if (mask & NET_FIELD_POSITION) {
+                entity.x = (unsigned short)(entity.x + reader.SignedVarint());
+                entity.y = (unsigned short)(entity.y + reader.SignedVarint());
+            }
+            if (mask & NET_FIELD_FLAGS) entity.flags = (unsigned char)reader.U8();
+            if (mask & NET_FIELD_EXTRA) entity.extra = (unsigned char)reader.U8();
+        }
+        out.entities.push_back(entity);
+    }
+    copyBaseUntil(NET_NO_BASE, true);
+
+    if (reader.failed) return false;
+    return ChecksumSnapshot(out) == checksum;
+}
+
+static double NowSeconds() {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+// ---------------------------------------------------------------------------
+// Сервер
+
+bool NetServer::Start(unsigned short port) {
+    clients.clear();
+    reportTime = 0;
+    return socket.Open(port);
+}
+
+void NetServer::Stop() {
+    socket.Close();
+    clients.clear();
+}
+
+void NetServer::Receive(double now) {
+    ticks++;
+
+    unsigned char buffer[NET_MAX_PACKET_SIZE];
+    NetAddress from;
+    int size;
+    while ((size = socket.Receive(buffer, sizeof(buffer), from)) >= 0) {
+        NetReader reader(buffer, size);
+        if (reader.U8() != NET_PACKET_CLIENT_UPDATE) continue;
+
+        unsigned int ackedTick = reader.U32();
+        Rectangle view;
+        view.x = (float)(int)reader.U32();
+        view.y = (float)(int)reader.U32();
+        view.width = (float)reader.U16();
+        view.height = (float)reader.U16();
+        unsigned char input = (unsigned char)reader.U8();
+        if (reader.failed) continue;
+
+        auto it = std::find_if(clients.begin(), clients.end(), [&from](const Client& c) { return c.address == from; });
+        if (it == clients.end()) {
+            if ((int)clients.size() >= NET_MAX_CLIENTS) continue;
+            clients.emplace_back();
+            it = clients.end() - 1;
+            it->address = from;
+            TraceLog(LOG_INFO, "NET: client %u.%u.%u.%u:%u connected", from.ip >> 24, (from.ip >> 16) & 0xff,
+                (from.ip >> 8) & 0xff, from.ip & 0xff, from.port);
+        }
+
+        Client& client = *it;
+        client.lastHeard = now;
+        client.view = view;
+        client.input = input;
+
+        // Подтверждения могут прийти не по порядку - база только продвигается вперед.
+        // NET_NO_BASE - клиент потерял базу и просит полный снапшот
+        if (ackedTick == NET_NO_BASE || client.ackedTick == NET_NO_BASE || (int)(ackedTick - client.ackedTick) > 0) {
+            client.ackedTick = ackedTick;
+        }
+    }
+
+    clients.erase(std::remove_if(clients.begin(), clients.end(),
+        [now](const Client& c) { return now - c.lastHeard > NET_CLIENT_TIMEOUT; }), clients.end());
+}
+
+void NetServer::Broadcast(const NetSnapshot& world, double gatherSeconds) {
+    worldEntities = (int)world.entities.size();
+    if (clients.empty()) return;
+
+    double start = NowSeconds();
+    for (auto& client : clients) {
+        int slot = world.tick % NET_HISTORY_SIZE;
+
+        // База - последний подтвержденный снапшот, если он еще в кольце и не будет перезаписан
+        const NetSnapshot* base = nullptr;
+        if (client.ackedTick != NET_NO_BASE) {
+            const NetSnapshot& candidate = client.history[client.ackedTick % NET_HISTORY_SIZE];
+            if (candidate.tick == client.ackedTick && (int)(client.ackedTick % NET_HISTORY_SIZE) != slot) {
+                base = &candidate;
+            }
+        }
+
+        NetSnapshot& sent = client.history[slot];
+        sent.tick = world.tick;
+        sent.levelSeed = world.levelSeed;
+        sent.player = world.player;
+        sent.entities.clear();
+
+        // Область видимости в квантованных координатах: отсечение без обратного перевода
+        float minX = (client.view.x - NET_AOI_MARGIN) * NET_POSITION_SCALE;
+        float minY = (client.view.y - NET_AOI_MARGIN) * NET_POSITION_SCALE;
+        float maxX = (client.view.x + client.view.width + NET_AOI_MARGIN) * NET_POSITION_SCALE;
+        float maxY = (client.view.y + client.view.height + NET_AOI_MARGIN) * NET_POSITION_SCALE;
+        for (const auto& entity : world.entities) {
+            if (entity.x < minX || entity.x > maxX || entity.y < minY || entity.y > maxY) continue;
+            sent.entities.push_back(entity);
+        }
+        sentEntities += sent.entities.size();
+
+        EncodeSnapshot(base, sent, payload);
+        SendFragments(client.address, world.tick, payload);
+    }
+
+    serializeSeconds += gatherSeconds + (NowSeconds() - start);
+    snapshotsSent++;
+}
+
+void NetServer::SendFragments(const NetAddress& to, unsigned int tick, const std::vector<unsigned char>& data) {
+    const int chunk = NET_MAX_PACKET_SIZE - NET_FRAGMENT_HEADER_SIZE;
+    int count = std::max(1, ((int)data.size() + chunk - 1) / chunk);
+    if (count > 0xffff) return;
+
+    for (int index = 0; index < count; index++) {
+        int offset = index * chunk;
+        int length = std::min(chunk, (int)data.size() - offset);
+
+        packet.clear();
+        WriteU8(packet, NET_PACKET_SNAPSHOT);
+        WriteU32(packet, tick);
+        WriteU16(packet, index);
+        WriteU16(packet, count);
+        packet.insert(packet.end(), data.begin() + offset, data.begin() + offset + length);
+
+        socket.Send(to, packet.data(), (int)packet.size());
+        bytesSent += packet.size();
+        packetsSent++;
+    }
+}
+
+unsigned char NetServer::GetInput() const {
+    return clients.empty() ? 0 : clients[0].input;
+}
+
+bool NetServer::TakeReport(double now, NetServerStats& stats) {
+    if (reportTime == 0) reportTime = now;
+    if (now - reportTime < NET_REPORT_INTERVAL || ticks == 0) return false;
+
+    stats.clients = (int)clients.size();
+    stats.worldEntities = worldEntities;
+    stats.sentEntities = snapshotsSent > 0 && !clients.empty() ? (int)(sentEntities / snapshotsSent / clients.size()) : 0;
+    stats.bytesPerTick = (double)bytesSent / ticks;
+    stats.packetsPerTick = (double)packetsSent / ticks;
+    stats.serializeMs = snapshotsSent > 0 ? serializeSeconds * 1000.0 / snapshotsSent : 0;
+
+    bytesSent = 0;
+    packetsSent = 0;
+    serializeSeconds = 0;
+    sentEntities = 0;
+    snapshotsSent = 0;
+    ticks = 0;
+    reportTime = now;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Клиент
+
+bool NetClient::Connect(const NetAddress& serverAddress) {
+    server = serverAddress;
+    latestTick = NET_NO_BASE;
+    ackedTick = NET_NO_BASE;
+    assemblyTick = NET_NO_BASE;
+    return socket.Open(0);
+}
+
+void NetClient::Close() {
+    socket.Close();
+}
+
+bool NetClient::Receive() {
+    bool received = false;
+    unsigned char buffer[NET_MAX_PACKET_SIZE];
+    const int chunk = NET_MAX_PACKET_SIZE - NET_FRAGMENT_HEADER_SIZE;
+    NetAddress from;
+    int size;
+    while ((size = socket.Receive(buffer, sizeof(buffer), from)) >= 0) {
+        if (!(from == server)) continue;
+
+        NetReader reader(buffer, size);
+        if (reader.U8() != NET_PACKET_SNAPSHOT) continue;
+        unsigned int tick = reader.U32();
+        int index = (int)reader.U16();
+        int count = (int)reader.U16();
+        if (reader.failed || count == 0 || index >= count) continue;
+
+        // Фрагменты снапшота старше уже собранного не нужны
+        if (latestTick != NET_NO_BASE && (int)(tick - latestTick) <= 0) continue;
+
+        if (tick != assemblyTick) {
+            if (assemblyTick != NET_NO_BASE && (int)(tick - assemblyTick) < 0) continue;
+            assemblyTick = tick;
+            assemblyCount = count;
+            assemblyReceived = 0;
+            assemblySize = 0;
+            assembly.resize((size_t)count * chunk);
+            fragmentReceived.assign(count, false);
+        }
+        if (count != assemblyCount || fragmentReceived[index]) continue;
+
+        int length = size - NET_FRAGMENT_HEADER_SIZE;
+        std::memcpy(&assembly[(size_t)index * chunk], buffer + NET_FRAGMENT_HEADER_SIZE, length);
+        fragmentReceived[index] = true;
+        assemblyReceived++;
+        if (index == count - 1) assemblySize = index * chunk + length;
+
+        if (assemblyReceived == assemblyCount) {
+            if (CompleteSnapshot()) received = true;
+            assemblyTick = NET_NO_BASE;
+        }
+    }
+    return received;
+}
+
+bool NetClient::CompleteSnapshot() {
+    unsigned int tick;
+    unsigned int baseTick;
+    if (!PeekSnapshotBase(assembly.data(), assemblySize, tick, baseTick)) return false;
+
+    const NetSnapshot* base = nullptr;
+    if (baseTick != NET_NO_BASE) {
+        const NetSnapshot& candidate = history[baseTick % NET_HISTORY_SIZE];
+        if (candidate.tick == baseTick) base = &candidate;
+    }
+
+    // Декодируем во временный снапшот: слот кольца может оказаться самой базой
+    if (!DecodeSnapshot(assembly.data(), assemblySize, base, decoded)) {
+        snapshotsRejected++;
+        // Без верной базы просим полный снапшот
+        ackedTick = NET_NO_BASE;
+        return false;
+    }
+
+    std::swap(history[tick % NET_HISTORY_SIZE], decoded);
+    latestTick = tick;
+    ackedTick = tick;
+    snapshotsReceived++;
+    return true;
+}
+
+void NetClient::SendUpdate(Rectangle view, unsigned char input) {
+    std::vector<unsigned char> packet;
+    WriteU8(packet, NET_PACKET_CLIENT_UPDATE);
+    WriteU32(packet, ackedTick);
+    WriteU32(packet, (unsigned int)(int)view.x);
+    WriteU32(packet, (unsigned int)(int)view.y);
+    WriteU16(packet, (unsigned int)std::max(0.0f, std::min(65535.0f, view.width)));
+    WriteU16(packet, (unsigned int)std::max(0.0f, std::min(65535.0f, view.height)));
+    WriteU8(packet, input);
+    socket.Send(server, packet.data(), (int)packet.size());
+}
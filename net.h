@@ -0,0 +1,187 @@
+﻿#pragma once
+#include "raylib.h"
+#include "platform.h"
+#include <vector>
+
+const unsigned short NET_DEFAULT_PORT = 27015;
+const int NET_SNAPSHOT_INTERVAL_TICKS = 3;     // 20 снапшотов в секунду при 60 тиках
+const int NET_MAX_PACKET_SIZE = 1200;          // Меньше типичного MTU: без IP-фрагментации
+const int NET_FRAGMENT_HEADER_SIZE = 9;
+const int NET_HISTORY_SIZE = 32;               // Столько отправленных снапшотов может стать базой дельты
+const int NET_MAX_CLIENTS = 16;
+const float NET_POSITION_SCALE = 8.0f;         // Координаты квантуются до 1/8 пикселя
+const float NET_AOI_MARGIN = 150.0f;           // Запас вокруг экрана клиента
+const double NET_CLIENT_TIMEOUT = 5.0;
+const double NET_REPORT_INTERVAL = 5.0;
+const unsigned int NET_NO_BASE = 0xffffffffu;
+
+enum NetPacketType {
+    NET_PACKET_SNAPSHOT = 1,       // Сервер -> клиент, фрагмент снапшота
+    NET_PACKET_CLIENT_UPDATE = 2   // Клиент -> сервер: подтверждение, область видимости, ввод
+};
+
+enum NetEntityKind {
+    NET_ENTITY_ENEMY = 0,
+    NET_ENTITY_PROJECTILE
+};
+
+// Биты состояния: у врагов - наложенные эффекты, у снарядов - стихия
+enum NetEntityFlags {
+    NET_FLAG_ICE = 1,
+    NET_FLAG_FIRE = 2,
+    NET_FLAG_LIGHTNING = 4,
+    NET_FLAG_MARS_WAVE = 8
+};
+
+enum NetInputBits {
+    NET_INPUT_UP = 1,
+    NET_INPUT_DOWN = 2,
+    NET_INPUT_LEFT = 4,
+    NET_INPUT_RIGHT = 8
+};
+
+struct NetEntityState {
+    unsigned int id;
+    unsigned short x;
+    unsigned short y;
+    unsigned char kind;
+    unsigned char flags;
+    unsigned char extra;   // Враг: доля здоровья 0..255, снаряд: размер в пикселях
+};
+
+struct NetPlayerState {
+    unsigned short x = 0;
+    unsigned short y = 0;
+    short health = 0;
+    short maxHealth = 0;
+    int gold = 0;
+    int kills = 0;
+    bool gameOver = false;
+};
+
+struct NetSnapshot {
+    unsigned int tick = 0;
+    unsigned int levelSeed = 0;
+    NetPlayerState player;
+    std::vector<NetEntityState> entities;   // По возрастанию id
+};
+
+unsigned short QuantizePosition(float value);
+float DequantizePosition(unsigned short value);
+unsigned int ChecksumSnapshot(const NetSnapshot& snapshot);
+
+// Кодирует current относительно base (nullptr - полный снапшот). Сущности,
+// которых нет в current, передаются списком удаленных, неизменившиеся не пишутся,
+// у изменившихся - только изменившиеся поля, координаты - разностью.
+void EncodeSnapshot(const NetSnapshot* base, const NetSnapshot& current, std::vector<unsigned char>& out);
+
+// Читает тик и тик базы, чтобы найти базу до декодирования
+bool PeekSnapshotBase(const unsigned char* data, int size, unsigned int& tick, unsigned int& baseTick);
+
+// Возвращает false, если данные повреждены или контрольная сумма не сошлась
+bool DecodeSnapshot(const unsigned char* data, int size, const NetSnapshot* base, NetSnapshot& out);
+
+struct NetServerStats {
+    int clients = 0;
+    int worldEntities = 0;
+    int sentEntities = 0;       // В среднем на клиента после отсечения по области видимости
+    double bytesPerTick = 0;
+    double packetsPerTick = 0;
+    double serializeMs = 0;     // Сбор мира, отсечение и кодирование за снапшот
+};
+
+// Авторитетный сервер: принимает подтверждения и ввод клиентов и рассылает
+// каждому снапшоты его области видимости дельтой от последнего подтвержденного.
+// Отправленные снапшоты хранятся по клиенту в кольце на NET_HISTORY_SIZE штук.
+class NetServer {
+public:
+    NetServer() : bytesSent(0), packetsSent(0), serializeSeconds(0), sentEntities(0), snapshotsSent(0),
+        ticks(0), worldEntities(0), reportTime(0) {}
+
+    bool Start(unsigned short port);
+    void Stop();
+
+    void Receive(double now);
+
+    // world - весь мир по возрастанию id; отсечение по клиентам делается здесь.
+    // gatherSeconds - время сбора world, входит в стоимость сериализации
+    void Broadcast(const NetSnapshot& world, double gatherSeconds);
+
+    // Ввод первого подключившегося клиента - он управляет игроком
+    unsigned char GetInput() const;
+    int GetClientCount() const { return (int)clients.size(); }
+    unsigned short GetPort() const { return socket.GetPort(); }
+
+    // Раз в NET_REPORT_INTERVAL отдает накопленную статистику и сбрасывает ее
+    bool TakeReport(double now, NetServerStats& stats);
+
+private:
+    struct Client {
+        NetAddress address;
+        double lastHeard = 0;
+        unsigned int ackedTick = NET_NO_BASE;
+        Rectangle view = { 0, 0, 0, 0 };
+        unsigned char input = 0;
+        NetSnapshot history[NET_HISTORY_SIZE];
+    };
+
+    void SendFragments(const NetAddress& to, unsigned int tick, const std::vector<unsigned char>& payload);
+
+    UdpSocket socket;
+    std::vector<Client> clients;
+    std::vector<unsigned char> payload;
+    std::vector<unsigned char> packet;
+
+    long long bytesSent;
+    long long packetsSent;
+    double serializeSeconds;
+    long long sentEntities;
+    int snapshotsSent;
+    int ticks;
+    int worldEntities;
+    double reportTime;
+};
+
+// Тонкий клиент: собирает фрагменты, декодирует снапшот относительно своей
+// копии базы и подтверждает последний собранный тик.
+class NetClient {
+public:
+    NetClient() : latestTick(NET_NO_BASE), ackedTick(NET_NO_BASE), assemblyTick(NET_NO_BASE),
+        assemblyCount(0), assemblyReceived(0), assemblySize(0), snapshotsReceived(0), snapshotsRejected(0) {}
+
+    bool Connect(const NetAddress& serverAddress);
+    void Close();
+
+    // Принимает все пришедшие пакеты; true, если собран новый снапшот
+    bool Receive();
+
+    // Подтверждение, область видимости в координатах мира и ввод
+    void SendUpdate(Rectangle view, unsigned char input);
+
+    bool HasSnapshot() const { return latestTick != NET_NO_BASE; }
+    const NetSnapshot& GetLatest() const { return history[latestTick % NET_HISTORY_SIZE]; }
+
+    int GetReceivedCount() const { return snapshotsReceived; }
+    int GetRejectedCount() const { return snapshotsRejected; }
+
+private:
+    bool CompleteSnapshot();
+
+    UdpSocket socket;
+    NetAddress server;
+    NetSnapshot history[NET_HISTORY_SIZE];
+    NetSnapshot decoded;
+    unsigned int latestTick;
+    unsigned int ackedTick;
+
+    // Сборка снапшота из фрагментов; незавершенный снапшот бросается при приходе более нового
+    std::vector<unsigned char> assembly;
+    std::vector<bool> fragmentReceived;
+    unsigned int assemblyTick;
+    int assemblyCount;
+    int assemblyReceived;
+    int assemblySize;
+
+    int snapshotsReceived;
+    int snapshotsRejected;
+};
@@ -4,17 +4,35 @@
 #include <algorithm>
 #include <string>
 #include <random>
-
-// Размеры окна
-const int SCREEN_WIDTH = 1024;
-const int SCREEN_HEIGHT = 1024;
-
-// Константы для баланса игры
-const int MAX_ENEMIES = 70;
-const int PLAYER_MAX_HEALTH = 100;
-const int ENEMY_MAX_HEALTH = 100;
-const int GAME_OVER_TIMER = 5;
-const int MAX_INVENTORY_SLOTS = 6;
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <thread>
+#include <memory>
+#include <unordered_map>
+#include <type_traits>
+#include "globals.h"
+#include "enemy.h"
+#include "world.h"
+#include "components.h"
+#include "level.h"
+#include "render.h"
+#include "assetpack.h"
+#include "audio.h"
+#include "particles.h"
+#include "quality.h"
+#include "pacing.h"
+#include "net.h"
+#include "rewind.h"
+#include "rng.h"
+#include "save.h"
+#include "shop.h"
+#include "economy.h"
+#include "script.h"
+#include "waves.h"
+#include "input.h"
+#include "capture.h"
+#include "projectail.h"
 
 // Структура для кнопок
 struct Button {
@@ -23,27 +41,6 @@ struct Button {
     bool hovered;
 };
 
-// Структура для компаньонов
-struct Companion {
-    int type;           // 1 - melee, 2 - range, 3 - mars, 4 - ice, 5 - fire, 6 - lightning
-    int starLevel;      // Уровень звезды (1-6)
-    float attackTimer;
-    std::string name;
-
-    Companion(int t, int stars) : type(t), starLevel(stars), attackTimer(0) {
-        // Устанавливаем имя в зависимости от типа
-        switch (type) {
-        case 1: name = "Warrior"; break;
-        case 2: name = "Archer"; break;
-        case 3: name = "Mars"; break;
-        case 4: name = "Ice Mage"; break;
-        case 5: name = "Fire Mage"; break;
-        case 6: name = "Lightning Mage"; break;
-        default: name = "Unknown";
-        }
-    }
-};
-
 // Структура для предметов инвентаря
 struct InventoryItem {
     int type = 0;
@@ -52,45 +49,10 @@ struct InventoryItem {
     std::string description = "Empty Slot";
 };
 
-// Структура для врагов
-struct Enemy {
-    Vector2 position;
-    Vector2 velocity = { 0, 0 };
-    bool active;
-    float frozenTimer = 0;
-    float burnTimer = 0;
-    float stunTimer = 0;
-    int health;
-    int maxHealth;
-
-    Enemy(Vector2 pos) : position(pos), active(true), health(ENEMY_MAX_HEALTH), maxHealth(ENEMY_MAX_HEALTH) {}
-};
-
-// Структура для снарядов
-struct Projectile {
-    Vector2 position;
-    Vector2 velocity;
-    bool active;
-    bool isFreezing;
-    bool isBurning;
-    bool isElectrifying;
-    bool isMarsSpear;
-    bool isMarsWave;
-    float size;
-    int damage;
-    int companionType;
-
-    Projectile(Vector2 pos, Vector2 vel, bool freezing = false, bool burning = false,
-        bool electrifying = false, int dmg = 0, bool marsSpear = false,
-        bool marsWave = false, float projectileSize = 20.0f, int compType = 0)
-        : position(pos), velocity(vel), active(true), isFreezing(freezing),
-        isBurning(burning), isElectrifying(electrifying), damage(dmg),
-        isMarsSpear(marsSpear), isMarsWave(marsWave), size(projectileSize), companionType(compType) {}
-};
-
 // Структура для игрока
 struct Player {
     Vector2 position;
+    Vector2 previousPosition;
     Vector2 velocity = { 0, 0 };
     float speed;
     float passiveAttackTimer;
@@ -101,7 +63,7 @@ struct Player {
     int gold;
     int kills;
 
-    Player() : position({ 0, 0 }), speed(120.0f),
+    Player() : position({ 0, 0 }), previousPosition({ 0, 0 }), speed(120.0f),
         passiveAttackTimer(0), freezeCooldown(0), health(PLAYER_MAX_HEALTH), maxHealth(PLAYER_MAX_HEALTH),
         attackCooldown(0), gold(0), kills(0) {}
 };
@@ -110,8 +72,9 @@ struct Player {
 struct GameState {
     Vector2 mapSize;
     Vector2 cameraOffset;
+    Vector2 previousCameraOffset;
 
-    GameState() : mapSize({ 5000.0f, 5000.0f }), cameraOffset({ 0, 0 }) {}
+    GameState() : mapSize({ 5000.0f, 5000.0f }), cameraOffset({ 0, 0 }), previousCameraOffset({ 0, 0 }) {}
 
     void UpdateCamera(Vector2 playerPosition) {
         cameraOffset.x = playerPosition.x - SCREEN_WIDTH / 2;
@@ -131,24 +94,86 @@ struct GameState {
     }
 };
 
-// Структура для предметов магазина
-struct ShopItem {
-    int id = 0;
-    std::string name;
-    std::string description;
-    int goldPrice = 0;
-    int killsPrice = 0;
-    bool available = true;
-    int tier = 1;
+// Нажатия, пришедшие тику из очереди ввода (см. InputState). Бот
+// экономического симулятора заполняет их сам
+struct TickInput {
+    bool confirm = false;
+    bool mergeCompanions = false;
+    bool cycleMinimap = false;
+    bool attack = false;
+    Vector2 aim = { 0, 0 };    // Курсор в момент атаки, экранные координаты
+    bool rewindStep = false;   // Backspace: назад на REWIND_STEP_SECONDS
+    bool rewindHitch = false;  // F9: к тику перед последним долгим кадром
+    bool quickSave = false;    // F5
+    bool quickLoad = false;    // F8
+};
+
+// Снимок забега для перемотки: заголовок со скалярами, затем мир сущностей
+// (World::Serialize) и массив роев. Слоты магазина хранятся без строк -
+// описание восстанавливается по id
+struct ShopSlotRecord {
+    int id;
+    int goldPrice;
+    int killsPrice;
+    int tier;
+    int available;
+};
+
+struct WorldStateHeader {
+    unsigned int simTick;
+    unsigned int levelSeed;
+    unsigned int rngState;
+    unsigned int nextNetId;
+    unsigned int swarmCount;
+    int swarmMemberCount;
+    float swarmMergeTimer;
+    SpawnDirectorState spawnDirector;   // Очередь спавна и заготовленные точки
+
+    Player player;
+    Vector2 cameraOffset;
+    Vector2 previousCameraOffset;
+    int gameOver;
+    float gameOverTimer;
+    float timeSinceLastSpawn;
+    int waveNumber;
+    int runKills;
+    double scriptTime;             // Часы и счетчики планировщика сценариев
+    int scriptKills;
+    int scriptEnemies;
+    WaveScriptState waveScripts;
+
+    // Экономика
+    int randomCompanionPriceGold;
+    int randomCompanionPriceKills;
+    int purchaseCount;
+    float attackCooldownReduction;
+    float movementSpeedBonus;
+    int extraEnemiesPerSpawn;
+    float damageBonus;
+    int pocketHeroUses;
+    int freeRefreshUses;
+    ShopSlotRecord shopSlots[3];
+    float shopSlotRefreshTimer;
+    int manualRefreshCost;
+    int freeRefreshesLeft;
 };
 
-struct ActiveShopItems {
-    ShopItem slot1;
-    ShopItem slot2;
-    ShopItem slot3;
-    float refreshTimer = 0;
-    int manualRefreshCost = 20;
-    int freeRefreshesLeft = 6;
+// Копируются в снимок как есть; компоненты проверяет World::RegisterComponent
+static_assert(std::is_trivially_copyable<Player>::value, "Player must be trivially copyable");
+static_assert(std::is_trivially_copyable<EnemySwarm>::value, "EnemySwarm must be trivially copyable");
+static_assert(std::is_trivially_copyable<SpawnDirectorState>::value, "SpawnDirectorState must be trivially copyable");
+
+// Виджеты HUD, привязанные к значениям игры
+struct HudWidgetIds {
+    int enemies = -1;
+    int health = -1;
+    int healthBar = -1;
+    int gold = -1;
+    int kills = -1;
+    int timer = -1;
+    int cooldownReduction = -1;
+    int speed = -1;
+    int damage = -1;
 };
 
 float Vector2Distance(Vector2 v1, Vector2 v2) {
@@ -161,12 +186,48 @@ class Game {
 private:
     GameState gamestate;
     Player player;
-    std::vector<Enemy> enemies;
-    std::vector<Projectile> projectiles;
+    World world;                          // Враги, снаряды и компаньоны
+    std::vector<Vector2> enemyPositions;  // Позиции врагов для сетки (расталкивание, затем снаряды)
+    std::vector<Entity> enemyEntities;    // Враги в порядке enemyPositions для столкновений снарядов
+    std::vector<int> collisionCandidates;
+    std::vector<std::pair<float, int>> projectileHits;  // Момент попадания за тик и номер врага в сетке
+    ProjectileExpiryQueue projectileExpiries;
     std::vector<InventoryItem> inventory;
-    std::vector<Companion> companions; // Все компаньоны хранятся здесь
+    FlowField flowField;
+    EnemySwarms swarms;
+    SpawnDirector spawnDirector;
+    bool spawnBenchmarkReported;
+
+    TextCache textCache;
+    RetainedHud hud;
+    HudWidgetIds hudIds;
+    Minimap minimap;
+    DynamicResolution resolution;
+    QualityManager quality;
+    FramePacer pacer;
+    TickInput tickInput;
+    InputSampler inputSampler;
+    InputState input;
+    FrameCapture capture;
+    CaptureConfig captureConfig;   // Пустое имя файла - запись выключена
+    bool uiClick;          // Левый клик за кадр (для кнопок интерфейса)
+    Vector2 uiClickPosition;
+    float simAccumulator;
+    float renderAlpha;     // Доля тика, прошедшая с последнего шага симуляции
+    Vector2 renderCamera;  // Интерполированное смещение камеры для отрисовки мира
+    Level level;
+
+    // Волны, фоновый спавн и обновление магазина - сценарии-корутины. Кадры
+    // корутин в снимок не пишутся, вместо них - точки продолжения
+    // (WaveScriptState): после перемотки и загрузки StartWaveScripts
+    // возвращает каждый сценарий в его ожидание в прежнем порядке засыпания
+    ScriptScheduler waveScripts;
+    WavePlan wavePlan;
+    WaveScriptState waveScriptState;
+    int waveNumber;
+    int runKills;          // Убийства за забег; player.kills тратятся в магазине
+    float waveBannerTimer;
 
-    float enemySpawnTimer;
     float gameOverTimer;
     bool gameOver;
     bool inGame;
@@ -181,9 +242,9 @@ private:
     int randomCompanionPriceKills;
     int purchaseCount;
 
+    ShopPricing pricing;
     std::vector<ShopItem> allShopItems;
     ActiveShopItems currentShop;
-    float shopRefreshTimer;
 
     float attackCooldownReduction;
     float movementSpeedBonus;
@@ -192,85 +253,111 @@ private:
     int pocketHeroUses;
     int freeRefreshUses;
 
-    // Текстуры
-    Texture2D inventoryTexture;
-    Texture2D meleeTexture;
-    Texture2D rangeTexture;
-    Texture2D marsTexture;
-    Texture2D iceTexture;
-    Texture2D fireTexture;
-    Texture2D lightningTexture;
-    Texture2D backgroundTexture;
-    bool texturesLoaded;
-    Texture2D menuBackgroundTexture;
-    bool menuBackgroundLoaded;
+    // Спрайты грузятся асинхронно (из пака ассетов или из отдельных PNG),
+    // пока хендл не готов, отрисовка использует запасные прямоугольники
+    AssetLoader assets;
+    SpriteHandle inventorySprite;
+    SpriteHandle meleeSprite;
+    SpriteHandle rangeSprite;
+    SpriteHandle marsSprite;
+    SpriteHandle iceSprite;
+    SpriteHandle fireSprite;
+    SpriteHandle lightningSprite;
+    SpriteHandle backgroundSprite;
+    SpriteHandle menuBackgroundSprite;
+
+    AudioSystem audio;
+    ParticleSystem particles;
+
+    // Сетевой режим: сервер считает мир без окна, клиент только рисует снапшоты
+    bool headless;
+    bool remote;
+    unsigned int levelSeed;
+    unsigned int nextNetId;
+    unsigned char remoteInput;
+    NetServer netServer;
+    NetSnapshot netWorld;
+    std::unique_ptr<NetClient> netClient;
+    std::unordered_map<unsigned int, Vector2> remotePositions;
+    double remoteSnapshotTime;
+
+    // Перемотка: снимок состояния после каждого тика
+    RewindBuffer rewind;
+    unsigned int simTick;
+    unsigned int frameStartTick;
+    unsigned int hitchTick;
+
+    // Все броски симуляции идут через него: состояние входит в снимки и сейвы
+    GameRandom rng;
 
 public:
-    Game() : enemySpawnTimer(0), gameOverTimer(GAME_OVER_TIMER), gameOver(false),
+    explicit Game(bool headlessMode = false) : spawnBenchmarkReported(false),
+        uiClick(false), uiClickPosition({ 0, 0 }), simAccumulator(0), renderAlpha(1.0f), renderCamera({ 0, 0 }),
+        waveNumber(0), runKills(0), waveBannerTimer(0),
+        gameOverTimer(GAME_OVER_TIMER), gameOver(false),
         inGame(false), inSettings(false), musicVolume(0.5f),
         timeSinceLastSpawn(0), choosingWeapon(false), inShop(false),
         randomCompanionPriceGold(300), randomCompanionPriceKills(30),
         purchaseCount(0), attackCooldownReduction(0), movementSpeedBonus(0),
         extraEnemiesPerSpawn(0), damageBonus(0), pocketHeroUses(0), freeRefreshUses(0),
-        texturesLoaded(false), menuBackgroundLoaded(false) {
+        headless(headlessMode), remote(false), levelSeed(0), nextNetId(1), remoteInput(0), remoteSnapshotTime(0),
+        simTick(0), frameStartTick(0), hitchTick(0) {
 
+        RegisterGameComponents(world);
         player.position = { gamestate.mapSize.x / 2, gamestate.mapSize.y / 2 };
+        flowField.Init(gamestate.mapSize, FLOW_FIELD_CELL_SIZE);
+
+        if (headless) {
+            // Без окна нет GL-контекста и аудио: только симуляция и магазин
+            level.SetRendering(false);
+            InitializeInventory();
+            InitializeShopItems();
+            RefreshShop();
+            return;
+        }
+
         LoadTextures();
+        audio.Init();
+        audio.SetMasterVolume(musicVolume);
+        audio.PlayMusic(MUSIC_FILE);
+        particles.Init(PARTICLE_CAPACITY);
+        InitializeHud();
+        minimap.Init(MINIMAP_SIZE, MINIMAP_DENSITY_BINS);
+        resolution.Init(SCREEN_WIDTH, SCREEN_HEIGHT);
+        quality.StartBenchmark();
+        ApplyQuality();
         InitializeInventory();
         InitializeShopItems();
         RefreshShop();
     }
 
     ~Game() {
+        hud.Unload();
+        minimap.Unload();
+        resolution.Unload();
+        level.Unload();
         UnloadTextures();
+        audio.Shutdown();
     }
 
     void LoadTextures() {
-        if (FileExists("inventory.png")) {
-            inventoryTexture = LoadTexture("inventory.png");
-        }
-        if (FileExists("melee.png")) {
-            meleeTexture = LoadTexture("melee.png");
-        }
-        if (FileExists("range.png")) {
-            rangeTexture = LoadTexture("range.png");
-        }
-        if (FileExists("mars.png")) {
-            marsTexture = LoadTexture("mars.png");
-        }
-        if (FileExists("ice.png")) {
-            iceTexture = LoadTexture("ice.png");
-        }
-        if (FileExists("fire.png")) {
-            fireTexture = LoadTexture("fire.png");
-        }
-        if (FileExists("lightning.png")) {
-            lightningTexture = LoadTexture("lightning.png");
-        }
-        if (FileExists("background.png")) {
-            backgroundTexture = LoadTexture("background.png");
-        }
-        if (FileExists("menu_background.png")) {
-            menuBackgroundTexture = LoadTexture("menu_background.png");
-            menuBackgroundLoaded = true;
-        }
-        texturesLoaded = true;
+        inventorySprite = assets.Request("inventory.png");
+        meleeSprite = assets.Request("melee.png");
+        rangeSprite = assets.Request("range.png");
+        marsSprite = assets.Request("mars.png");
+        iceSprite = assets.Request("ice.png");
+        fireSprite = assets.Request("fire.png");
+        lightningSprite = assets.Request("lightning.png");
+        backgroundSprite = assets.Request("background.png");
+        menuBackgroundSprite = assets.Request("menu_background.png");
+
+        // Пак собирается tools/assetpack; без него грузятся PNG по одному
+        int workers = std::max(1, std::min((int)std::thread::hardware_concurrency() - 1, ASSET_LOADER_MAX_WORKERS));
+        assets.Start(ASSET_PACK_FILE, workers);
     }
 
     void UnloadTextures() {
-        if (texturesLoaded) {
-            if (inventoryTexture.id != 0) UnloadTexture(inventoryTexture);
-            if (meleeTexture.id != 0) UnloadTexture(meleeTexture);
-            if (rangeTexture.id != 0) UnloadTexture(rangeTexture);
-            if (marsTexture.id != 0) UnloadTexture(marsTexture);
-            if (iceTexture.id != 0) UnloadTexture(iceTexture);
-            if (fireTexture.id != 0) UnloadTexture(fireTexture);
-            if (lightningTexture.id != 0) UnloadTexture(lightningTexture);
-            if (backgroundTexture.id != 0) UnloadTexture(backgroundTexture);
-            if (menuBackgroundLoaded) {
-                UnloadTexture(menuBackgroundTexture);
-            }
-        }
+        assets.Unload();
     }
 
     // БАЗА ДАННЫХ КОМПАНЬОНОВ
@@ -283,15 +370,18 @@ public:
         int baseDamage;
         int targets;
         std::string ability;
+        float projectileRange;   // Путь снаряда до истечения; 0 - атака без снарядов
+        int expireEffect;        // ProjectileExpireEffect в конце пути
+        float attackRadius;      // Откуда атака достает врагов; 0 - по всей карте
     };
 
     std::vector<CompanionData> companionDatabase = {
-        {1, "Warrior", "Melee fighter with area attacks", RED, 1.1f, 40, 5, "Cleaves multiple enemies"},
-        {2, "Archer", "Ranged attacker with freezing arrows", GREEN, 1.1f, 30, 3, "Freezes enemies on hit"},
-        {3, "Mars", "God of war with wave attacks", ORANGE, 3.0f, 60, 7, "Sends shockwaves in semicircle"},
-        {4, "Ice Mage", "Master of frost and cold", SKYBLUE, 2.0f, 35, 4, "Slows and damages groups"},
-        {5, "Fire Mage", "Wielder of destructive flames", Color{255, 69, 0, 255}, 1.5f, 45, 3, "Burns enemies over time"},
-        {6, "Lightning Mage", "Controller of electric energy", YELLOW, 2.5f, 50, 6, "Chains lightning between enemies"}
+        {1, "Warrior", "Melee fighter with area attacks", RED, 1.1f, 40, 5, "Cleaves multiple enemies", 0.0f, EXPIRE_NONE, 100.0f},
+        {2, "Archer", "Ranged attacker with freezing arrows", GREEN, 1.1f, 30, 3, "Freezes enemies on hit", 450.0f, EXPIRE_NONE, 250.0f},
+        {3, "Mars", "God of war with wave attacks", ORANGE, 3.0f, 60, 7, "Sends shockwaves in semicircle", 400.0f, EXPIRE_NONE, 300.0f},
+        {4, "Ice Mage", "Master of frost and cold", SKYBLUE, 2.0f, 35, 4, "Slows and damages groups", 350.0f, EXPIRE_NONE, 200.0f},
+        {5, "Fire Mage", "Wielder of destructive flames", Color{255, 69, 0, 255}, 1.5f, 45, 3, "Burns enemies over time", 420.0f, EXPIRE_EXPLOSION, 300.0f},
+        {6, "Lightning Mage", "Controller of electric energy", YELLOW, 2.5f, 50, 6, "Chains lightning between enemies", 0.0f, EXPIRE_NONE, 0.0f}
     };
 
     CompanionData GetCompanionData(int type) {
@@ -316,20 +406,21 @@ public:
     }
 
     void InitializeShopItems() {
-        allShopItems.clear();
-        allShopItems.push_back({ 1, "Moon Shard", "-2% Attack Cooldown\nStacks", 400, 0, true, 1 });
-        allShopItems.push_back({ 2, "Boots of Travel", "+3% Movement Speed\nStacks", 400, 0, true, 1 });
-        allShopItems.push_back({ 3, "Doom Heart", "+1 Enemy per Spawn\nStacks", 400, 0, true, 1 });
-        allShopItems.push_back({ 4, "Power Crystal", "+2% Total Damage\nStacks", 400, 0, true, 1 });
-        allShopItems.push_back({ 5, "Pocket Heroes", "Random Companion\nAny star level", 0, 40, true, 2 });
-        allShopItems.push_back({ 6, "Refresh Token", "Free Shop Refresh\n(0-6 uses)", 400, 0, true, 1 });
+        BuildShopItems(pricing, allShopItems);
+    }
+
+    // Цены меняются только между забегами: симулятор экономики подбирает их перед стартом
+    void ConfigurePricing(const ShopPricing& newPricing) {
+        pricing = newPricing;
+        InitializeShopItems();
+        RefreshShop();
     }
 
     void RefreshShop() {
         std::vector<ShopItem> availableItems = allShopItems;
 
         for (int i = 0; i < 3 && !availableItems.empty(); i++) {
-            int randomIndex = GetRandomValue(0, (int)availableItems.size() - 1);
+            int randomIndex = rng.Range(0, (int)availableItems.size() - 1);
 
             if (i == 0) currentShop.slot1 = availableItems[randomIndex];
             else if (i == 1) currentShop.slot2 = availableItems[randomIndex];
@@ -338,14 +429,52 @@ public:
             availableItems.erase(availableItems.begin() + randomIndex);
         }
 
-        currentShop.slot3.killsPrice = 60;
+        currentShop.slot3.killsPrice = pricing.thirdSlotKillsPrice;
         currentShop.slot3.goldPrice = 0;
 
-        currentShop.refreshTimer = 60.0f;
-        currentShop.manualRefreshCost = 20;
+        currentShop.refreshTimer = pricing.refreshInterval;
+        currentShop.manualRefreshCost = pricing.refreshKillsPrice;
         currentShop.freeRefreshesLeft = 6;
     }
 
+    void InitializeHud() {
+        int startY = 20;
+
+        hud.Init(HUD_TEXTURE_WIDTH, HUD_TEXTURE_HEIGHT);
+        hudIds.enemies = hud.AddPair(20, startY, 20, WHITE, "Enemies: ", "/");
+        hudIds.health = hud.AddPair(20, startY + 30, 20, GREEN, "HP: ", "/");
+        hudIds.healthBar = hud.AddBar(120, startY + 35, 150, 10, GREEN, RED);
+        hudIds.gold = hud.AddValue(20, startY + 60, 20, YELLOW, "Gold: ");
+        hudIds.kills = hud.AddValue(20, startY + 90, 20, WHITE, "Kills: ");
+        hudIds.timer = hud.AddValue(20, startY + 120, 20, RED, "Time: ");
+
+        hud.AddLabel(20, startY + 150, 20, WHITE, "RMB: Companion ability");
+        hud.AddLabel(20, startY + 180, 20, WHITE, "F: Merge 3 same-star companions");
+
+        hudIds.cooldownReduction = hud.AddValue(20, startY + 210, 18, BLUE, "CD Reduction: ", "%");
+        hudIds.speed = hud.AddValue(20, startY + 235, 18, BLUE, "Speed: +", "%");
+        hudIds.damage = hud.AddValue(20, startY + 260, 18, BLUE, "Damage: +", "%");
+    }
+
+    // Передает значения в виджеты; текстура HUD перерисуется только при изменениях
+    void UpdateHud() {
+        hud.SetValues(hudIds.enemies, GetEnemyCount(), MAX_ENEMIES);
+        hud.SetValues(hudIds.health, player.health, PLAYER_MAX_HEALTH);
+        hud.SetValues(hudIds.healthBar, player.health, player.maxHealth);
+        hud.SetValue(hudIds.gold, player.gold);
+        hud.SetValue(hudIds.kills, player.kills);
+
+        // В режиме бенчмарка на месте таймера выводится строка режиссера спавна
+        hud.SetVisible(hudIds.timer, !spawnDirector.GetConfig().benchmark && GetEnemyCount() > MAX_ENEMIES);
+        hud.SetValue(hudIds.timer, (int)gameOverTimer);
+
+        hud.SetValue(hudIds.cooldownReduction, (int)(attackCooldownReduction * 100));
+        hud.SetValue(hudIds.speed, (int)(movementSpeedBonus * 100));
+        hud.SetValue(hudIds.damage, (int)(damageBonus * 100));
+
+        hud.Rebuild(textCache);
+    }
+
     void InitializeInventory() {
         inventory.clear();
         int slotWidth = 102;
@@ -376,11 +505,14 @@ public:
         }
 
         // Заполняем слоты компаньонами
-        for (int i = 0; i < companions.size() && i < MAX_INVENTORY_SLOTS; i++) {
-            inventory[i].type = companions[i].type;
-            inventory[i].starLevel = companions[i].starLevel;
-            inventory[i].description = GetCompanionDescription(companions[i].type, companions[i].starLevel);
-        }
+        int slot = 0;
+        world.Each<Companion>([&](Companion& companion) {
+            if (slot >= (int)inventory.size() || slot >= MAX_INVENTORY_SLOTS) return;
+            inventory[slot].type = companion.type;
+            inventory[slot].starLevel = companion.starLevel;
+            inventory[slot].description = GetCompanionDescription(companion.type, companion.starLevel);
+            slot++;
+        });
     }
 
     std::string GetStarString(int level) {
@@ -392,23 +524,43 @@ public:
     }
 
     void Init() {
+        InitRun((unsigned int)GetRandomValue(0, 0x7fffffff));
+    }
+
+    // Забег с заданным сидом уровня и бросков; симулятор экономики
+    // перезапускает так один и тот же мир, не пересоздавая Game
+    void InitRun(unsigned int seed) {
         player.position = { gamestate.mapSize.x / 2, gamestate.mapSize.y / 2 };
+        player.previousPosition = player.position;
+        gamestate.UpdateCamera(player.position);
+        gamestate.previousCameraOffset = gamestate.cameraOffset;
+        simAccumulator = 0;
+        tickInput = TickInput();
+        rewind.Clear();
+        simTick = 0;
+        frameStartTick = 0;
+        hitchTick = 0;
         player.health = player.maxHealth;
         player.gold = 0;
         player.kills = 0;
-        companions.clear();
-        enemies.clear();
-        projectiles.clear();
+        world.Clear();
+        projectileExpiries.Clear();
+        swarms.Clear();
+        spawnDirector.Reset();
+        spawnBenchmarkReported = false;
+        particles.Clear();
         gameOver = false;
         gameOverTimer = GAME_OVER_TIMER;
-        enemySpawnTimer = 0;
         timeSinceLastSpawn = 0;
+        waveNumber = 0;
+        runKills = 0;
+        waveBannerTimer = 0;
         player.attackCooldown = 0;
         choosingWeapon = true;
         inShop = false;
         purchaseCount = 0;
-        randomCompanionPriceGold = 300;
-        randomCompanionPriceKills = 30;
+        randomCompanionPriceGold = GetCompanionGoldPrice(pricing, 0);
+        randomCompanionPriceKills = GetCompanionKillsPrice(pricing, 0);
 
         attackCooldownReduction = 0;
         movementSpeedBonus = 0;
@@ -418,37 +570,278 @@ public:
         freeRefreshUses = 0;
 
         gamestate.UpdateCamera(player.position);
+        levelSeed = seed;
+        level.Init(gamestate.mapSize, levelSeed);
+        rng.Seed(seed * 2654435761u + 1);
+        flowField.ClearBlocked();
         InitializeInventory();
         RefreshShop();
+        StartWaveScripts(GetStartingWaveScripts(wavePlan, pricing.refreshInterval), 0, 0, 0);
     }
 
-    int GetSelectedWeaponType() {
-        if (companions.empty()) return 0;
+    void ConfigureSpawnDirector(const SpawnDirectorConfig& config) {
+        spawnDirector.Configure(config);
+    }
+
+    void ConfigureResolution(const DynamicResolutionConfig& config) {
+        resolution.Configure(config);
+    }
+
+    void ConfigurePacing(PacingMode mode, bool lateInput) {
+        pacer.Configure(mode, lateInput);
+    }
+
+    void ConfigureCapture(const CaptureConfig& config) {
+        captureConfig = config;
+    }
+
+    // seconds == 0 отключает перемотку; память выделяется здесь один раз
+    void ConfigureRewind(float seconds) {
+        rewind.Init((int)(seconds * PACING_SIM_TICK_RATE), seconds > 0 ? REWIND_DEFAULT_BYTES : 0);
+    }
+
+    void CaptureWorldState(std::vector<unsigned char>& out) {
+        WorldStateHeader header = {};
+        header.simTick = simTick;
+        header.levelSeed = levelSeed;
+        header.rngState = rng.GetState();
+        header.nextNetId = nextNetId;
+        header.swarmCount = (unsigned int)swarms.GetSwarms().size();
+        header.swarmMemberCount = swarms.GetMemberCount();
+        header.swarmMergeTimer = swarms.GetMergeTimer();
+        header.spawnDirector = spawnDirector.Snapshot();
+
+        header.player = player;
+        header.cameraOffset = gamestate.cameraOffset;
+        header.previousCameraOffset = gamestate.previousCameraOffset;
+        header.gameOver = gameOver;
+        header.gameOverTimer = gameOverTimer;
+        header.timeSinceLastSpawn = timeSinceLastSpawn;
+        header.waveNumber = waveNumber;
+        header.runKills = runKills;
+        header.scriptTime = waveScripts.GetTime();
+        header.scriptKills = waveScripts.GetKills();
+        header.scriptEnemies = waveScripts.GetEnemies();
+        header.waveScripts = waveScriptState;
+
+        header.randomCompanionPriceGold = randomCompanionPriceGold;
+        header.randomCompanionPriceKills = randomCompanionPriceKills;
+        header.purchaseCount = purchaseCount;
+        header.attackCooldownReduction = attackCooldownReduction;
+        header.movementSpeedBonus = movementSpeedBonus;
+        header.extraEnemiesPerSpawn = extraEnemiesPerSpawn;
+        header.damageBonus = damageBonus;
+        header.pocketHeroUses = pocketHeroUses;
+        header.freeRefreshUses = freeRefreshUses;
+        const ShopItem* slots[3] = { &currentShop.slot1, &currentShop.slot2, &currentShop.slot3 };
+        for (int i = 0; i < 3; i++) {
+            header.shopSlots[i] = { slots[i]->id, slots[i]->goldPrice, slots[i]->killsPrice, slots[i]->tier, slots[i]->available };
+        }
+        header.shopSlotRefreshTimer = currentShop.refreshTimer;
+        header.manualRefreshCost = currentShop.manualRefreshCost;
+        header.freeRefreshesLeft = currentShop.freeRefreshesLeft;
+
+        out.clear();
+        AppendBytes(out, &header, sizeof(header));
+        world.Serialize(out);
+        AppendBytes(out, swarms.GetSwarms().data(), swarms.GetSwarms().size() * sizeof(EnemySwarm));
+    }
+
+    static void AppendBytes(std::vector<unsigned char>& out, const void* data, size_t size) {
+        const unsigned char* bytes = (const unsigned char*)data;
+        out.insert(out.end(), bytes, bytes + size);
+    }
+
+    bool RestoreWorldState(const unsigned char* data, size_t size) {
+        WorldStateHeader header;
+        if (size < sizeof(header)) return false;
+        std::memcpy(&header, data, sizeof(header));
+
+        // Мир читается в отдельное хранилище: при битых данных текущий забег не тронут
+        const unsigned char* p = data + sizeof(header);
+        const unsigned char* end = data + size;
+        World restored;
+        RegisterGameComponents(restored);
+        if (!restored.Deserialize(p, end)) return false;
+        if ((size_t)(end - p) != header.swarmCount * sizeof(EnemySwarm)) return false;
+
+        simTick = header.simTick;
+        if (header.levelSeed != levelSeed) {
+            levelSeed = header.levelSeed;
+            level.Init(gamestate.mapSize, levelSeed);
+            flowField.ClearBlocked();
+        }
+        rng.SetState(header.rngState);
+        nextNetId = header.nextNetId;
+        player = header.player;
+        gamestate.cameraOffset = header.cameraOffset;
+        gamestate.previousCameraOffset = header.previousCameraOffset;
+        gameOver = header.gameOver != 0;
+        gameOverTimer = header.gameOverTimer;
+        timeSinceLastSpawn = header.timeSinceLastSpawn;
+        waveNumber = header.waveNumber;
+        runKills = header.runKills;
+
+        randomCompanionPriceGold = header.randomCompanionPriceGold;
+        randomCompanionPriceKills = header.randomCompanionPriceKills;
+        purchaseCount = header.purchaseCount;
+        attackCooldownReduction = header.attackCooldownReduction;
+        movementSpeedBonus = header.movementSpeedBonus;
+        extraEnemiesPerSpawn = header.extraEnemiesPerSpawn;
+        damageBonus = header.damageBonus;
+        pocketHeroUses = header.pocketHeroUses;
+        freeRefreshUses = header.freeRefreshUses;
+        ShopItem* slots[3] = { &currentShop.slot1, &currentShop.slot2, &currentShop.slot3 };
+        for (int i = 0; i < 3; i++) {
+            const ShopSlotRecord& record = header.shopSlots[i];
+            *slots[i] = ShopItem();
+            for (const auto& item : allShopItems) {
+                if (item.id == record.id) *slots[i] = item;
+            }
+            slots[i]->id = record.id;
+            slots[i]->goldPrice = record.goldPrice;
+            slots[i]->killsPrice = record.killsPrice;
+            slots[i]->tier = record.tier;
+            slots[i]->available = record.available != 0;
+        }
+        currentShop.refreshTimer = header.shopSlotRefreshTimer;
+        currentShop.manualRefreshCost = header.manualRefreshCost;
+        currentShop.freeRefreshesLeft = header.freeRefreshesLeft;
+
+        world = std::move(restored);
+        RebuildProjectileExpiries();
+        swarms.Restore(header.swarmMergeTimer, header.swarmMemberCount, (const EnemySwarm*)p, header.swarmCount);
+        spawnDirector.Restore(header.spawnDirector);
+
+        UpdateInventoryDisplay();
+        particles.Clear();
+        tickInput = TickInput();
+        simAccumulator = 0;
+        waveBannerTimer = 0;
+        StartWaveScripts(header.waveScripts, header.scriptTime, header.scriptKills, header.scriptEnemies);
+        return true;
+    }
+
+    void CaptureRewindFrame() {
+        if (!rewind.IsEnabled()) return;
+        CaptureWorldState(rewind.GetCaptureBuffer());
+        rewind.Capture(simTick);
+    }
+
+    bool RewindTo(unsigned int tick) {
+        std::vector<unsigned char> state;
+        unsigned int restoredTick;
+        if (!rewind.Restore(tick, state, restoredTick)) return false;
+        if (!RestoreWorldState(state.data(), state.size())) return false;
+
+        TraceLog(LOG_INFO, "REWIND: back to tick %u (%d ticks kept, %.1f MB, last capture %.3f ms)",
+            restoredTick, rewind.GetFrameCount(), rewind.GetUsedBytes() / (1024.0 * 1024.0), rewind.GetLastCaptureMs());
+        return true;
+    }
+
+    SaveLayout GetSaveLayout() const {
+        SaveLayout layout = { sizeof(WorldStateHeader), world.GetLayoutHash(), sizeof(EnemySwarm) };
+        return layout;
+    }
+
+    bool SaveRun(const char* fileName) {
+        double startTime = NowSeconds();
+        std::vector<unsigned char> state;
+        CaptureWorldState(state);
+        if (!WriteSaveFile(fileName, GetSaveLayout(), state)) {
+            TraceLog(LOG_WARNING, "SAVE: cannot write %s", fileName);
+            return false;
+        }
+        TraceLog(LOG_INFO, "SAVE: wrote %s (%d entities, %.1f MB) in %.2f ms", fileName,
+            world.Count<Placement>(), state.size() / (1024.0 * 1024.0), (NowSeconds() - startTime) * 1000.0);
+        return true;
+    }
+
+    // Загрузка возможна из меню (флаг --load) и посреди забега; история
+    // перемотки относится к прежнему забегу и сбрасывается
+    bool LoadRun(const char* fileName) {
+        double startTime = NowSeconds();
+        SaveFile save;
+        if (!save.Open(fileName, GetSaveLayout())) {
+            TraceLog(LOG_WARNING, "SAVE: cannot load %s: %s", fileName, save.GetError());
+            return false;
+        }
+
+        if (!inGame) {
+            inGame = true;
+            Init();
+        }
+        if (!RestoreWorldState(save.GetPayload(), save.GetPayloadSize())) {
+            TraceLog(LOG_WARNING, "SAVE: %s does not match its layout", fileName);
+            return false;
+        }
+        choosingWeapon = false;
+        inShop = false;
+        rewind.Clear();
+
+        TraceLog(LOG_INFO, "SAVE: loaded %s (%d entities, tick %u) in %.2f ms", fileName,
+            world.Count<Placement>(), simTick, (NowSeconds() - startTime) * 1000.0);
+        return true;
+    }
+
+    void ApplyQuality() {
+        const QualitySettings& settings = quality.GetSettings();
+        minimap.SetRefreshRate(settings.minimapRefreshRate);
+        particles.SetBudget(settings.particleBudget);
+    }
+
+    std::string GetQualityLabel() const {
+        std::string label = quality.GetSettings().name;
+        return quality.IsAutomatic() ? "AUTO (" + label + ")" : label;
+    }
+
+    // Все враги, включая участников роев
+    int GetEnemyCount() const {
+        return world.Count<EnemyTag>() + swarms.GetMemberCount();
+    }
+
+    int GetProjectileCount() const {
+        return world.Count<ProjectileInfo>();
+    }
+
+    // Первый купленный компаньон задает основную атаку; nullptr, если компаньонов нет
+    Companion* GetMainCompanion() {
+        Companion* main = nullptr;
+        world.Each<Companion>([&main](Companion& companion) {
+            if (!main) main = &companion;
+        });
+        return main;
+    }
+
+    void AddCompanion(int type, int starLevel) {
+        world.Create(Companion{ type, starLevel, 0 });
+    }
 
-        // Возвращаем тип первого компаньона для основной атаки
-        return companions[0].type;
+    int GetSelectedWeaponType() {
+        Companion* main = GetMainCompanion();
+        return main ? main->type : 0;
     }
 
     void UpdateWeaponChoice(Button& meleeButton, Button& rangeButton, Button& magicButton) {
-        Vector2 mousePos = GetMousePosition();
+        Vector2 mousePos = uiClick ? uiClickPosition : GetMousePosition();
 
         meleeButton.hovered = CheckCollisionPointRec(mousePos, meleeButton.bounds);
         rangeButton.hovered = CheckCollisionPointRec(mousePos, rangeButton.bounds);
         magicButton.hovered = CheckCollisionPointRec(mousePos, magicButton.bounds);
 
-        if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+        if (uiClick) {
             if (meleeButton.hovered) {
-                companions.push_back(Companion(1, 1)); // Warrior 1★
+                AddCompanion(1, 1); // Warrior 1★
                 UpdateInventoryDisplay();
                 choosingWeapon = false;
             }
             if (rangeButton.hovered) {
-                companions.push_back(Companion(2, 1)); // Archer 1★
+                AddCompanion(2, 1); // Archer 1★
                 UpdateInventoryDisplay();
                 choosingWeapon = false;
             }
             if (magicButton.hovered) {
-                companions.push_back(Companion(4, 1)); // Ice Mage 1★
+                AddCompanion(4, 1); // Ice Mage 1★
                 UpdateInventoryDisplay();
                 choosingWeapon = false;
             }
@@ -456,13 +849,13 @@ public:
     }
 
     void UpdateShop(Button& randomButton, Button& closeButton, Button& refreshButton) {
-        Vector2 mousePos = GetMousePosition();
+        Vector2 mousePos = uiClick ? uiClickPosition : GetMousePosition();
 
         randomButton.hovered = CheckCollisionPointRec(mousePos, randomButton.bounds);
         closeButton.hovered = CheckCollisionPointRec(mousePos, closeButton.bounds);
         refreshButton.hovered = CheckCollisionPointRec(mousePos, refreshButton.bounds);
 
-        if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+        if (uiClick) {
             Rectangle item1Bounds = { 200, 250, 200, 120 };
             if (CheckCollisionPointRec(mousePos, item1Bounds)) {
                 BuyShopItem(currentShop.slot1);
@@ -479,36 +872,11 @@ public:
             }
 
             if (randomButton.hovered) {
-                if (player.gold >= randomCompanionPriceGold || player.kills >= randomCompanionPriceKills) {
-                    if (player.gold >= randomCompanionPriceGold) {
-                        player.gold -= randomCompanionPriceGold;
-                    }
-                    else {
-                        player.kills -= randomCompanionPriceKills;
-                    }
-
-                    // Случайный компаньон 1-2 звезды
-                    int randomType = GetRandomValue(1, 6);
-                    int randomStars = GetRandomValue(1, 2);
-                    companions.push_back(Companion(randomType, randomStars));
-
-                    purchaseCount++;
-                    randomCompanionPriceGold = 300 * (int)pow(2, purchaseCount);
-                    randomCompanionPriceKills = 30 + purchaseCount * 10;
-                    UpdateInventoryDisplay();
-                }
+                BuyRandomCompanion();
             }
 
             if (refreshButton.hovered) {
-                if (freeRefreshUses > 0) {
-                    freeRefreshUses--;
-                    RefreshShop();
-                }
-                else if (player.kills >= currentShop.manualRefreshCost) {
-                    player.kills -= currentShop.manualRefreshCost;
-                    currentShop.manualRefreshCost += 20;
-                    RefreshShop();
-                }
+                RefreshShopManually();
             }
 
             if (closeButton.hovered) {
@@ -517,7 +885,47 @@ public:
         }
     }
 
-    void BuyShopItem(const ShopItem& item) {
+    // Покупки возвращают false, если не хватило золота или убийств.
+    // Их же вызывает бот симулятора экономики
+    bool BuyRandomCompanion() {
+        if (player.gold >= randomCompanionPriceGold) {
+            player.gold -= randomCompanionPriceGold;
+        }
+        else if (player.kills >= randomCompanionPriceKills) {
+            player.kills -= randomCompanionPriceKills;
+        }
+        else {
+            return false;
+        }
+
+        // Случайный компаньон 1-2 звезды
+        int randomType = rng.Range(1, 6);
+        int randomStars = rng.Range(1, 2);
+        AddCompanion(randomType, randomStars);
+
+        purchaseCount++;
+        randomCompanionPriceGold = GetCompanionGoldPrice(pricing, purchaseCount);
+        randomCompanionPriceKills = GetCompanionKillsPrice(pricing, purchaseCount);
+        UpdateInventoryDisplay();
+        return true;
+    }
+
+    bool RefreshShopManually() {
+        if (freeRefreshUses > 0) {
+            freeRefreshUses--;
+        }
+        else if (player.kills >= currentShop.manualRefreshCost) {
+            player.kills -= currentShop.manualRefreshCost;
+            currentShop.manualRefreshCost += pricing.refreshKillsStep;
+        }
+        else {
+            return false;
+        }
+        RefreshShop();
+        return true;
+    }
+
+    bool BuyShopItem(const ShopItem& item) {
         bool canBuy = false;
 
         if (item.goldPrice > 0 && player.gold >= item.goldPrice) {
@@ -533,61 +941,61 @@ public:
             ApplyShopItemEffect(item);
             RefreshShop();
         }
+        return canBuy;
     }
 
     void ApplyShopItemEffect(const ShopItem& item) {
         switch (item.id) {
-        case 1:
+        case SHOP_ITEM_MOON_SHARD:
             attackCooldownReduction += 0.02f;
             break;
-        case 2:
+        case SHOP_ITEM_BOOTS_OF_TRAVEL:
             movementSpeedBonus += 0.03f;
             break;
-        case 3:
+        case SHOP_ITEM_DOOM_HEART:
             extraEnemiesPerSpawn += 1;
             break;
-        case 4:
+        case SHOP_ITEM_POWER_CRYSTAL:
             damageBonus += 0.02f;
             break;
-        case 5:
+        case SHOP_ITEM_POCKET_HEROES:
         {
-            int randomType = GetRandomValue(1, 6);
-            int randomStars = GetRandomValue(1, 3);
-            companions.push_back(Companion(randomType, randomStars));
+            int randomType = rng.Range(1, 6);
+            int randomStars = rng.Range(1, 3);
+            AddCompanion(randomType, randomStars);
             UpdateInventoryDisplay();
         }
         break;
-        case 6:
-            freeRefreshUses += GetRandomValue(0, 6);
+        case SHOP_ITEM_REFRESH_TOKEN:
+            freeRefreshUses += rng.Range(0, 6);
             break;
         }
     }
 
     void MergeCompanions() {
-        if (companions.size() >= 3) {
+        if (world.Count<Companion>() >= 3) {
             // Проверяем, есть ли 3 компаньона одинакового уровня звезд
-            std::vector<int> sameLevelIndices;
-            int targetLevel = companions[0].starLevel;
+            std::vector<Entity> sameLevel;
+            int targetLevel = GetMainCompanion()->starLevel;
 
-            for (int i = 0; i < companions.size(); i++) {
-                if (companions[i].starLevel == targetLevel) {
-                    sameLevelIndices.push_back(i);
-                    if (sameLevelIndices.size() == 3) break;
+            world.EachEntity<Companion>([&](Entity entity, Companion& companion) {
+                if (companion.starLevel == targetLevel && sameLevel.size() < 3) {
+                    sameLevel.push_back(entity);
                 }
-            }
+            });
 
-            if (sameLevelIndices.size() == 3) {
+            if (sameLevel.size() == 3) {
                 // Удаляем трех компаньонов
-                for (int i = 2; i >= 0; i--) {
-                    companions.erase(companions.begin() + sameLevelIndices[i]);
+                for (Entity entity : sameLevel) {
+                    world.Destroy(entity);
                 }
 
                 // Добавляем нового компаньона более высокого уровня
                 int newStarLevel = targetLevel + 1;
                 if (newStarLevel > 6) newStarLevel = 6;
 
-                int randomType = GetRandomValue(1, 6);
-                companions.push_back(Companion(randomType, newStarLevel));
+                int randomType = rng.Range(1, 6);
+                AddCompanion(randomType, newStarLevel);
 
                 UpdateInventoryDisplay();
             }
@@ -595,12 +1003,12 @@ public:
     }
 
     void UpdateMainMenu(Button& playButton, Button& settingsButton) {
-        Vector2 mousePos = GetMousePosition();
+        Vector2 mousePos = uiClick ? uiClickPosition : GetMousePosition();
 
         playButton.hovered = CheckCollisionPointRec(mousePos, playButton.bounds);
         settingsButton.hovered = CheckCollisionPointRec(mousePos, settingsButton.bounds);
 
-        if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+        if (uiClick) {
             if (playButton.hovered) {
                 inGame = true;
                 Init();
@@ -611,47 +1019,163 @@ public:
         }
     }
 
-    void UpdateSettings(Button& backButton) {
-        Vector2 mousePos = GetMousePosition();
+    void UpdateSettings(Button& backButton, Button& qualityButton) {
+        Vector2 mousePos = uiClick ? uiClickPosition : GetMousePosition();
 
         backButton.hovered = CheckCollisionPointRec(mousePos, backButton.bounds);
+        qualityButton.hovered = CheckCollisionPointRec(mousePos, qualityButton.bounds);
 
-        if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+        if (uiClick) {
             if (backButton.hovered) {
                 inSettings = false;
             }
+            // AUTO -> LOW -> MEDIUM -> HIGH -> AUTO
+            if (qualityButton.hovered) {
+                if (quality.IsAutomatic()) {
+                    quality.SetTier(QUALITY_LOW);
+                }
+                else if (quality.GetTier() + 1 < QUALITY_TIER_COUNT) {
+                    quality.SetTier((QualityTier)(quality.GetTier() + 1));
+                }
+                else {
+                    quality.SetAutomatic(true);
+                }
+                ApplyQuality();
+            }
         }
+        qualityButton.text = GetQualityLabel();
 
-        if (IsKeyDown(KEY_LEFT)) {
+        if (input.IsHeld(INPUT_VOLUME_DOWN)) {
             musicVolume = std::max(0.0f, musicVolume - 0.01f);
         }
-        if (IsKeyDown(KEY_RIGHT)) {
+        if (input.IsHeld(INPUT_VOLUME_UP)) {
             musicVolume = std::min(1.0f, musicVolume + 0.01f);
         }
 
-        SetMasterVolume(musicVolume);
+        audio.SetMasterVolume(musicVolume);
+    }
+
+    // События ввода по момент time включительно - в нажатия тика
+    void ConsumeTickInput(double time) {
+        input.BeginTick();
+        input.ConsumeUntil(inputSampler, time);
+
+        tickInput.confirm = input.WasPressed(INPUT_CONFIRM);
+        tickInput.mergeCompanions = input.WasPressed(INPUT_MERGE);
+        tickInput.cycleMinimap = input.WasPressed(INPUT_MINIMAP);
+        tickInput.attack = input.WasPressed(INPUT_ATTACK);
+        tickInput.aim = input.GetPressCursor(INPUT_ATTACK);
+        tickInput.rewindStep = input.WasPressed(INPUT_REWIND_STEP);
+        tickInput.rewindHitch = input.WasPressed(INPUT_REWIND_HITCH);
+        tickInput.quickSave = input.WasPressed(INPUT_QUICK_SAVE);
+        tickInput.quickLoad = input.WasPressed(INPUT_QUICK_LOAD);
+        if (input.WasPressed(INPUT_CLICK)) {
+            uiClick = true;
+            uiClickPosition = input.GetPressCursor(INPUT_CLICK);
+        }
+    }
+
+    // Экраны без тиков (меню, магазин, клиент) забирают все события за кадр
+    void ConsumeFrameInput() {
+        uiClick = false;
+        ConsumeTickInput(InputClock());
+    }
+
+    void StorePreviousPositions() {
+        player.previousPosition = player.position;
+        gamestate.previousCameraOffset = gamestate.cameraOffset;
+        world.Each<Placement>([](Placement& placement) { placement.previousPosition = placement.position; });
+    }
+
+    // Кадр геймплея: столько фиксированных тиков, сколько накопилось времени.
+    // Остаток тика задает, насколько отрисовка сдвинута от прошлого тика к текущему
+    void UpdateGameplayFrame() {
+        float frameTime = GetFrameTime();
+
+        // Долгим был прошлый кадр: "до рывка" - состояние на начало его тиков
+        if (frameTime > REWIND_HITCH_FRAME_TIME) {
+            hitchTick = frameStartTick;
+        }
+        frameStartTick = simTick;
+        if (pacer.IsSteady() && quality.Update(frameTime)) {
+            ApplyQuality();
+        }
+
+        simAccumulator += std::min(frameTime, PACING_MAX_FRAME_TIME);
+
+        // Тики кадра догоняют реальное время: k-й заканчивается в момент
+        // now - (накопитель - (k + 1) * dt), и ему достаются события до этого
+        // момента. Последний тик забирает все уже опрошенное, чтобы ввод не
+        // ждал следующего кадра. Кадр без тиков оставляет события в очереди
+        double now = InputClock();
+        int frameTicks = std::min((int)(simAccumulator / PACING_SIM_DT), PACING_MAX_TICKS_PER_FRAME);
+        double tickEnd = now - (simAccumulator - PACING_SIM_DT);
+        uiClick = false;
+
+        int ticks = 0;
+        while (ticks < frameTicks) {
+            ConsumeTickInput(ticks == frameTicks - 1 ? now : tickEnd);
+            UpdateGameplay(PACING_SIM_DT);
+            simAccumulator -= PACING_SIM_DT;
+            tickEnd += PACING_SIM_DT;
+            ticks++;
+        }
+        tickInput = TickInput();
+        if (ticks == PACING_MAX_TICKS_PER_FRAME) {
+            simAccumulator = std::min(simAccumulator, PACING_SIM_DT);
+        }
+
+        renderAlpha = std::min(1.0f, simAccumulator / PACING_SIM_DT);
+        UpdateRenderCamera();
+    }
+
+    void UpdateRenderCamera() {
+        renderCamera = {
+            gamestate.previousCameraOffset.x + (gamestate.cameraOffset.x - gamestate.previousCameraOffset.x) * renderAlpha,
+            gamestate.previousCameraOffset.y + (gamestate.cameraOffset.y - gamestate.previousCameraOffset.y) * renderAlpha
+        };
+    }
+
+    Vector2 WorldToRender(Vector2 previous, Vector2 current) const {
+        return {
+            previous.x + (current.x - previous.x) * renderAlpha - renderCamera.x,
+            previous.y + (current.y - previous.y) * renderAlpha - renderCamera.y
+        };
     }
 
-    void UpdateGameplay() {
+    void UpdateGameplay(float deltaTime) {
         if (choosingWeapon) return;
         if (inShop) return;
 
+        // Перемотка доступна и после смерти: можно вернуться к моменту до нее
+        if (tickInput.rewindStep) {
+            unsigned int step = (unsigned int)(REWIND_STEP_SECONDS * PACING_SIM_TICK_RATE);
+            if (RewindTo(simTick > step ? simTick - step : 0)) return;
+        }
+        if (tickInput.rewindHitch && hitchTick > 0) {
+            if (RewindTo(hitchTick)) return;
+        }
+        if (tickInput.quickLoad) {
+            if (LoadRun(SAVE_QUICK_FILE)) return;
+        }
+        if (tickInput.quickSave && !gameOver) {
+            SaveRun(SAVE_QUICK_FILE);
+        }
+
         if (gameOver) {
-            if (IsKeyPressed(KEY_ENTER)) {
+            if (tickInput.confirm) {
                 inGame = false;
             }
             return;
         }
 
-        float deltaTime = GetFrameTime();
-
-        shopRefreshTimer += deltaTime;
-        if (shopRefreshTimer >= 60.0f) {
-            RefreshShop();
-            shopRefreshTimer = 0;
-        }
+        simTick++;
+        StorePreviousPositions();
 
         timeSinceLastSpawn += deltaTime;
+        if (waveBannerTimer > 0) {
+            waveBannerTimer -= deltaTime;
+        }
         if (player.freezeCooldown > 0) {
             player.freezeCooldown -= deltaTime;
         }
@@ -661,27 +1185,53 @@ public:
         }
 
         // Обновляем таймеры компаньонов
-        for (auto& companion : companions) {
+        world.Each<Companion>([deltaTime](Companion& companion) {
             companion.attackTimer += deltaTime;
-        }
+        });
 
-        if (IsKeyPressed(KEY_F)) {
+        if (tickInput.mergeCompanions) {
             MergeCompanions();
         }
 
+        if (tickInput.cycleMinimap) {
+            minimap.CycleMode();
+        }
+
+        // Стоимость тика измеряется для режиссера спавна
+        auto tickStart = std::chrono::steady_clock::now();
+
         UpdatePlayerMovement(deltaTime);
         gamestate.UpdateCamera(player.position);
+        level.Update(gamestate.cameraOffset);
+        level.ApplyObstacles(flowField);
         UpdateEnemySpawning(deltaTime);
         UpdateEnemies(deltaTime);
         UpdateProjectiles(deltaTime);
-        CheckPlayerEnemyCollisions();
-        CheckGameOverCondition(deltaTime);
+        particles.Update(deltaTime, pacer.IsSteady() ? GetFrameTime() : 0.0f);
+        // В режиме бенчмарка игрок бессмертен, чтобы орда росла до предела
+        if (!spawnDirector.GetConfig().benchmark) {
+            CheckPlayerEnemyCollisions();
+            CheckGameOverCondition(deltaTime);
+        }
         HandleAllCompanionAttacks();
         HandleWeaponAttack();
+
+        std::chrono::duration<double> tickCost = std::chrono::steady_clock::now() - tickStart;
+        spawnDirector.RecordTickCost(tickCost.count(), GetEnemyCount() + GetProjectileCount(), deltaTime);
+
+        if (spawnDirector.GetConfig().benchmark && spawnDirector.IsSaturated() && !spawnBenchmarkReported) {
+            TraceLog(LOG_INFO, "SPAWN: sustainable entity count %d at %.1f ms budget",
+                spawnDirector.GetSustainableEntityCount(), spawnDirector.GetConfig().frameBudgetMs);
+            spawnBenchmarkReported = true;
+        }
+
+        // Строки удаленных за тик сущностей освобождаются до снимка
+        world.Flush();
+        CaptureRewindFrame();
     }
 
     void HandleAllCompanionAttacks() {
-        for (auto& companion : companions) {
+        world.Each<Companion>([this](Companion& companion) {
             CompanionData data = GetCompanionData(companion.type);
             float cooldown = data.baseCooldown / companion.starLevel;
 
@@ -689,7 +1239,7 @@ public:
                 PerformCompanionAttack(companion);
                 companion.attackTimer = 0;
             }
-        }
+        });
     }
 
     void PerformCompanionAttack(const Companion& companion) {
@@ -697,21 +1247,23 @@ public:
         int damage = data.baseDamage * companion.starLevel * (1.0f + damageBonus);
         int targets = data.targets + (companion.starLevel - 1);
 
+        audio.Play(SOUND_CAST, player.position);
+
         switch (companion.type) {
         case 1: // Warrior - ближняя атака по нескольким целям
-            PerformWarriorAttack(damage, targets);
+            PerformWarriorAttack(damage, targets, data.attackRadius);
             break;
         case 2: // Archer - замораживающие стрелы
-            PerformArcherAttack(damage, targets);
+            PerformArcherAttack(damage, targets, data.attackRadius);
             break;
         case 3: // Mars - волновые атаки
             PerformMarsAttack(damage);
             break;
         case 4: // Ice Mage - ледяные сферы
-            PerformIceMageAttack(damage, targets);
+            PerformIceMageAttack(damage, targets, data.attackRadius);
             break;
         case 5: // Fire Mage - огненные шары
-            PerformFireMageAttack(damage, targets);
+            PerformFireMageAttack(damage, targets, data.attackRadius);
             break;
         case 6: // Lightning Mage - цепная молния
             PerformLightningMageAttack(damage, targets);
@@ -719,64 +1271,162 @@ public:
         }
     }
 
-    void PerformWarriorAttack(int damage, int targets) {
-        std::vector<Enemy*> nearbyEnemies;
-        for (auto& enemy : enemies) {
-            if (!enemy.active) continue;
-            float distance = Vector2Distance(player.position, enemy.position);
-            if (distance < 100.0f) {
-                nearbyEnemies.push_back(&enemy);
+    // Враги ближе radius к игроку, от ближнего к дальнему
+    std::vector<Entity> FindNearbyEnemies(float radius) {
+        std::vector<std::pair<float, Entity>> nearby;
+        world.EachEntity<EnemyTag, Placement>([&](Entity entity, EnemyTag&, Placement& placement) {
+            float distance = Vector2Distance(player.position, placement.position);
+            if (distance < radius) {
+                nearby.push_back({ distance, entity });
             }
-        }
+        });
 
-        std::sort(nearbyEnemies.begin(), nearbyEnemies.end(),
-            [this](Enemy* a, Enemy* b) {
-                return Vector2Distance(player.position, a->position) <
-                    Vector2Distance(player.position, b->position);
+        std::sort(nearby.begin(), nearby.end(),
+            [](const std::pair<float, Entity>& a, const std::pair<float, Entity>& b) {
+                return a.first < b.first;
             });
 
-        int targetsToAttack = std::min(targets, (int)nearbyEnemies.size());
-        for (int i = 0; i < targetsToAttack; i++) {
-            Enemy* target = nearbyEnemies[i];
-            target->health -= damage;
-            if (target->health <= 0) {
-                player.kills++;
-                player.gold += GetRandomValue(6, 11);
+        std::vector<Entity> result;
+        for (const auto& entry : nearby) result.push_back(entry.second);
+        return result;
+    }
+
+    // Урон врагу. Убитый сразу удаляется из мира, поэтому убийство
+    // засчитывается ровно один раз, сколько бы атак ни попало в него за тик
+    void DamageEnemy(Entity enemy, int damage) {
+        Health* health = world.Get<Health>(enemy);
+        if (!health) return;
+
+        Vector2 position = world.Get<Placement>(enemy)->position;
+        health->current -= damage;
+        audio.Play(SOUND_HIT, position);
+        particles.Emit(PARTICLE_IMPACT, position, 6);
+        if (health->current <= 0) {
+            KillEnemy(enemy, position);
+        }
+    }
+
+    void KillEnemy(Entity enemy, Vector2 position) {
+        audio.Play(SOUND_KILL, position);
+        particles.Emit(PARTICLE_IMPACT, position, 14);
+        player.kills++;
+        runKills++;
+        player.gold += rng.Range(6, 11);
+        if (world.Get<EliteTag>(enemy)) {
+            player.gold += ELITE_GOLD_BONUS;
+        }
+        world.Destroy(enemy);
+    }
+
+    // Дальность и эффект истечения берутся из описания компаньона; снаряды без
+    // типа (копии со снапшота сервера) живут, пока их не уберет сервер
+    Entity SpawnProjectile(Vector2 position, Vector2 velocity, bool freezing = false, bool burning = false,
+        bool electrifying = false, int damage = 0, bool marsSpear = false,
+        bool marsWave = false, float size = 20.0f, int companionType = 0) {
+        ProjectileInfo info = { freezing, burning, electrifying, marsSpear, marsWave, size, damage, companionType, 0, EXPIRE_NONE };
+
+        float speed = sqrt(velocity.x * velocity.x + velocity.y * velocity.y);
+        if (companionType != 0 && speed > 0) {
+            CompanionData data = GetCompanionData(companionType);
+            if (data.projectileRange > 0) {
+                unsigned int lifetimeTicks = (unsigned int)ceil(data.projectileRange / speed * PACING_SIM_TICK_RATE);
+                info.expireTick = simTick + std::max(1u, lifetimeTicks);
+                info.expireEffect = data.expireEffect;
             }
         }
+
+        Entity projectile = world.Create(info, Placement{ position, position }, Motion{ velocity }, NetIdentity{ 0 });
+        if (info.expireTick != 0) {
+            projectileExpiries.Push(projectile, info.expireTick);
+        }
+        return projectile;
+    }
+
+    // Очередь не входит в снимок: сроки лежат в самих снарядах, после
+    // загрузки или перемотки она собирается по ним заново
+    void RebuildProjectileExpiries() {
+        projectileExpiries.Clear();
+        world.EachEntity<ProjectileInfo>([this](Entity projectile, ProjectileInfo& info) {
+            if (info.expireTick != 0) projectileExpiries.Push(projectile, info.expireTick);
+        });
     }
 
-    void PerformArcherAttack(int damage, int targets) {
-        std::vector<Enemy*> nearbyEnemies;
-        for (auto& enemy : enemies) {
-            if (!enemy.active) continue;
-            float distance = Vector2Distance(player.position, enemy.position);
-            if (distance < 250.0f) {
-                nearbyEnemies.push_back(&enemy);
+    // Снаряды, прошедшие свою дальность, уходят по очереди истечения
+    void ExpireProjectiles() {
+        Entity projectile;
+        while (projectileExpiries.PopExpired(simTick, projectile)) {
+            ProjectileInfo* info = world.Get<ProjectileInfo>(projectile);
+            if (!info) continue;   // Уже попал или вылетел за карту
+
+            if (info->expireEffect == EXPIRE_EXPLOSION) {
+                ExplodeProjectile(*info, world.Get<Placement>(projectile)->position);
             }
+            world.Destroy(projectile);
         }
+    }
 
-        std::sort(nearbyEnemies.begin(), nearbyEnemies.end(),
-            [this](Enemy* a, Enemy* b) {
-                return Vector2Distance(player.position, a->position) <
-                    Vector2Distance(player.position, b->position);
-            });
+    // Взрыв в конце пути: урон и эффекты снаряда всем врагам в радиусе.
+    // Сетка агентов уже собрана по позициям врагов этого тика
+    void ExplodeProjectile(ProjectileInfo info, Vector2 position) {
+        particles.Emit(PARTICLE_IMPACT, position, 16);
+        particles.Emit(PARTICLE_EMBER, position, 24);
+
+        collisionCandidates.clear();
+        flowField.GatherAgentsAlongSegment(position, position, PROJECTILE_EXPLOSION_RADIUS, collisionCandidates);
+        std::sort(collisionCandidates.begin(), collisionCandidates.end());
+
+        for (int agent : collisionCandidates) {
+            if (Vector2Distance(position, enemyPositions[agent]) >= PROJECTILE_EXPLOSION_RADIUS) continue;
+
+            Entity enemy = enemyEntities[agent];
+            StatusEffects* status = world.Get<StatusEffects>(enemy);
+            if (!status) continue;
+
+            if (info.isFreezing) {
+                status->frozenTimer = 3.0f;
+            }
+            if (info.isBurning) {
+                status->burnTimer = 5.0f;
+            }
+            if (info.isElectrifying) {
+                status->stunTimer = 2.0f;
+            }
+            DamageEnemy(enemy, info.damage);
+        }
+    }
+
+    // Единичный вектор от игрока к врагу
+    Vector2 DirectionToEnemy(Entity enemy) {
+        Vector2 target = world.Get<Placement>(enemy)->position;
+        Vector2 direction = {
+            target.x - player.position.x,
+            target.y - player.position.y
+        };
+
+        float length = sqrt(direction.x * direction.x + direction.y * direction.y);
+        if (length > 0) {
+            direction.x /= length;
+            direction.y /= length;
+        }
+        return direction;
+    }
+
+    void PerformWarriorAttack(int damage, int targets, float radius) {
+        std::vector<Entity> nearbyEnemies = FindNearbyEnemies(radius);
 
         int targetsToAttack = std::min(targets, (int)nearbyEnemies.size());
         for (int i = 0; i < targetsToAttack; i++) {
-            Enemy* target = nearbyEnemies[i];
-            Vector2 direction = {
-                target->position.x - player.position.x,
-                target->position.y - player.position.y
-            };
+            DamageEnemy(nearbyEnemies[i], damage);
+        }
+    }
 
-            float length = sqrt(direction.x * direction.x + direction.y * direction.y);
-            if (length > 0) {
-                direction.x /= length;
-                direction.y /= length;
-            }
+    void PerformArcherAttack(int damage, int targets, float radius) {
+        std::vector<Entity> nearbyEnemies = FindNearbyEnemies(radius);
 
-            projectiles.emplace_back(player.position,
+        int targetsToAttack = std::min(targets, (int)nearbyEnemies.size());
+        for (int i = 0; i < targetsToAttack; i++) {
+            Vector2 direction = DirectionToEnemy(nearbyEnemies[i]);
+            SpawnProjectile(player.position,
                 Vector2{ direction.x * 250.0f, direction.y * 250.0f },
                 true, false, false, damage, false, false, 20.0f, 2);
         }
@@ -784,7 +1434,7 @@ public:
 
     void PerformMarsAttack(int damage) {
         // Волновая атака Mars
-        Vector2 mouseScreenPos = GetMousePosition();
+        Vector2 mouseScreenPos = tickInput.aim;
         Vector2 mouseWorldPos = {
             mouseScreenPos.x + gamestate.cameraOffset.x,
             mouseScreenPos.y + gamestate.cameraOffset.y
@@ -803,75 +1453,27 @@ public:
         CreateMarsWaveAttack(attackDirection, damage);
     }
 
-    void PerformIceMageAttack(int damage, int targets) {
+    void PerformIceMageAttack(int damage, int targets, float radius) {
         // Ледяные сферы
-        std::vector<Enemy*> nearbyEnemies;
-        for (auto& enemy : enemies) {
-            if (!enemy.active) continue;
-            float distance = Vector2Distance(player.position, enemy.position);
-            if (distance < 200.0f) {
-                nearbyEnemies.push_back(&enemy);
-            }
-        }
-
-        std::sort(nearbyEnemies.begin(), nearbyEnemies.end(),
-            [this](Enemy* a, Enemy* b) {
-                return Vector2Distance(player.position, a->position) <
-                    Vector2Distance(player.position, b->position);
-            });
+        std::vector<Entity> nearbyEnemies = FindNearbyEnemies(radius);
 
         int targetsToAttack = std::min(targets, (int)nearbyEnemies.size());
         for (int i = 0; i < targetsToAttack; i++) {
-            Enemy* target = nearbyEnemies[i];
-            Vector2 direction = {
-                target->position.x - player.position.x,
-                target->position.y - player.position.y
-            };
-
-            float length = sqrt(direction.x * direction.x + direction.y * direction.y);
-            if (length > 0) {
-                direction.x /= length;
-                direction.y /= length;
-            }
-
-            projectiles.emplace_back(player.position,
+            Vector2 direction = DirectionToEnemy(nearbyEnemies[i]);
+            SpawnProjectile(player.position,
                 Vector2{ direction.x * 200.0f, direction.y * 200.0f },
                 true, false, false, damage, false, false, 25.0f, 4);
         }
     }
 
-    void PerformFireMageAttack(int damage, int targets) {
+    void PerformFireMageAttack(int damage, int targets, float radius) {
         // Огненные шары
-        std::vector<Enemy*> nearbyEnemies;
-        for (auto& enemy : enemies) {
-            if (!enemy.active) continue;
-            float distance = Vector2Distance(player.position, enemy.position);
-            if (distance < 300.0f) {
-                nearbyEnemies.push_back(&enemy);
-            }
-        }
-
-        std::sort(nearbyEnemies.begin(), nearbyEnemies.end(),
-            [this](Enemy* a, Enemy* b) {
-                return Vector2Distance(player.position, a->position) <
-                    Vector2Distance(player.position, b->position);
-            });
+        std::vector<Entity> nearbyEnemies = FindNearbyEnemies(radius);
 
         int targetsToAttack = std::min(targets, (int)nearbyEnemies.size());
         for (int i = 0; i < targetsToAttack; i++) {
-            Enemy* target = nearbyEnemies[i];
-            Vector2 direction = {
-                target->position.x - player.position.x,
-                target->position.y - player.position.y
-            };
-
-            float length = sqrt(direction.x * direction.x + direction.y * direction.y);
-            if (length > 0) {
-                direction.x /= length;
-                direction.y /= length;
-            }
-
-            projectiles.emplace_back(player.position,
+            Vector2 direction = DirectionToEnemy(nearbyEnemies[i]);
+            SpawnProjectile(player.position,
                 Vector2{ direction.x * 180.0f, direction.y * 180.0f },
                 false, true, false, damage, false, false, 30.0f, 5);
         }
@@ -879,49 +1481,51 @@ public:
 
     void PerformLightningMageAttack(int damage, int targets) {
         // Цепная молния
-        if (!enemies.empty()) {
-            Enemy* firstTarget = &enemies[GetRandomValue(0, enemies.size() - 1)];
-            std::vector<Enemy*> chainedTargets = { firstTarget };
-
-            // Находим дополнительные цели для цепной молнии
-            for (int i = 1; i < targets && i < enemies.size(); i++) {
-                Enemy* lastTarget = chainedTargets.back();
-                Enemy* closest = nullptr;
-                float minDist = 150.0f; // Максимальное расстояние для цепи
-
-                for (auto& enemy : enemies) {
-                    if (!enemy.active) continue;
-                    if (std::find(chainedTargets.begin(), chainedTargets.end(), &enemy) != chainedTargets.end()) continue;
-
-                    float distance = Vector2Distance(lastTarget->position, enemy.position);
-                    if (distance < minDist) {
-                        minDist = distance;
-                        closest = &enemy;
-                    }
-                }
+        std::vector<Entity> allEnemies;
+        world.EachEntity<EnemyTag>([&allEnemies](Entity entity, EnemyTag&) { allEnemies.push_back(entity); });
+        if (allEnemies.empty()) return;
 
-                if (closest) {
-                    chainedTargets.push_back(closest);
-                }
-                else {
-                    break;
-                }
-            }
+        std::vector<Entity> chainedTargets = { allEnemies[rng.Range(0, (int)allEnemies.size() - 1)] };
+
+        // Находим дополнительные цели для цепной молнии
+        for (int i = 1; i < targets && i < (int)allEnemies.size(); i++) {
+            Vector2 lastPosition = world.Get<Placement>(chainedTargets.back())->position;
+            Entity closest;
+            float minDist = 150.0f; // Максимальное расстояние для цепи
+
+            world.EachEntity<EnemyTag, Placement>([&](Entity entity, EnemyTag&, Placement& placement) {
+                if (std::find(chainedTargets.begin(), chainedTargets.end(), entity) != chainedTargets.end()) return;
 
-            // Наносим урон всем целям
-            for (auto* target : chainedTargets) {
-                target->health -= damage;
-                if (target->health <= 0) {
-                    player.kills++;
-                    player.gold += GetRandomValue(6, 11);
+                float distance = Vector2Distance(lastPosition, placement.position);
+                if (distance < minDist) {
+                    minDist = distance;
+                    closest = entity;
                 }
-                target->stunTimer = 1.0f; // Оглушение
+            });
+
+            if (closest.IsNull()) break;
+            chainedTargets.push_back(closest);
+        }
+
+        // Дуга молнии от игрока по всей цепи
+        Vector2 arcStart = player.position;
+        for (Entity target : chainedTargets) {
+            Vector2 position = world.Get<Placement>(target)->position;
+            particles.EmitArc(arcStart, position);
+            arcStart = position;
+        }
+
+        // Наносим урон всем целям, выжившие оглушены
+        for (Entity target : chainedTargets) {
+            DamageEnemy(target, damage);
+            if (StatusEffects* status = world.Get<StatusEffects>(target)) {
+                status->stunTimer = 1.0f;
             }
         }
     }
 
     void CreateMarsWaveAttack(Vector2 direction, int damage) {
-        int numProjectiles = 7 + companions.size(); // Больше волн с большим количеством компаньонов
+        int numProjectiles = 7 + world.Count<Companion>(); // Больше волн с большим количеством компаньонов
         float spreadAngle = 180.0f * 3.14159f / 180.0f;
 
         for (int i = 0; i < numProjectiles; i++) {
@@ -935,7 +1539,7 @@ public:
                 direction.x * sinA + direction.y * cosA
             };
 
-            projectiles.emplace_back(
+            SpawnProjectile(
                 player.position,
                 Vector2{ projectileDirection.x * 200.0f, projectileDirection.y * 200.0f },
                 false, false, false, damage, false, true, 40.0f, 3
@@ -946,10 +1550,11 @@ public:
     void UpdatePlayerMovement(float deltaTime) {
         player.velocity = { 0, 0 };
 
-        if (IsKeyDown(KEY_W)) player.velocity.y = -1;
-        if (IsKeyDown(KEY_S)) player.velocity.y = 1;
-        if (IsKeyDown(KEY_A)) player.velocity.x = -1;
-        if (IsKeyDown(KEY_D)) player.velocity.x = 1;
+        // На сервере игроком управляет ввод первого клиента
+        if (input.IsHeld(INPUT_MOVE_UP) || (remoteInput & NET_INPUT_UP)) player.velocity.y = -1;
+        if (input.IsHeld(INPUT_MOVE_DOWN) || (remoteInput & NET_INPUT_DOWN)) player.velocity.y = 1;
+        if (input.IsHeld(INPUT_MOVE_LEFT) || (remoteInput & NET_INPUT_LEFT)) player.velocity.x = -1;
+        if (input.IsHeld(INPUT_MOVE_RIGHT) || (remoteInput & NET_INPUT_RIGHT)) player.velocity.x = 1;
 
         float length = sqrt(player.velocity.x * player.velocity.x + player.velocity.y * player.velocity.y);
         if (length > 0) {
@@ -958,68 +1563,218 @@ public:
         }
 
         float actualSpeed = player.speed * (1.0f + movementSpeedBonus);
-        player.position.x += player.velocity.x * actualSpeed * deltaTime;
-        player.position.y += player.velocity.y * actualSpeed * deltaTime;
+
+        // Двигаемся по осям отдельно, чтобы скользить вдоль препятствий
+        Vector2 nextPosition = { player.position.x + player.velocity.x * actualSpeed * deltaTime, player.position.y };
+        if (!level.IsSolid(nextPosition)) {
+            player.position.x = nextPosition.x;
+        }
+        nextPosition = { player.position.x, player.position.y + player.velocity.y * actualSpeed * deltaTime };
+        if (!level.IsSolid(nextPosition)) {
+            player.position.y = nextPosition.y;
+        }
 
         player.position.x = std::max(0.0f, std::min(gamestate.mapSize.x, player.position.x));
         player.position.y = std::max(0.0f, std::min(gamestate.mapSize.y, player.position.y));
     }
 
     void UpdateEnemySpawning(float deltaTime) {
-        enemySpawnTimer += deltaTime;
+        // Сценарии ставят запросы в режиссер спавна (и сразу создают элитных врагов)
+        waveScripts.Update(deltaTime, runKills, GetEnemyCount());
 
-        int enemiesToSpawn = 1 + extraEnemiesPerSpawn;
+        // Запросы выдаются партиями, сколько позволяет бюджет тика
+        int spawns = spawnDirector.TakeSpawnsThisFrame(GetEnemyCount() + GetProjectileCount());
+        for (int i = 0; i < spawns; i++) {
+            CreateEnemy(world, NextSpawnPosition());
+        }
+    }
 
-        if (enemySpawnTimer >= 0.6f && enemies.size() < MAX_ENEMIES) {
-            for (int i = 0; i < enemiesToSpawn; i++) {
-                SpawnEnemy();
+    // Сценарии продолжаются с точек state; часы и счетчики планировщика -
+    // те, что были на последнем тике, чтобы ожидания решали так же, как тогда
+    void StartWaveScripts(const WaveScriptState& state, double time, int kills, int enemies) {
+        waveScripts.Reset(time, kills, enemies);
+        waveScriptState = state;
+
+        int order[WAVE_SCRIPT_COUNT] = { WAVE_SCRIPT_TRICKLE, WAVE_SCRIPT_WAVE, WAVE_SCRIPT_SHOP };
+        std::stable_sort(order, order + WAVE_SCRIPT_COUNT, [&state](int a, int b) {
+            return state.sleepOrder[a] < state.sleepOrder[b];
+        });
+        for (int script : order) {
+            switch (script) {
+            case WAVE_SCRIPT_TRICKLE: waveScripts.Start(TrickleSpawnScript()); break;
+            case WAVE_SCRIPT_WAVE: waveScripts.Start(WaveScript()); break;
+            case WAVE_SCRIPT_SHOP: waveScripts.Start(ShopRefreshScript()); break;
             }
-            enemySpawnTimer = 0;
         }
+        // Запуск только довел сценарии до их ожиданий; порядок засыпания
+        // остается сохраненным, чтобы снимок после восстановления совпадал
+        waveScriptState = state;
     }
 
-    void SpawnEnemy() {
-        float angle = GetRandomValue(0, 360) * 3.14159f / 180.0f;
-        float distance = GetRandomValue(400, 600);
+    // Вызывается перед каждым co_await сценария волн
+    void MarkScriptSleep(int script) {
+        waveScriptState.sleepOrder[script] = ++waveScriptState.sleepCount;
+    }
 
-        Vector2 spawnPos = {
-            player.position.x + cos(angle) * distance,
-            player.position.y + sin(angle) * distance
-        };
+    // Фоновый спавн: раз в trickleInterval, пока на карте меньше MAX_ENEMIES.
+    // Если карта заполнена, сценарий спит до того, как враги поредеют
+    ScriptTask TrickleSpawnScript() {
+        while (true) {
+            if (!waveScriptState.trickleWaitingRoom) {
+                MarkScriptSleep(WAVE_SCRIPT_TRICKLE);
+                co_await waveScripts.At(waveScriptState.nextTrickleTime);
+                waveScriptState.trickleWaitingRoom = 1;
+            }
 
-        spawnPos.x = std::max(0.0f, std::min(gamestate.mapSize.x, spawnPos.x));
-        spawnPos.y = std::max(0.0f, std::min(gamestate.mapSize.y, spawnPos.y));
+            MarkScriptSleep(WAVE_SCRIPT_TRICKLE);
+            co_await waveScripts.EnemiesBelow(MAX_ENEMIES);
+            spawnDirector.Request(1 + extraEnemiesPerSpawn);
 
-        enemies.emplace_back(spawnPos);
+            waveScriptState.trickleWaitingRoom = 0;
+            waveScriptState.nextTrickleTime = waveScripts.GetTime() + wavePlan.trickleInterval;
+        }
     }
 
-    void UpdateEnemies(float deltaTime) {
-        for (auto& enemy : enemies) {
-            if (!enemy.active) continue;
+    // Волна: пачка врагов, на элитных волнах еще и элитные враги. Следующая
+    // отсчитывается после того, как игрок добьет clearPercent волны
+    ScriptTask WaveScript() {
+        while (true) {
+            if (waveScriptState.wavePhase == WAVE_PHASE_DELAY) {
+                MarkScriptSleep(WAVE_SCRIPT_WAVE);
+                co_await waveScripts.At(waveScriptState.waveDeadline);
+
+                waveNumber++;
+                waveBannerTimer = wavePlan.bannerTime;
+
+                int size = GetWaveSize(wavePlan, waveNumber);
+                int elites = GetWaveElites(wavePlan, waveNumber);
+                int accepted = spawnDirector.Request(size);
+                if (accepted < size) {
+                    // Очередь режиссера полна (поздние волны, перегрузка): зачистка считается по принятым
+                    TraceLog(LOG_WARNING, "WAVES: wave %d dropped %d of %d enemies, spawn queue is full",
+                        waveNumber, size - accepted, size);
+                    size = accepted;
+                }
+                for (int i = 0; i < elites; i++) {
+                    CreateEliteEnemy(world, NextSpawnPosition());
+                }
 
-            // Обработка статусных эффектов
-            if (enemy.frozenTimer > 0) {
-                enemy.frozenTimer -= deltaTime;
-                continue; // Замороженные враги не двигаются
+                waveScriptState.waveKillTarget = waveScripts.GetKills() + (size + elites) * wavePlan.clearPercent / 100;
+                waveScriptState.wavePhase = WAVE_PHASE_CLEAR;
             }
 
-            if (enemy.burnTimer > 0) {
-                enemy.burnTimer -= deltaTime;
-                enemy.health -= 5; // Урон от горения
-                if (enemy.health <= 0) {
-                    player.kills++;
-                    player.gold += GetRandomValue(6, 11);
-                }
+            MarkScriptSleep(WAVE_SCRIPT_WAVE);
+            co_await waveScripts.Kills(waveScriptState.waveKillTarget);
+
+            // Награда за элитную волну - свежий магазин
+            if (GetWaveElites(wavePlan, waveNumber) > 0) {
+                RefreshShop();
             }
 
-            if (enemy.stunTimer > 0) {
-                enemy.stunTimer -= deltaTime;
-                continue; // Оглушенные враги не двигаются
+            waveScriptState.waveDeadline = waveScripts.GetTime() + wavePlan.waveInterval;
+            waveScriptState.wavePhase = WAVE_PHASE_DELAY;
+        }
+    }
+
+    ScriptTask ShopRefreshScript() {
+        while (true) {
+            MarkScriptSleep(WAVE_SCRIPT_SHOP);
+            co_await waveScripts.At(waveScriptState.nextShopRefreshTime);
+            RefreshShop();
+            waveScriptState.nextShopRefreshTime = waveScripts.GetTime() + pricing.refreshInterval;
+        }
+    }
+
+    Vector2 NextSpawnPosition() {
+        // Точки спавна на кольце за краем камеры
+        Rectangle view = { gamestate.cameraOffset.x, gamestate.cameraOffset.y, (float)SCREEN_WIDTH, (float)SCREEN_HEIGHT };
+        Vector2 viewCenter = { view.x + view.width / 2, view.y + view.height / 2 };
+        Vector2 spawnPos = viewCenter;
+
+        for (int attempt = 0; attempt < 4; attempt++) {
+            Vector2 offset = spawnDirector.NextSpawnOffset(view, rng);
+            spawnPos = { viewCenter.x + offset.x, viewCenter.y + offset.y };
+
+            spawnPos.x = std::max(0.0f, std::min(gamestate.mapSize.x - 1, spawnPos.x));
+            spawnPos.y = std::max(0.0f, std::min(gamestate.mapSize.y - 1, spawnPos.y));
+
+            // У края карты точка может попасть на экран: пробуем другое направление
+            if (!CheckCollisionPointRec(spawnPos, view) && !level.IsSolid(spawnPos)) break;
+        }
+
+        return spawnPos;
+    }
+
+    void UpdateEnemies(float deltaTime) {
+        // Поле потоков пересчитывается только при смене клетки игрока
+        flowField.Update(player.position);
+
+        // Сетка расталкивания строится по позициям на начало тика. Запрос тот же,
+        // что в цикле ниже, поэтому номер врага в нем совпадает с индексом в сетке
+        enemyPositions.clear();
+        world.Each<EnemyTag, Placement, Health, StatusEffects, SimLod>(
+            [this](EnemyTag&, Placement& placement, Health&, StatusEffects&, SimLod&) {
+                enemyPositions.push_back(placement.position);
+            });
+        flowField.BuildAgentGrid(enemyPositions);
+
+        Rectangle view = { gamestate.cameraOffset.x, gamestate.cameraOffset.y, (float)SCREEN_WIDTH, (float)SCREEN_HEIGHT };
+        float activeRadius = quality.GetSettings().lodActiveRadius;
+
+        int agent = 0;
+        world.EachEntity<EnemyTag, Placement, Health, StatusEffects, SimLod>(
+            [&](Entity entity, EnemyTag&, Placement& placement, Health& health, StatusEffects& status, SimLod& lod) {
+                int index = agent++;
+
+                // Дальние враги обновляются реже, накопленным шагом
+                lod.level = ClassifyEnemyLod(placement.position, player.position, view, activeRadius);
+                lod.time += deltaTime;
+                lod.frames++;
+                if (lod.time < ENEMY_LOD_INTERVALS[lod.level]) return;
+
+                float stepTime = lod.time;
+                int stepFrames = lod.frames;
+                lod.time = 0;
+                lod.frames = 0;
+
+                UpdateEnemy(entity, placement, health, status, lod.level == ENEMY_LOD_ANALYTIC, index, stepTime, stepFrames);
+            });
+
+        // Дальние скопления сливаются в рои, близкие рои разбиваются обратно
+        swarms.Update(deltaTime, player.position, view, world);
+    }
+
+    void UpdateEnemy(Entity entity, Placement& placement, Health& health, StatusEffects& status, bool analytic,
+        int index, float deltaTime, int frames) {
+        // Обработка статусных эффектов
+        if (status.frozenTimer > 0) {
+            status.frozenTimer -= deltaTime;
+            return; // Замороженные враги не двигаются
+        }
+
+        if (status.burnTimer > 0) {
+            status.burnTimer -= deltaTime;
+            health.current -= 5 * frames; // Урон от горения (за каждый кадр)
+            particles.Emit(PARTICLE_EMBER, placement.position, 20.0f * deltaTime);
+            if (health.current <= 0) {
+                KillEnemy(entity, placement.position);
+                return;
             }
+        }
+
+        if (status.stunTimer > 0) {
+            status.stunTimer -= deltaTime;
+            return; // Оглушенные враги не двигаются
+        }
 
-            Vector2 direction = {
-                player.position.x - enemy.position.x,
-                player.position.y - enemy.position.y
+        // Аналитический режим: прямо к игроку, без поля и расталкивания
+        Vector2 direction = analytic ? Vector2{ 0, 0 } : flowField.GetDirection(placement.position);
+
+        // В клетке игрока (или если клетка недостижима) идем прямо к игроку
+        if (direction.x == 0 && direction.y == 0) {
+            direction = {
+                player.position.x - placement.position.x,
+                player.position.y - placement.position.y
             };
 
             float length = sqrt(direction.x * direction.x + direction.y * direction.y);
@@ -1027,92 +1782,108 @@ public:
                 direction.x /= length;
                 direction.y /= length;
             }
-
-            enemy.position.x += direction.x * 110.0f * deltaTime;
-            enemy.position.y += direction.y * 110.0f * deltaTime;
         }
 
-        enemies.erase(std::remove_if(enemies.begin(), enemies.end(),
-            [](const Enemy& e) { return !e.active || e.health <= 0; }), enemies.end());
+        Vector2 separation = analytic ? Vector2{ 0, 0 } : flowField.GetSeparation(enemyPositions, index);
+
+        placement.position.x += (direction.x * 110.0f + separation.x * ENEMY_SEPARATION_STRENGTH) * deltaTime;
+        placement.position.y += (direction.y * 110.0f + separation.y * ENEMY_SEPARATION_STRENGTH) * deltaTime;
     }
 
     void UpdateProjectiles(float deltaTime) {
-        for (auto& projectile : projectiles) {
-            if (!projectile.active) continue;
-
-            projectile.position.x += projectile.velocity.x * deltaTime;
-            projectile.position.y += projectile.velocity.y * deltaTime;
-
-            for (auto& enemy : enemies) {
-                if (!enemy.active) continue;
-
-                float distance = Vector2Distance(projectile.position, enemy.position);
-                float collisionDistance = projectile.isMarsWave ? 50.0f : 30.0f;
-
-                if (distance < collisionDistance) {
-                    enemy.health -= projectile.damage;
-
-                    if (enemy.health <= 0) {
-                        player.kills++;
-                        player.gold += GetRandomValue(6, 11);
+        // Широкая фаза - сетка поля потоков, пересобранная по позициям после хода врагов
+        enemyPositions.clear();
+        enemyEntities.clear();
+        world.EachEntity<EnemyTag, Placement>([this](Entity enemy, EnemyTag&, Placement& placement) {
+            enemyPositions.push_back(placement.position);
+            enemyEntities.push_back(enemy);
+        });
+        flowField.BuildAgentGrid(enemyPositions);
+
+        ExpireProjectiles();
+
+        world.EachEntity<ProjectileInfo, Placement, Motion>(
+            [&](Entity projectile, ProjectileInfo& info, Placement& placement, Motion& motion) {
+                // Снаряд проверяется по всему пути за тик, а не в конечной точке:
+                // быстрый снаряд или длинный тик не проскочат врага
+                Vector2 from = placement.position;
+                Vector2 to = { from.x + motion.velocity.x * deltaTime, from.y + motion.velocity.y * deltaTime };
+                float collisionDistance = info.isMarsWave ? 50.0f : 30.0f;
+                bool piercing = info.isMarsSpear || info.isMarsWave;
+                bool spent = false;
+
+                collisionCandidates.clear();
+                flowField.GatherAgentsAlongSegment(from, to, collisionDistance, collisionCandidates);
+
+                projectileHits.clear();
+                for (int agent : collisionCandidates) {
+                    float t;
+                    if (SweepPointCircle(from, to, enemyPositions[agent], collisionDistance, t)) {
+                        projectileHits.push_back({ t, agent });
                     }
-
-                    // Применяем статусные эффекты
-                    if (projectile.isFreezing) {
-                        enemy.frozenTimer = 3.0f;
+                }
+                // По времени попадания; при равенстве - по порядку врагов, как раньше
+                std::sort(projectileHits.begin(), projectileHits.end());
+
+                for (const auto& hit : projectileHits) {
+                    Entity enemy = enemyEntities[hit.second];
+                    // Враг мог погибнуть от снаряда раньше в этом тике
+                    StatusEffects* status = world.Get<StatusEffects>(enemy);
+                    if (!status) continue;
+
+                    // Статусные эффекты ставятся до урона: убитый враг сразу удаляется
+                    if (info.isFreezing) {
+                        status->frozenTimer = 3.0f;
                     }
-                    if (projectile.isBurning) {
-                        enemy.burnTimer = 5.0f;
+                    if (info.isBurning) {
+                        status->burnTimer = 5.0f;
                     }
-                    if (projectile.isElectrifying) {
-                        enemy.stunTimer = 2.0f;
+                    if (info.isElectrifying) {
+                        status->stunTimer = 2.0f;
                     }
+                    DamageEnemy(enemy, info.damage);
 
-                    if (!projectile.isMarsSpear && !projectile.isMarsWave) {
-                        projectile.active = false;
+                    if (!piercing) {
+                        // Непробивающий снаряд останавливается в точке первого попадания
+                        to = { from.x + (to.x - from.x) * hit.first, from.y + (to.y - from.y) * hit.first };
+                        spent = true;
                         break;
                     }
                 }
-            }
 
-            if (projectile.position.x < 0 || projectile.position.x > gamestate.mapSize.x ||
-                projectile.position.y < 0 || projectile.position.y > gamestate.mapSize.y) {
-                projectile.active = false;
-            }
-        }
+                placement.position = to;
+                if (info.isMarsWave) {
+                    particles.Emit(PARTICLE_WAVE, placement.position, 40.0f * deltaTime);
+                }
 
-        projectiles.erase(std::remove_if(projectiles.begin(), projectiles.end(),
-            [](const Projectile& p) { return !p.active; }), projectiles.end());
+                if (spent || placement.position.x < 0 || placement.position.x > gamestate.mapSize.x ||
+                    placement.position.y < 0 || placement.position.y > gamestate.mapSize.y) {
+                    world.Destroy(projectile);
+                }
+            });
     }
 
     void HandleWeaponAttack() {
-        if (companions.empty()) return;
-
-        if (IsMouseButtonPressed(MOUSE_RIGHT_BUTTON) && player.attackCooldown <= 0) {
-            Vector2 mouseScreenPos = GetMousePosition();
-            Vector2 mouseWorldPos = {
-                mouseScreenPos.x + gamestate.cameraOffset.x,
-                mouseScreenPos.y + gamestate.cameraOffset.y
-            };
+        Companion* mainCompanion = GetMainCompanion();
+        if (!mainCompanion) return;
 
+        if (tickInput.attack && player.attackCooldown <= 0) {
             // Используем способность основного компаньона
-            Companion& mainCompanion = companions[0];
-            PerformCompanionAttack(mainCompanion);
+            PerformCompanionAttack(*mainCompanion);
             player.attackCooldown = 0.3f;
         }
     }
 
     void CheckPlayerEnemyCollisions() {
-        for (auto& enemy : enemies) {
-            if (!enemy.active) continue;
-
-            float distance = Vector2Distance(player.position, enemy.position);
+        world.Each<EnemyTag, Placement>([this](EnemyTag&, Placement& placement) {
+            float distance = Vector2Distance(player.position, placement.position);
             if (distance < 40.0f) {
                 player.health -= 5;
+                audio.Play(SOUND_PLAYER_HURT, player.position);
 
                 Vector2 pushDirection = {
-                    player.position.x - enemy.position.x,
-                    player.position.y - enemy.position.y
+                    player.position.x - placement.position.x,
+                    player.position.y - placement.position.y
                 };
 
                 float length = sqrt(pushDirection.x * pushDirection.x + pushDirection.y * pushDirection.y);
@@ -1124,7 +1895,7 @@ public:
                 player.position.x += pushDirection.x * 20.0f;
                 player.position.y += pushDirection.y * 20.0f;
             }
-        }
+        });
 
         if (player.health <= 0) {
             gameOver = true;
@@ -1132,7 +1903,7 @@ public:
     }
 
     void CheckGameOverCondition(float deltaTime) {
-        if (enemies.size() > MAX_ENEMIES || player.health <= 0) {
+        if (GetEnemyCount() > MAX_ENEMIES || player.health <= 0) {
             gameOverTimer -= deltaTime;
             if (gameOverTimer <= 0) {
                 gameOver = true;
@@ -1146,57 +1917,57 @@ public:
     void DrawWeaponChoice(Button& meleeButton, Button& rangeButton, Button& magicButton) {
         ClearBackground(BLACK);
 
-        if (backgroundTexture.id != 0) {
-            DrawTexture(backgroundTexture, 0, 0, WHITE);
+        if (assets.IsReady(backgroundSprite)) {
+            DrawSprite(assets.Get(backgroundSprite), 0, 0, WHITE);
         }
 
-        DrawText("CHOOSE YOUR COMPANION", SCREEN_WIDTH / 2 - MeasureText("CHOOSE YOUR COMPANION", 40) / 2, 200, 40, WHITE);
+        textCache.DrawCentered("CHOOSE YOUR COMPANION", SCREEN_WIDTH / 2, 200, 40, WHITE);
 
         // Кнопка Warrior
         DrawRectangleRec(meleeButton.bounds, meleeButton.hovered ? GRAY : DARKGRAY);
-        if (meleeTexture.id != 0) {
-            DrawTexture(meleeTexture, meleeButton.bounds.x + 10, meleeButton.bounds.y + 10, WHITE);
+        if (assets.IsReady(meleeSprite)) {
+            DrawSprite(assets.Get(meleeSprite), meleeButton.bounds.x + 10, meleeButton.bounds.y + 10, WHITE);
         }
         else {
             DrawRectangle(meleeButton.bounds.x + 10, meleeButton.bounds.y + 10, 30, 30, RED);
         }
-        DrawText(meleeButton.text.c_str(),
-            meleeButton.bounds.x + meleeButton.bounds.width / 2 - MeasureText(meleeButton.text.c_str(), 30) / 2,
+        textCache.DrawCentered(meleeButton.text.c_str(),
+            meleeButton.bounds.x + meleeButton.bounds.width / 2,
             meleeButton.bounds.y + meleeButton.bounds.height / 2 - 15, 30, WHITE);
 
         // Кнопка Archer
         DrawRectangleRec(rangeButton.bounds, rangeButton.hovered ? GRAY : DARKGRAY);
-        if (rangeTexture.id != 0) {
-            DrawTexture(rangeTexture, rangeButton.bounds.x + 10, rangeButton.bounds.y + 10, WHITE);
+        if (assets.IsReady(rangeSprite)) {
+            DrawSprite(assets.Get(rangeSprite), rangeButton.bounds.x + 10, rangeButton.bounds.y + 10, WHITE);
         }
         else {
             DrawRectangle(rangeButton.bounds.x + 10, rangeButton.bounds.y + 10, 30, 30, GREEN);
         }
-        DrawText(rangeButton.text.c_str(),
-            rangeButton.bounds.x + rangeButton.bounds.width / 2 - MeasureText(rangeButton.text.c_str(), 30) / 2,
+        textCache.DrawCentered(rangeButton.text.c_str(),
+            rangeButton.bounds.x + rangeButton.bounds.width / 2,
             rangeButton.bounds.y + rangeButton.bounds.height / 2 - 15, 30, WHITE);
 
         // Кнопка Ice Mage
         DrawRectangleRec(magicButton.bounds, magicButton.hovered ? GRAY : DARKGRAY);
-        if (iceTexture.id != 0) {
-            DrawTexture(iceTexture, magicButton.bounds.x + 10, magicButton.bounds.y + 10, WHITE);
+        if (assets.IsReady(iceSprite)) {
+            DrawSprite(assets.Get(iceSprite), magicButton.bounds.x + 10, magicButton.bounds.y + 10, WHITE);
         }
         else {
             DrawRectangle(magicButton.bounds.x + 10, magicButton.bounds.y + 10, 30, 30, SKYBLUE);
         }
-        DrawText(magicButton.text.c_str(),
-            magicButton.bounds.x + magicButton.bounds.width / 2 - MeasureText(magicButton.text.c_str(), 30) / 2,
+        textCache.DrawCentered(magicButton.text.c_str(),
+            magicButton.bounds.x + magicButton.bounds.width / 2,
             magicButton.bounds.y + magicButton.bounds.height / 2 - 15, 30, WHITE);
     }
 
     void DrawShop(Button& randomButton, Button& closeButton, Button& refreshButton) {
         ClearBackground(BLACK);
 
-        if (backgroundTexture.id != 0) {
-            DrawTexture(backgroundTexture, 0, 0, WHITE);
+        if (assets.IsReady(backgroundSprite)) {
+            DrawSprite(assets.Get(backgroundSprite), 0, 0, WHITE);
         }
 
-        DrawText("SHOP", SCREEN_WIDTH / 2 - MeasureText("SHOP", 60) / 2, 80, 60, WHITE);
+        textCache.DrawCentered("SHOP", SCREEN_WIDTH / 2, 80, 60, WHITE);
 
         DrawText(("Gold: " + std::to_string(player.gold)).c_str(), 80, 150, 30, YELLOW);
         DrawText(("Kills: " + std::to_string(player.kills)).c_str(), 80, 190, 30, WHITE);
@@ -1206,9 +1977,9 @@ public:
         DrawShopItem(currentShop.slot3, 700, 250);
 
         DrawRectangleRec(randomButton.bounds, randomButton.hovered ? GRAY : DARKGRAY);
-        DrawText("RANDOM", randomButton.bounds.x + randomButton.bounds.width / 2 - MeasureText("RANDOM", 25) / 2,
+        textCache.DrawCentered("RANDOM", randomButton.bounds.x + randomButton.bounds.width / 2,
             randomButton.bounds.y + 10, 25, WHITE);
-        DrawText("COMPANION", randomButton.bounds.x + randomButton.bounds.width / 2 - MeasureText("COMPANION", 20) / 2,
+        textCache.DrawCentered("COMPANION", randomButton.bounds.x + randomButton.bounds.width / 2,
             randomButton.bounds.y + 40, 20, WHITE);
         DrawText(("Gold: " + std::to_string(randomCompanionPriceGold)).c_str(), randomButton.bounds.x + 10, randomButton.bounds.y + 70, 15,
             player.gold >= randomCompanionPriceGold ? GREEN : RED);
@@ -1216,9 +1987,9 @@ public:
             player.kills >= randomCompanionPriceKills ? GREEN : RED);
 
         DrawRectangleRec(refreshButton.bounds, refreshButton.hovered ? GRAY : DARKGRAY);
-        DrawText("REFRESH", refreshButton.bounds.x + refreshButton.bounds.width / 2 - MeasureText("REFRESH", 25) / 2,
+        textCache.DrawCentered("REFRESH", refreshButton.bounds.x + refreshButton.bounds.width / 2,
             refreshButton.bounds.y + 10, 25, WHITE);
-        DrawText("SHOP", refreshButton.bounds.x + refreshButton.bounds.width / 2 - MeasureText("SHOP", 20) / 2,
+        textCache.DrawCentered("SHOP", refreshButton.bounds.x + refreshButton.bounds.width / 2,
             refreshButton.bounds.y + 40, 20, WHITE);
 
         if (freeRefreshUses > 0) {
@@ -1230,13 +2001,13 @@ public:
         }
 
         DrawRectangleRec(closeButton.bounds, closeButton.hovered ? GRAY : DARKGRAY);
-        DrawText(closeButton.text.c_str(),
-            closeButton.bounds.x + closeButton.bounds.width / 2 - MeasureText(closeButton.text.c_str(), 30) / 2,
+        textCache.DrawCentered(closeButton.text.c_str(),
+            closeButton.bounds.x + closeButton.bounds.width / 2,
             closeButton.bounds.y + closeButton.bounds.height / 2 - 15, 30, WHITE);
 
         DrawText("Press F to merge 3 same-star companions", 80, 390, 20, WHITE);
         // ИСПРАВЛЕННАЯ СТРОКА:
-        DrawText(("Companions: " + std::to_string(companions.size()) + "/" + std::to_string(MAX_INVENTORY_SLOTS)).c_str(), 80, 420, 20, WHITE);
+        DrawText(("Companions: " + std::to_string(world.Count<Companion>()) + "/" + std::to_string(MAX_INVENTORY_SLOTS)).c_str(), 80, 420, 20, WHITE);
 
         DrawText(("Attack CD Reduction: " + std::to_string((int)(attackCooldownReduction * 100)) + "%").c_str(), 800, 320, 20, BLUE);
         DrawText(("Movement Speed: +" + std::to_string((int)(movementSpeedBonus * 100)) + "%").c_str(), 800, 350, 20, BLUE);
@@ -1276,34 +2047,44 @@ public:
     }
 
     void DrawMainMenu(const Button& playButton, const Button& settingsButton) {
-        if (menuBackgroundLoaded) {
-            DrawTexture(menuBackgroundTexture, 0, 0, WHITE);
+        if (assets.IsReady(menuBackgroundSprite)) {
+            DrawSprite(assets.Get(menuBackgroundSprite), 0, 0, WHITE);
         }
         else {
             ClearBackground(BLACK);
         }
 
-        DrawText("ODIUM", SCREEN_WIDTH / 2 - MeasureText("ODIUM", 80) / 2, 200, 80, WHITE);
+        textCache.DrawCentered("ODIUM", SCREEN_WIDTH / 2, 200, 80, WHITE);
 
         DrawRectangleRec(playButton.bounds, playButton.hovered ? GRAY : DARKGRAY);
-        DrawText(playButton.text.c_str(),
-            playButton.bounds.x + playButton.bounds.width / 2 - MeasureText(playButton.text.c_str(), 30) / 2,
+        textCache.DrawCentered(playButton.text.c_str(),
+            playButton.bounds.x + playButton.bounds.width / 2,
             playButton.bounds.y + playButton.bounds.height / 2 - 15, 30, WHITE);
 
         DrawRectangleRec(settingsButton.bounds, settingsButton.hovered ? GRAY : DARKGRAY);
-        DrawText(settingsButton.text.c_str(),
-            settingsButton.bounds.x + settingsButton.bounds.width / 2 - MeasureText(settingsButton.text.c_str(), 30) / 2,
+        textCache.DrawCentered(settingsButton.text.c_str(),
+            settingsButton.bounds.x + settingsButton.bounds.width / 2,
             settingsButton.bounds.y + settingsButton.bounds.height / 2 - 15, 30, WHITE);
+
+        // Меню работает сразу, ассеты догружаются в фоне
+        if (!assets.IsComplete()) {
+            int barWidth = 300;
+            int barX = SCREEN_WIDTH / 2 - barWidth / 2;
+            int barY = SCREEN_HEIGHT - 60;
+            DrawRectangle(barX, barY, barWidth, 8, DARKGRAY);
+            DrawRectangle(barX, barY, (int)(barWidth * assets.GetProgress()), 8, LIGHTGRAY);
+            textCache.DrawCentered("Loading...", SCREEN_WIDTH / 2, barY - 25, 20, LIGHTGRAY);
+        }
     }
 
-    void DrawSettings(const Button& backButton) {
+    void DrawSettings(const Button& backButton, const Button& qualityButton) {
         ClearBackground(BLACK);
 
-        if (backgroundTexture.id != 0) {
-            DrawTexture(backgroundTexture, 0, 0, WHITE);
+        if (assets.IsReady(backgroundSprite)) {
+            DrawSprite(assets.Get(backgroundSprite), 0, 0, WHITE);
         }
 
-        DrawText("SETTINGS", SCREEN_WIDTH / 2 - MeasureText("SETTINGS", 50) / 2, 150, 50, WHITE);
+        textCache.DrawCentered("SETTINGS", SCREEN_WIDTH / 2, 150, 50, WHITE);
 
         DrawText("MUSIC VOLUME:", 400, 250, 30, WHITE);
 
@@ -1316,67 +2097,107 @@ public:
         std::string volumeText = std::to_string((int)(musicVolume * 100)) + "%";
         DrawText(volumeText.c_str(), 910, 255, 20, WHITE);
 
+        DrawText("QUALITY:", 400, 325, 30, WHITE);
+        DrawRectangleRec(qualityButton.bounds, qualityButton.hovered ? GRAY : DARKGRAY);
+        textCache.DrawCentered(qualityButton.text.c_str(),
+            qualityButton.bounds.x + qualityButton.bounds.width / 2,
+            qualityButton.bounds.y + qualityButton.bounds.height / 2 - 10, 20, WHITE);
+
         DrawRectangleRec(backButton.bounds, backButton.hovered ? GRAY : DARKGRAY);
-        DrawText(backButton.text.c_str(),
-            backButton.bounds.x + backButton.bounds.width / 2 - MeasureText(backButton.text.c_str(), 30) / 2,
+        textCache.DrawCentered(backButton.text.c_str(),
+            backButton.bounds.x + backButton.bounds.width / 2,
             backButton.bounds.y + backButton.bounds.height / 2 - 15, 30, WHITE);
     }
 
-    void DrawGameplay() {
-        BeginDrawing();
+    void DrawWorld() {
+        const QualitySettings& settings = quality.GetSettings();
 
-        ClearBackground(BLACK);
-
-        if (backgroundTexture.id != 0) {
+        if (settings.parallaxBackground && assets.IsReady(backgroundSprite)) {
             float parallaxFactor = 0.5f;
-            DrawTexture(backgroundTexture,
-                -gamestate.cameraOffset.x * parallaxFactor,
-                -gamestate.cameraOffset.y * parallaxFactor, WHITE);
+            DrawSprite(assets.Get(backgroundSprite),
+                (int)(-renderCamera.x * parallaxFactor),
+                (int)(-renderCamera.y * parallaxFactor), WHITE);
         }
 
+        level.Draw(renderCamera);
+
         {
             // Враги с эффектами
-            for (const auto& enemy : enemies) {
-                if (!enemy.active) continue;
+            world.Each<EnemyTag, Placement, Health, StatusEffects>(
+                [&](EnemyTag&, Placement& placement, Health& health, StatusEffects& status) {
+                    Vector2 screenPos = WorldToRender(placement.previousPosition, placement.position);
 
-                Vector2 screenPos = gamestate.WorldToScreen(enemy.position);
+                    Color enemyColor = BLUE;
+                    if (status.frozenTimer > 0) enemyColor = SKYBLUE;
+                    else if (status.burnTimer > 0) enemyColor = Color{ 255, 69, 0, 255 };
+                    else if (status.stunTimer > 0) enemyColor = YELLOW;
 
-                Color enemyColor = BLUE;
-                if (enemy.frozenTimer > 0) enemyColor = SKYBLUE;
-                else if (enemy.burnTimer > 0) enemyColor = Color{ 255, 69, 0, 255 };
-                else if (enemy.stunTimer > 0) enemyColor = YELLOW;
+                    DrawRectangle((int)screenPos.x - 20, (int)screenPos.y - 20, 40, 40, enemyColor);
 
-                DrawRectangle((int)screenPos.x - 20, (int)screenPos.y - 20, 40, 40, enemyColor);
+                    if (settings.enemyHealthBars) {
+                        float healthPercent = (float)health.current / health.max;
+                        DrawRectangle((int)screenPos.x - 20, (int)screenPos.y - 30, 40, 5, RED);
+                        DrawRectangle((int)screenPos.x - 20, (int)screenPos.y - 30, (int)(40 * healthPercent), 5, GREEN);
+                    }
+                });
 
-                float healthPercent = (float)enemy.health / enemy.maxHealth;
-                DrawRectangle((int)screenPos.x - 20, (int)screenPos.y - 30, 40, 5, RED);
-                DrawRectangle((int)screenPos.x - 20, (int)screenPos.y - 30, (int)(40 * healthPercent), 5, GREEN);
-            }
+            // Элитные враги обведены рамкой
+            world.Each<EliteTag, Placement>([&](EliteTag&, Placement& placement) {
+                Vector2 screenPos = WorldToRender(placement.previousPosition, placement.position);
+                DrawRectangleLines((int)screenPos.x - 26, (int)screenPos.y - 26, 52, 52, GOLD);
+                DrawRectangleLines((int)screenPos.x - 25, (int)screenPos.y - 25, 50, 50, GOLD);
+            });
 
             // Снаряды с разными цветами
-            for (const auto& projectile : projectiles) {
-                if (!projectile.active) continue;
-
-                Vector2 screenPos = gamestate.WorldToScreen(projectile.position);
+            world.Each<ProjectileInfo, Placement>([&](ProjectileInfo& info, Placement& placement) {
+                Vector2 screenPos = WorldToRender(placement.previousPosition, placement.position);
 
                 Color projColor = WHITE;
-                if (projectile.isFreezing) projColor = SKYBLUE;
-                else if (projectile.isBurning) projColor = Color{ 255, 69, 0, 255 };
-                else if (projectile.isElectrifying) projColor = YELLOW;
-                else if (projectile.isMarsWave) projColor = ORANGE;
+                if (info.isFreezing) projColor = SKYBLUE;
+                else if (info.isBurning) projColor = Color{ 255, 69, 0, 255 };
+                else if (info.isElectrifying) projColor = YELLOW;
+                else if (info.isMarsWave) projColor = ORANGE;
 
-                if (projectile.isMarsWave) {
-                    DrawCircle((int)screenPos.x, (int)screenPos.y, projectile.size / 2, projColor);
+                if (info.isMarsWave) {
+                    DrawCircle((int)screenPos.x, (int)screenPos.y, info.size / 2, projColor);
                 }
                 else {
                     DrawRectangle((int)screenPos.x - 10, (int)screenPos.y - 10, 20, 20, projColor);
                 }
-            }
+            });
+
+            particles.Draw(renderCamera, { (float)SCREEN_WIDTH, (float)SCREEN_HEIGHT });
 
             // Игрок
-            Vector2 playerScreenPos = gamestate.WorldToScreen(player.position);
+            Vector2 playerScreenPos = WorldToRender(player.previousPosition, player.position);
             DrawRectangle((int)playerScreenPos.x - 25, (int)playerScreenPos.y - 25, 50, 50, RED);
         }
+    }
+
+    void DrawGameplay() {
+        UpdateHud();
+        minimap.Update(GetFrameTime(), gamestate.mapSize, world, swarms.GetSwarms());
+
+        // Мир рисуется в таргет уменьшенного разрешения и растягивается, HUD - в родном
+        if (pacer.IsSteady()) {
+            resolution.Update(GetFrameTime());
+        }
+        if (resolution.IsActive()) {
+            resolution.Begin();
+            DrawWorld();
+            resolution.End();
+        }
+
+        BeginDrawing();
+
+        ClearBackground(BLACK);
+
+        if (resolution.IsActive()) {
+            resolution.Draw();
+        }
+        else {
+            DrawWorld();
+        }
 
         DrawUI();
         DrawMinimap();
@@ -1386,72 +2207,67 @@ public:
         Rectangle shopButton = { SCREEN_WIDTH - 140, 20, 120, 50 };
         bool shopHovered = CheckCollisionPointRec(GetMousePosition(), shopButton);
 
-        DrawRectangleRec(shopButton, shopHovered ? GRAY : DARKGRAY);
-        DrawText("SHOP", SCREEN_WIDTH - 130, 35, 20, WHITE);
+        // У тонкого клиента магазина нет: экономика живет на сервере
+        if (!remote) {
+            DrawRectangleRec(shopButton, shopHovered ? GRAY : DARKGRAY);
+            DrawText("SHOP", SCREEN_WIDTH - 130, 35, 20, WHITE);
 
-        if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && shopHovered) {
-            inShop = true;
+            if (uiClick && CheckCollisionPointRec(uiClickPosition, shopButton)) {
+                inShop = true;
+            }
+        }
+
+        // Пишется только геймплей: меню и магазин перерисовываются по событиям.
+        // Метка записи рисуется после захвата и в видео не попадает
+        if (capture.IsActive()) {
+            capture.CaptureFrame(GetTime());
+            std::string recordText = "REC  dropped " + std::to_string(capture.GetDroppedCount());
+            DrawText(recordText.c_str(), SCREEN_WIDTH - 340, 35, 20, capture.GetDroppedCount() > 0 ? ORANGE : RED);
         }
 
         EndDrawing();
     }
 
     void DrawMinimap() {
-        int minimapSize = 180;
+        int minimapSize = MINIMAP_SIZE;
         int minimapX = 20;
         int minimapY = SCREEN_HEIGHT - minimapSize - 52 * 2 - 30;
 
-        DrawRectangle(minimapX, minimapY, minimapSize, minimapSize, DARKGREEN);
-        DrawRectangleLines(minimapX, minimapY, minimapSize, minimapSize, WHITE);
-
-        float scaleX = (float)minimapSize / gamestate.mapSize.x;
-        float scaleY = (float)minimapSize / gamestate.mapSize.y;
-
-        for (const auto& enemy : enemies) {
-            if (!enemy.active) continue;
-
-            int enemyX = minimapX + (int)(enemy.position.x * scaleX);
-            int enemyY = minimapY + (int)(enemy.position.y * scaleY);
-
-            DrawRectangle(enemyX - 2, enemyY - 2, 4, 4, BLUE);
-        }
-
-        int playerX = minimapX + (int)(player.position.x * scaleX);
-        int playerY = minimapY + (int)(player.position.y * scaleY);
-        DrawRectangle(playerX - 3, playerY - 3, 6, 6, RED);
+        // Враги берутся из кеша миникарты (обновляется с частотой MINIMAP_REFRESH_RATE)
+        minimap.Draw(minimapX, minimapY, gamestate.mapSize, player.position);
     }
 
     void DrawInventory() {
         Vector2 mousePos = GetMousePosition();
         std::string hoverDescription = "";
 
-        if (inventoryTexture.id != 0) {
+        if (assets.IsReady(inventorySprite)) {
             int totalWidth = 102 * 3;
             int totalHeight = 52 * 2;
             int textureX = (SCREEN_WIDTH - totalWidth) / 2;
             int textureY = SCREEN_HEIGHT - totalHeight - 20;
-            DrawTexture(inventoryTexture, textureX, textureY, WHITE);
+            DrawSprite(assets.Get(inventorySprite), textureX, textureY, WHITE);
         }
 
         for (const auto& item : inventory) {
             // Рисуем иконки компаньонов
-            if (item.type == 1 && meleeTexture.id != 0) {
-                DrawTexture(meleeTexture, item.slot.x + 10, item.slot.y + 10, WHITE);
+            if (item.type == 1 && assets.IsReady(meleeSprite)) {
+                DrawSprite(assets.Get(meleeSprite), item.slot.x + 10, item.slot.y + 10, WHITE);
             }
-            else if (item.type == 2 && rangeTexture.id != 0) {
-                DrawTexture(rangeTexture, item.slot.x + 10, item.slot.y + 10, WHITE);
+            else if (item.type == 2 && assets.IsReady(rangeSprite)) {
+                DrawSprite(assets.Get(rangeSprite), item.slot.x + 10, item.slot.y + 10, WHITE);
             }
-            else if (item.type == 3 && marsTexture.id != 0) {
-                DrawTexture(marsTexture, item.slot.x + 10, item.slot.y + 10, WHITE);
+            else if (item.type == 3 && assets.IsReady(marsSprite)) {
+                DrawSprite(assets.Get(marsSprite), item.slot.x + 10, item.slot.y + 10, WHITE);
             }
-            else if (item.type == 4 && iceTexture.id != 0) {
-                DrawTexture(iceTexture, item.slot.x + 10, item.slot.y + 10, WHITE);
+            else if (item.type == 4 && assets.IsReady(iceSprite)) {
+                DrawSprite(assets.Get(iceSprite), item.slot.x + 10, item.slot.y + 10, WHITE);
             }
-            else if (item.type == 5 && fireTexture.id != 0) {
-                DrawTexture(fireTexture, item.slot.x + 10, item.slot.y + 10, WHITE);
+            else if (item.type == 5 && assets.IsReady(fireSprite)) {
+                DrawSprite(assets.Get(fireSprite), item.slot.x + 10, item.slot.y + 10, WHITE);
             }
-            else if (item.type == 6 && lightningTexture.id != 0) {
-                DrawTexture(lightningTexture, item.slot.x + 10, item.slot.y + 10, WHITE);
+            else if (item.type == 6 && assets.IsReady(lightningSprite)) {
+                DrawSprite(assets.Get(lightningSprite), item.slot.x + 10, item.slot.y + 10, WHITE);
             }
             else if (item.type == 1) {
                 DrawRectangle(item.slot.x + 10, item.slot.y + 10, 30, 30, RED);
@@ -1494,47 +2310,512 @@ public:
     void DrawUI() {
         int startY = 20;
 
-        std::string enemyCountText = "Enemies: " + std::to_string(enemies.size()) + "/" + std::to_string(MAX_ENEMIES);
-        DrawText(enemyCountText.c_str(), 20, startY, 20, WHITE);
+        // Статичная часть HUD собрана в текстуру (см. UpdateHud)
+        hud.Draw(0, 0);
 
-        std::string healthText = "HP: " + std::to_string(player.health) + "/" + std::to_string(PLAYER_MAX_HEALTH);
-        DrawText(healthText.c_str(), 20, startY + 30, 20, GREEN);
+        // Убрано отображение количества компаньонов слева сверху
 
-        float playerHealthPercent = (float)player.health / player.maxHealth;
-        DrawRectangle(120, startY + 35, 150, 10, RED);
-        DrawRectangle(120, startY + 35, (int)(150 * playerHealthPercent), 10, GREEN);
+        if (spawnDirector.GetConfig().benchmark) {
+            const char* benchmarkText = TextFormat("Tick: %.1f/%.1f ms  Sustainable: %d", spawnDirector.GetAverageTickMs(),
+                spawnDirector.GetConfig().frameBudgetMs, spawnDirector.GetSustainableEntityCount());
+            DrawText(benchmarkText, 20, startY + 120, 20, spawnDirector.IsSaturated() ? RED : GREEN);
+        }
 
-        std::string goldText = "Gold: " + std::to_string(player.gold);
-        DrawText(goldText.c_str(), 20, startY + 60, 20, YELLOW);
+        if (waveBannerTimer > 0) {
+            float alpha = std::min(1.0f, waveBannerTimer);
+            bool eliteWave = GetWaveElites(wavePlan, waveNumber) > 0;
+            std::string waveText = (eliteWave ? "ELITE WAVE " : "WAVE ") + std::to_string(waveNumber);
+            textCache.DrawCentered(waveText.c_str(), SCREEN_WIDTH / 2, 120, 48, Fade(eliteWave ? GOLD : WHITE, alpha));
+        }
 
-        std::string killsText = "Kills: " + std::to_string(player.kills);
-        DrawText(killsText.c_str(), 20, startY + 90, 20, WHITE);
+        if (gameOver) {
+            DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, Fade(BLACK, 0.5f));
+            textCache.DrawCentered("GAME OVER", SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2 - 50, 60, RED);
+            textCache.DrawCentered("Press ENTER to exit", SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2 + 20, 30, WHITE);
+        }
+    }
 
-        // Убрано отображение количества компаньонов слева сверху
+    // ---------------------------------------------------------------------
+    // Сетевой режим
 
-        if (enemies.size() > MAX_ENEMIES) {
-            std::string timerText = "Time: " + std::to_string((int)gameOverTimer);
-            DrawText(timerText.c_str(), 20, startY + 120, 20, RED);
+    static double NowSeconds() {
+        using namespace std::chrono;
+        return duration<double>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    void StartHeadlessRun(int seededEnemies) {
+        inGame = true;
+        Init();
+
+        // Меню выбора нет: сервер начинает с лучника
+        AddCompanion(2, 1);
+        UpdateInventoryDisplay();
+        choosingWeapon = false;
+
+        // Орда для замеров сериализации: равномерно по карте, вне экрана игрока
+        for (int i = 0; i < seededEnemies; i++) {
+            Vector2 position = {
+                (float)rng.Range(0, (int)gamestate.mapSize.x - 1),
+                (float)rng.Range(0, (int)gamestate.mapSize.y - 1)
+            };
+            if (fabsf(position.x - player.position.x) < SCREEN_WIDTH / 2 &&
+                fabsf(position.y - player.position.y) < SCREEN_HEIGHT / 2) continue;
+            CreateEnemy(world, position);
+        }
+    }
+
+    // Бот симулятора экономики. Пробует BOT_DIRECTIONS направлений и оценивает
+    // точку через BOT_LOOKAHEAD секунд: враги ближе BOT_CONTACT_RADIUS гонят
+    // его прочь, а если ближайший враг дальше радиуса атаки основного компаньона,
+    // бот подходит к нему. Так он держит орду на дистанции выстрела и сам ищет бой.
+    // У краев карты тянется к центру. Атаку жмет все время, прицел - на ближнего врага
+    unsigned char ChooseBotInput() {
+        const int directions[BOT_DIRECTIONS][2] = {
+            { 0, 0 }, { 0, -1 }, { 0, 1 }, { -1, 0 }, { 1, 0 }, { -1, -1 }, { 1, -1 }, { -1, 1 }, { 1, 1 }
+        };
+        const unsigned char inputs[BOT_DIRECTIONS] = {
+            0, NET_INPUT_UP, NET_INPUT_DOWN, NET_INPUT_LEFT, NET_INPUT_RIGHT,
+            NET_INPUT_UP | NET_INPUT_LEFT, NET_INPUT_UP | NET_INPUT_RIGHT,
+            NET_INPUT_DOWN | NET_INPUT_LEFT, NET_INPUT_DOWN | NET_INPUT_RIGHT
+        };
+
+        Companion* mainCompanion = GetMainCompanion();
+        float engageRadius = mainCompanion ? GetCompanionData(mainCompanion->type).attackRadius * BOT_ENGAGE_FRACTION : 0;
+
+        // Прицел в экранных координатах, как у мыши
+        Vector2 nearest = player.position;
+        float nearestSq = 1e30f;
+        world.Each<EnemyTag, Placement>([&](EnemyTag&, Placement& placement) {
+            float dx = placement.position.x - player.position.x;
+            float dy = placement.position.y - player.position.y;
+            if (dx * dx + dy * dy < nearestSq) {
+                nearestSq = dx * dx + dy * dy;
+                nearest = placement.position;
+            }
+        });
+        tickInput.attack = true;
+        tickInput.aim = { nearest.x - gamestate.cameraOffset.x, nearest.y - gamestate.cameraOffset.y };
+
+        float step = player.speed * (1.0f + movementSpeedBonus) * BOT_LOOKAHEAD;
+        Vector2 center = { gamestate.mapSize.x / 2, gamestate.mapSize.y / 2 };
+        int best = 0;
+        float bestDanger = 1e30f;
+        for (int d = 0; d < BOT_DIRECTIONS; d++) {
+            float length = (directions[d][0] != 0 && directions[d][1] != 0) ? 0.7071f : 1.0f;
+            Vector2 target = {
+                player.position.x + directions[d][0] * length * step,
+                player.position.y + directions[d][1] * length * step
+            };
+            if (target.x < 0 || target.y < 0 || target.x > gamestate.mapSize.x || target.y > gamestate.mapSize.y ||
+                level.IsSolid(target)) continue;
+
+            float danger = 0;
+            float closestSq = 1e30f;
+            world.Each<EnemyTag, Placement>([&](EnemyTag&, Placement& placement) {
+                float dx = target.x - placement.position.x;
+                float dy = target.y - placement.position.y;
+                float distanceSq = dx * dx + dy * dy;
+                closestSq = std::min(closestSq, distanceSq);
+                if (distanceSq > BOT_CONTACT_RADIUS * BOT_CONTACT_RADIUS) return;
+                danger += 1.0f / std::max(distanceSq, 100.0f);
+            });
+
+            // Вне радиуса атаки компаньоны не стреляют: штраф растет с расстоянием
+            float closest = sqrtf(closestSq);
+            if (engageRadius > 0 && closestSq < 1e30f && closest > engageRadius) {
+                danger += (closest - engageRadius) * BOT_ENGAGE_PULL;
+            }
+
+            // Слабое притяжение к центру: в углу окружить проще
+            float cx = (target.x - center.x) / center.x;
+            float cy = (target.y - center.y) / center.y;
+            danger += (cx * cx + cy * cy) * BOT_CENTER_PULL;
+
+            if (danger < bestDanger) {
+                best = d;
+                bestDanger = danger;
+            }
         }
+        return inputs[best];
+    }
 
-        DrawText("RMB: Companion ability", 20, startY + 150, 20, WHITE);
-        DrawText("F: Merge 3 same-star companions", 20, startY + 180, 20, WHITE);
+    bool CanBotAfford(const BotPolicy& policy, int goldPrice, int killsPrice) {
+        return (goldPrice > 0 && player.gold - goldPrice >= policy.goldReserve) ||
+            (killsPrice > 0 && player.kills >= killsPrice);
+    }
 
-        DrawText(("CD Reduction: " + std::to_string((int)(attackCooldownReduction * 100)) + "%").c_str(), 20, startY + 210, 18, BLUE);
-        DrawText(("Speed: +" + std::to_string((int)(movementSpeedBonus * 100)) + "%").c_str(), 20, startY + 235, 18, BLUE);
-        DrawText(("Damage: +" + std::to_string((int)(damageBonus * 100)) + "%").c_str(), 20, startY + 260, 18, BLUE);
+    // Покупает по весам политики, пока есть что и на что брать. Магазин в
+    // игре ставит симуляцию на паузу, поэтому все покупки - в один тик
+    void BotShop(const BotPolicy& policy, EconomyRunResult& result) {
+        for (int attempt = 0; attempt < BOT_MAX_SHOP_ACTIONS; attempt++) {
+            const ShopItem* slots[SHOP_SLOT_COUNT] = { &currentShop.slot1, &currentShop.slot2, &currentShop.slot3 };
+            const ShopItem* bestItem = nullptr;
+            float bestWeight = 0;
+            bool wantedInSlots = false;
+            for (const ShopItem* item : slots) {
+                if (item->id < 1 || item->id > SHOP_ITEM_COUNT) continue;
+                float weight = policy.itemWeights[item->id];
+                if (weight <= 0) continue;
+                wantedInSlots = true;
+                if (weight > bestWeight && CanBotAfford(policy, item->goldPrice, item->killsPrice)) {
+                    bestItem = item;
+                    bestWeight = weight;
+                }
+            }
+
+            if (policy.companionWeight > bestWeight &&
+                CanBotAfford(policy, randomCompanionPriceGold, randomCompanionPriceKills)) {
+                if (!BuyRandomCompanion()) break;
+                result.purchases[ECONOMY_PURCHASE_COMPANION]++;
+            }
+            else if (bestItem) {
+                int id = bestItem->id;
+                if (!BuyShopItem(*bestItem)) break;
+                result.purchases[id]++;
+            }
+            else if (policy.refreshForItems && !wantedInSlots && RefreshShopManually()) {
+                result.purchases[ECONOMY_PURCHASE_REFRESH]++;
+            }
+            else {
+                break;
+            }
+        }
+    }
+
+    // Один забег бота до смерти или до maxSeconds. Мир сбрасывается через
+    // InitRun, поэтому буферы врагов, снарядов и поля потоков остаются с прошлого забега
+    void RunBot(const BotPolicy& policy, unsigned int seed, float maxSeconds, EconomyRunResult& result) {
+        inGame = true;
+        InitRun(seed);
+        AddCompanion(2, 1); // Лучник, как на сервере
+        UpdateInventoryDisplay();
+        choosingWeapon = false;
+
+        int maxTicks = (int)(maxSeconds * PACING_SIM_TICK_RATE);
+        int shopTicks = (int)(ECONOMY_SHOP_INTERVAL * PACING_SIM_TICK_RATE);
+        int sampleTicks = (int)(ECONOMY_SAMPLE_INTERVAL * PACING_SIM_TICK_RATE);
+        int goldSpent = 0;
+        int killsSpent = 0;
+
+        int tick = 0;
+        for (; tick < maxTicks && !gameOver; tick++) {
+            tickInput = TickInput();
+            if (tick % shopTicks == 0) {
+                int goldBefore = player.gold;
+                int killsBefore = player.kills;
+                BotShop(policy, result);
+                goldSpent += goldBefore - player.gold;
+                killsSpent += killsBefore - player.kills;
+                tickInput.mergeCompanions = policy.mergeCompanions;
+            }
+            remoteInput = ChooseBotInput();
 
+            UpdateGameplay(PACING_SIM_DT);
+
+            if ((tick + 1) % sampleTicks == 0 && result.samples < ECONOMY_MAX_SAMPLES) {
+                result.killsEarned[result.samples] = player.kills + killsSpent;
+                result.goldEarned[result.samples] = player.gold + goldSpent;
+                result.samples++;
+            }
+        }
+
+        result.survivalSeconds = tick * PACING_SIM_DT;
+        result.survived = !gameOver;
+        world.Each<Companion>([&result](Companion& companion) {
+            result.companionStars += companion.starLevel;
+        });
+        remoteInput = 0;
+    }
+
+    // Проверка перемотки на забеге бота: снимок, ticks тиков вперед, перемотка
+    // к снимку и те же тики заново. Оба прогона должны дать побайтно один снимок.
+    // Замеры стоимости тика не сравниваются - это время машины, и в режиме
+    // без бюджета (как у симулятора экономики) на спавн они не влияют
+    bool RunRewindCheck(unsigned int seed, int ticks) {
+        inGame = true;
+        InitRun(seed);
+        AddCompanion(2, 1);
+        UpdateInventoryDisplay();
+        choosingWeapon = false;
+
+        // Игрок лечится перед каждым тиком в обоих прогонах, чтобы бот не умер
+        // посреди проверки: сверять тогда было бы нечего
+        auto step = [this](int count) {
+            for (int i = 0; i < count && !gameOver; i++) {
+                player.health = player.maxHealth;
+                tickInput = TickInput();
+                remoteInput = ChooseBotInput();
+                UpdateGameplay(PACING_SIM_DT);
+            }
+        };
+
+        step((int)(REWIND_CHECK_WARMUP_SECONDS * PACING_SIM_TICK_RATE));
+        unsigned int startTick = simTick;
         if (gameOver) {
-            DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, Fade(BLACK, 0.5f));
-            DrawText("GAME OVER", SCREEN_WIDTH / 2 - MeasureText("GAME OVER", 60) / 2, SCREEN_HEIGHT / 2 - 50, 60, RED);
-            DrawText("Press ENTER to exit", SCREEN_WIDTH / 2 - MeasureText("Press ENTER to exit", 30) / 2, SCREEN_HEIGHT / 2 + 20, 30, WHITE);
+            TraceLog(LOG_WARNING, "REWIND CHECK: run ended during warmup at tick %u, nothing to compare", simTick);
+            return false;
+        }
+        std::vector<unsigned char> expected;
+        std::vector<unsigned char> replayed;
+
+        step(ticks);
+        CaptureWorldState(expected);
+        unsigned int endTick = simTick;
+        if ((int)(endTick - startTick) != ticks) {
+            TraceLog(LOG_WARNING, "REWIND CHECK: run ended at tick %u, only %d of %d ticks to compare",
+                endTick, (int)(endTick - startTick), ticks);
+            return false;
+        }
+
+        if (!RewindTo(startTick)) {
+            TraceLog(LOG_WARNING, "REWIND CHECK: tick %u is not in the rewind buffer", startTick);
+            return false;
+        }
+        step(ticks);
+        CaptureWorldState(replayed);
+        remoteInput = 0;
+
+        MaskTickCosts(expected);
+        MaskTickCosts(replayed);
+        size_t mismatch = 0;
+        while (mismatch < expected.size() && mismatch < replayed.size() && expected[mismatch] == replayed[mismatch]) {
+            mismatch++;
+        }
+        if (expected.size() == replayed.size() && mismatch == expected.size()) {
+            TraceLog(LOG_INFO, "REWIND CHECK: ticks %u-%u replayed exactly (%d entities, %d bytes)",
+                startTick, endTick, world.Count<Placement>(), (int)expected.size());
+            return true;
+        }
+        TraceLog(LOG_WARNING, "REWIND CHECK: ticks %u-%u diverge at byte %d of %d (%s), replay ended at tick %u",
+            startTick, endTick, (int)mismatch, (int)expected.size(),
+            mismatch < sizeof(WorldStateHeader) ? "header" : "world", simTick);
+        return false;
+    }
+
+    static void MaskTickCosts(std::vector<unsigned char>& state) {
+        WorldStateHeader header;
+        if (state.size() < sizeof(header)) return;
+        std::memcpy(&header, state.data(), sizeof(header));
+        header.spawnDirector.averageTickCost = 0;
+        header.spawnDirector.averageEntityCost = 0;
+        header.spawnDirector.saturatedTime = 0;
+        std::memcpy(state.data(), &header, sizeof(header));
+    }
+
+    void FillNetSnapshot(NetSnapshot& snapshot, unsigned int tick) {
+        snapshot.tick = tick;
+        snapshot.levelSeed = levelSeed;
+        snapshot.player.x = QuantizePosition(player.position.x);
+        snapshot.player.y = QuantizePosition(player.position.y);
+        snapshot.player.health = (short)player.health;
+        snapshot.player.maxHealth = (short)player.maxHealth;
+        snapshot.player.gold = player.gold;
+        snapshot.player.kills = player.kills;
+        snapshot.player.gameOver = gameOver;
+
+        // id выдаются при первой отправке в порядке перебора, а Flush порядок строк
+        // сохраняет - поэтому внутри одного архетипа id уже отсортированы
+        snapshot.entities.clear();
+        world.Each<EnemyTag, Placement, Health, StatusEffects, NetIdentity>(
+            [&](EnemyTag&, Placement& placement, Health& health, StatusEffects& status, NetIdentity& net) {
+                if (net.id == 0) net.id = nextNetId++;
+
+                NetEntityState state;
+                state.id = net.id;
+                state.x = QuantizePosition(placement.position.x);
+                state.y = QuantizePosition(placement.position.y);
+                state.kind = NET_ENTITY_ENEMY;
+                state.flags = (status.frozenTimer > 0 ? NET_FLAG_ICE : 0) | (status.burnTimer > 0 ? NET_FLAG_FIRE : 0) |
+                    (status.stunTimer > 0 ? NET_FLAG_LIGHTNING : 0);
+                state.extra = (unsigned char)std::max(0, std::min(255, health.current * 255 / std::max(1, health.max)));
+                snapshot.entities.push_back(state);
+            });
+        size_t enemyCount = snapshot.entities.size();
+
+        world.Each<ProjectileInfo, Placement, NetIdentity>([&](ProjectileInfo& info, Placement& placement, NetIdentity& net) {
+            if (net.id == 0) net.id = nextNetId++;
+
+            NetEntityState state;
+            state.id = net.id;
+            state.x = QuantizePosition(placement.position.x);
+            state.y = QuantizePosition(placement.position.y);
+            state.kind = NET_ENTITY_PROJECTILE;
+            state.flags = (info.isFreezing ? NET_FLAG_ICE : 0) | (info.isBurning ? NET_FLAG_FIRE : 0) |
+                (info.isElectrifying ? NET_FLAG_LIGHTNING : 0) | (info.isMarsWave ? NET_FLAG_MARS_WAVE : 0);
+            state.extra = (unsigned char)std::min(255.0f, info.size);
+            snapshot.entities.push_back(state);
+        });
+
+        // Враги и снаряды сейчас - по одному архетипу, и хватает слияния двух
+        // отсортированных половин; вид из нескольких архетипов сортируется целиком
+        auto byId = [](const NetEntityState& a, const NetEntityState& b) { return a.id < b.id; };
+        auto middle = snapshot.entities.begin() + enemyCount;
+        if (std::is_sorted(snapshot.entities.begin(), middle, byId) && std::is_sorted(middle, snapshot.entities.end(), byId)) {
+            std::inplace_merge(snapshot.entities.begin(), middle, snapshot.entities.end(), byId);
+        }
+        else {
+            std::sort(snapshot.entities.begin(), snapshot.entities.end(), byId);
+        }
+    }
+
+    // Сервер без окна: фиксированные тики, снапшоты раз в NET_SNAPSHOT_INTERVAL_TICKS.
+    // loopbackClients - клиенты-зонды в этом же процессе, для проверки без второй машины
+    void RunServer(unsigned short port, int loopbackClients, int seededEnemies, int maxTicks, const char* saveFile) {
+        if (!netServer.Start(port)) {
+            TraceLog(LOG_ERROR, "NET: cannot open UDP port %u", port);
+            return;
+        }
+        TraceLog(LOG_INFO, "NET: server on UDP port %u, %d snapshots/s", netServer.GetPort(),
+            PACING_SIM_TICK_RATE / NET_SNAPSHOT_INTERVAL_TICKS);
+
+        std::vector<std::unique_ptr<NetClient>> probes;
+        for (int i = 0; i < loopbackClients; i++) {
+            probes.emplace_back(new NetClient());
+            probes.back()->Connect(NetAddress(NET_LOOPBACK_IP, netServer.GetPort()));
+        }
+
+        StartHeadlessRun(seededEnemies);
+        if (saveFile) LoadRun(saveFile);
+
+        const std::chrono::nanoseconds tickDuration(1000000000LL / PACING_SIM_TICK_RATE);
+        auto nextTick = std::chrono::steady_clock::now();
+        for (unsigned int tick = 1; maxTicks <= 0 || tick <= (unsigned int)maxTicks; tick++) {
+            double now = NowSeconds();
+            netServer.Receive(now);
+            remoteInput = netServer.GetInput();
+
+            if (gameOver) {
+                StartHeadlessRun(seededEnemies);
+            }
+            UpdateGameplay(PACING_SIM_DT);
+
+            if (tick % NET_SNAPSHOT_INTERVAL_TICKS == 0) {
+                double gatherStart = NowSeconds();
+                FillNetSnapshot(netWorld, tick);
+                netServer.Broadcast(netWorld, NowSeconds() - gatherStart);
+            }
+
+            // Зонды смотрят на игрока экраном обычного клиента
+            Rectangle view = { player.position.x - SCREEN_WIDTH / 2, player.position.y - SCREEN_HEIGHT / 2,
+                (float)SCREEN_WIDTH, (float)SCREEN_HEIGHT };
+            for (auto& probe : probes) {
+                probe->Receive();
+                probe->SendUpdate(view, 0);
+            }
+
+            NetServerStats stats;
+            if (netServer.TakeReport(now, stats)) {
+                TraceLog(LOG_INFO, "NET: %d clients, %d entities (%d per client), %.0f bytes/tick, %.1f packets/tick, serialize %.3f ms",
+                    stats.clients, stats.worldEntities, stats.sentEntities, stats.bytesPerTick, stats.packetsPerTick,
+                    stats.serializeMs);
+            }
+
+            nextTick += tickDuration;
+            auto current = std::chrono::steady_clock::now();
+            if (current > nextTick + tickDuration * PACING_MAX_TICKS_PER_FRAME) {
+                // Тик дольше бюджета: не догоняем пачкой, а сдвигаем расписание
+                nextTick = current;
+            }
+            std::this_thread::sleep_until(nextTick);
+        }
+
+        for (int i = 0; i < (int)probes.size(); i++) {
+            TraceLog(LOG_INFO, "NET: loopback client %d received %d snapshots, rejected %d, last has %d entities",
+                i, probes[i]->GetReceivedCount(), probes[i]->GetRejectedCount(),
+                probes[i]->HasSnapshot() ? (int)probes[i]->GetLatest().entities.size() : 0);
+        }
+        netServer.Stop();
+    }
+
+    bool ConnectToServer(const NetAddress& address) {
+        netClient.reset(new NetClient());
+        if (!netClient->Connect(address)) return false;
+
+        remote = true;
+        inGame = true;
+        choosingWeapon = false;
+        inShop = false;
+        return true;
+    }
+
+    void ApplyNetSnapshot(const NetSnapshot& snapshot) {
+        if (snapshot.levelSeed != levelSeed) {
+            levelSeed = snapshot.levelSeed;
+            level.Init(gamestate.mapSize, levelSeed);
+        }
+
+        // Прошлые позиции по id: отрисовка интерполирует от прошлого снапшота к новому
+        remotePositions.clear();
+        world.Each<Placement, NetIdentity>([this](Placement& placement, NetIdentity& net) {
+            remotePositions[net.id] = placement.position;
+        });
+
+        player.previousPosition = player.position;
+        player.position = { DequantizePosition(snapshot.player.x), DequantizePosition(snapshot.player.y) };
+        player.health = snapshot.player.health;
+        player.maxHealth = snapshot.player.maxHealth;
+        player.gold = snapshot.player.gold;
+        player.kills = snapshot.player.kills;
+        gameOver = snapshot.player.gameOver;
+
+        // Сетевые сущности пересоздаются из снапшота целиком
+        world.EachEntity<NetIdentity>([this](Entity entity, NetIdentity&) { world.Destroy(entity); });
+        world.Flush();
+        for (const auto& entity : snapshot.entities) {
+            Vector2 position = { DequantizePosition(entity.x), DequantizePosition(entity.y) };
+            auto previous = remotePositions.find(entity.id);
+
+            Entity created;
+            if (entity.kind == NET_ENTITY_ENEMY) {
+                created = CreateEnemy(world, position, entity.extra);
+                world.Get<Health>(created)->max = 255;
+                StatusEffects* status = world.Get<StatusEffects>(created);
+                status->frozenTimer = (entity.flags & NET_FLAG_ICE) ? 1.0f : 0.0f;
+                status->burnTimer = (entity.flags & NET_FLAG_FIRE) ? 1.0f : 0.0f;
+                status->stunTimer = (entity.flags & NET_FLAG_LIGHTNING) ? 1.0f : 0.0f;
+            }
+            else {
+                created = SpawnProjectile(position, { 0, 0 }, (entity.flags & NET_FLAG_ICE) != 0,
+                    (entity.flags & NET_FLAG_FIRE) != 0, (entity.flags & NET_FLAG_LIGHTNING) != 0, 0, false,
+                    (entity.flags & NET_FLAG_MARS_WAVE) != 0, (float)entity.extra);
+            }
+            world.Get<NetIdentity>(created)->id = entity.id;
+            if (previous != remotePositions.end()) world.Get<Placement>(created)->previousPosition = previous->second;
+        }
+
+        gamestate.previousCameraOffset = gamestate.cameraOffset;
+        gamestate.UpdateCamera(player.position);
+        remoteSnapshotTime = GetTime();
+    }
+
+    // Кадр тонкого клиента: прием снапшотов, отправка ввода и подтверждения
+    void UpdateRemoteFrame() {
+        if (netClient->Receive()) {
+            ApplyNetSnapshot(netClient->GetLatest());
         }
+
+        ConsumeFrameInput();
+        unsigned char buttons = 0;
+        if (input.IsHeld(INPUT_MOVE_UP)) buttons |= NET_INPUT_UP;
+        if (input.IsHeld(INPUT_MOVE_DOWN)) buttons |= NET_INPUT_DOWN;
+        if (input.IsHeld(INPUT_MOVE_LEFT)) buttons |= NET_INPUT_LEFT;
+        if (input.IsHeld(INPUT_MOVE_RIGHT)) buttons |= NET_INPUT_RIGHT;
+        Rectangle view = { gamestate.cameraOffset.x, gamestate.cameraOffset.y, (float)SCREEN_WIDTH, (float)SCREEN_HEIGHT };
+        netClient->SendUpdate(view, buttons);
+
+        level.Update(gamestate.cameraOffset);
+
+        // Снапшоты приходят реже кадров: позиции ведутся от прошлого снапшота к последнему
+        float interval = NET_SNAPSHOT_INTERVAL_TICKS * PACING_SIM_DT;
+        renderAlpha = std::min(1.0f, (float)(GetTime() - remoteSnapshotTime) / interval);
+        UpdateRenderCamera();
     }
 
     void Run() {
         Button playButton = { {SCREEN_WIDTH / 2 - 100, 350, 200, 50}, "PLAY", false };
         Button settingsButton = { {SCREEN_WIDTH / 2 - 100, 420, 200, 50}, "SETTINGS", false };
         Button backButton = { {SCREEN_WIDTH / 2 - 100, 500, 200, 50}, "BACK", false };
+        Button qualityButton = { {600, 320, 300, 40}, GetQualityLabel(), false };
 
         Button meleeButton = { {SCREEN_WIDTH / 2 - 150, 300, 300, 80}, "WARRIOR", false };
         Button rangeButton = { {SCREEN_WIDTH / 2 - 150, 400, 300, 80}, "ARCHER", false };
@@ -1544,8 +2825,44 @@ public:
         Button refreshButton = { {350, 500, 200, 120}, "REFRESH SHOP", false };
         Button shopCloseButton = { {850, 500, 200, 50}, "CLOSE", false };
 
+        // Поток опроса ввода живет, пока открыто окно
+        inputSampler.Start(GetWindowHandle(), INPUT_SAMPLE_RATE);
+        input.Reset();
+        if (!captureConfig.fileName.empty()) {
+            capture.Start(captureConfig, GetRenderWidth(), GetRenderHeight());
+        }
+
         while (!WindowShouldClose()) {
-            if (inGame) {
+            // Догружаем готовые картинки в GPU, не больше бюджета за кадр
+            assets.UploadPending(ASSET_UPLOAD_BUDGET_SECONDS);
+            audio.Update(GetFrameTime(), player.position);
+
+            // Меню, настройки, выбор оружия и магазин перерисовываются только по событиям
+            bool staticScreen = !inGame || choosingWeapon || inShop;
+
+            // Стартовый бенчмарк качества идет на статичных экранах, по шагу за кадр
+            if (staticScreen && quality.IsBenchmarkRunning() && quality.StepBenchmark(QUALITY_BENCHMARK_FRAMES_PER_STEP)) {
+                ApplyQuality();
+                qualityButton.text = GetQualityLabel();
+            }
+            pacer.Update(staticScreen, !assets.IsComplete() || audio.IsMusicPlaying() || quality.IsBenchmarkRunning());
+
+            // Без потока опроса состояние ввода снимается с raylib раз в кадр
+            inputSampler.SampleFrame();
+            if (staticScreen) {
+                tickInput = TickInput();
+                ConsumeFrameInput();
+            }
+            else {
+                // Режим низкой задержки: ждем кадр здесь, тики заберут и свежие события
+                if (pacer.WaitForFrame()) inputSampler.SampleFrame();
+            }
+
+            if (remote) {
+                UpdateRemoteFrame();
+                DrawGameplay();
+            }
+            else if (inGame) {
                 if (choosingWeapon) {
                     UpdateWeaponChoice(meleeButton, rangeButton, magicButton);
                     BeginDrawing();
@@ -1559,14 +2876,14 @@ public:
                     EndDrawing();
                 }
                 else {
-                    UpdateGameplay();
+                    UpdateGameplayFrame();
                     DrawGameplay();
                 }
             }
             else if (inSettings) {
-                UpdateSettings(backButton);
+                UpdateSettings(backButton, qualityButton);
                 BeginDrawing();
-                DrawSettings(backButton);
+                DrawSettings(backButton, qualityButton);
                 EndDrawing();
             }
             else {
@@ -1576,14 +2893,202 @@ public:
                 EndDrawing();
             }
         }
+
+        capture.Stop();
+        inputSampler.Stop();
+        if (inputSampler.GetRetryCount() > 0) {
+            TraceLog(LOG_INFO, "INPUT: %d state changes waited for a full queue", inputSampler.GetRetryCount());
+        }
     }
 };
 
-int main() {
+static bool RunRewindCheck(const SpawnDirectorConfig& spawnConfig, const ShopPricing& pricing, unsigned int seed, float seconds) {
+    SpawnDirectorConfig checkSpawnConfig = spawnConfig;
+    checkSpawnConfig.unbudgeted = true;
+
+    Game game(true);
+    game.ConfigureSpawnDirector(checkSpawnConfig);
+    game.ConfigurePricing(pricing);
+    game.ConfigureRewind(seconds + 1.0f);
+    return game.RunRewindCheck(seed, (int)(seconds * PACING_SIM_TICK_RATE));
+}
+
+// Балансный прогон: по headless-миру на поток, каждый переиспользуется между забегами
+static void RunEconomySimulator(const EconomySimConfig& config, const SpawnDirectorConfig& spawnConfig) {
+    SpawnDirectorConfig botSpawnConfig = spawnConfig;
+    botSpawnConfig.unbudgeted = true;
+
+    std::vector<std::unique_ptr<Game>> worlds;
+    for (int i = 0; i < GetEconomyWorkerCount(config); i++) {
+        worlds.emplace_back(new Game(true));
+        worlds.back()->ConfigureSpawnDirector(botSpawnConfig);
+        worlds.back()->ConfigurePricing(config.pricing);
+    }
+
+    RunEconomySimulation(config, [&worlds, &config](int worker, const BotPolicy& policy, unsigned int seed, EconomyRunResult& result) {
+        worlds[worker]->RunBot(policy, seed, config.maxSeconds, result);
+    });
+}
+
+int main(int argc, char** argv) {
+    // --spawn-budget=<ms> : бюджет CPU на тик для режиссера спавна
+    // --spawn-benchmark   : спавнить до насыщения и вывести предел сущностей
+    // --render-scale=<min>,<max> : границы динамического разрешения мира
+    // --no-dynamic-resolution    : всегда рисовать мир в родном разрешении
+    // --pacing=fixed|display|uncapped : частота кадров геймплея (симуляция всегда 60 тиков)
+    // --low-latency       : опрашивать ввод как можно ближе к отрисовке
+    // --server[=<port>]   : авторитетный сервер без окна, снапшоты по UDP
+    // --connect=<host>[:<port>] : тонкий клиент, рисует снапшоты сервера
+    // --net-loopback=<n>  : n клиентов-зондов в процессе сервера (проверка через loopback)
+    // --net-entities=<n>  : стартовая орда сервера для замеров сериализации
+    // --net-ticks=<n>     : остановить сервер через n тиков и вывести итог зондов
+    // --rewind-seconds=<s> : глубина перемотки (0 - выключить; на сервере по умолчанию выключена)
+    // --load=<file>       : начать с сохраненного забега (и в окне, и на сервере)
+    // --price=<name>=<value> : переопределить цену (item, companion, companion-growth, refresh, ... см. shop.cpp)
+    // --economy-sim[=<n>] : без окна прогнать по n забегов ботов на политику и вывести сводку
+    // --economy-policy=<name> : только эта политика из BOT_POLICIES (можно несколько раз)
+    // --economy-seconds=<s>, --economy-threads=<n>, --economy-seed=<n> : параметры прогона
+    // --capture=<file>    : записывать геймплей (.y4m - без сжатия, иначе через ffmpeg)
+    // --capture-fps=<n>   : частота кадров записи
+    // --rewind-check[=<s>] : без окна сверить забег после перемотки с первым прогоном (сид - --economy-seed)
+    SpawnDirectorConfig spawnConfig;
+    DynamicResolutionConfig resolutionConfig;
+    PacingMode pacingMode = PACING_MODE_FIXED;
+    bool lowLatency = false;
+    bool server = false;
+    unsigned short serverPort = NET_DEFAULT_PORT;
+    const char* connectAddress = nullptr;
+    int loopbackClients = 0;
+    int seededEnemies = 0;
+    int maxTicks = 0;
+    float rewindSeconds = -1.0f;
+    const char* loadFile = nullptr;
+    bool economySim = false;
+    float rewindCheckSeconds = 0;
+    EconomySimConfig economyConfig;
+    CaptureConfig captureConfig;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--spawn-budget=", 15) == 0) {
+            spawnConfig.frameBudgetMs = std::max(0.5f, (float)atof(argv[i] + 15));
+        }
+        else if (strcmp(argv[i], "--spawn-benchmark") == 0) {
+            spawnConfig.benchmark = true;
+        }
+        else if (strncmp(argv[i], "--render-scale=", 15) == 0) {
+            const char* bounds = argv[i] + 15;
+            resolutionConfig.minScale = (float)atof(bounds);
+            const char* comma = strchr(bounds, ',');
+            if (comma) resolutionConfig.maxScale = (float)atof(comma + 1);
+        }
+        else if (strcmp(argv[i], "--no-dynamic-resolution") == 0) {
+            resolutionConfig.enabled = false;
+        }
+        else if (strncmp(argv[i], "--pacing=", 9) == 0) {
+            const char* mode = argv[i] + 9;
+            if (strcmp(mode, "display") == 0) pacingMode = PACING_MODE_DISPLAY;
+            else if (strcmp(mode, "uncapped") == 0) pacingMode = PACING_MODE_UNCAPPED;
+            else pacingMode = PACING_MODE_FIXED;
+        }
+        else if (strcmp(argv[i], "--low-latency") == 0) {
+            lowLatency = true;
+        }
+        else if (strncmp(argv[i], "--server", 8) == 0) {
+            server = true;
+            if (argv[i][8] == '=') serverPort = (unsigned short)atoi(argv[i] + 9);
+        }
+        else if (strncmp(argv[i], "--connect=", 10) == 0) {
+            connectAddress = argv[i] + 10;
+        }
+        else if (strncmp(argv[i], "--net-loopback=", 15) == 0) {
+            server = true;
+            loopbackClients = std::max(0, atoi(argv[i] + 15));
+        }
+        else if (strncmp(argv[i], "--net-entities=", 15) == 0) {
+            seededEnemies = std::max(0, atoi(argv[i] + 15));
+        }
+        else if (strncmp(argv[i], "--net-ticks=", 12) == 0) {
+            maxTicks = std::max(0, atoi(argv[i] + 12));
+        }
+        else if (strncmp(argv[i], "--rewind-seconds=", 17) == 0) {
+            rewindSeconds = std::max(0.0f, (float)atof(argv[i] + 17));
+        }
+        else if (strncmp(argv[i], "--load=", 7) == 0) {
+            loadFile = argv[i] + 7;
+        }
+        else if (strncmp(argv[i], "--price=", 8) == 0) {
+            if (!SetShopPrice(economyConfig.pricing, argv[i] + 8)) {
+                TraceLog(LOG_WARNING, "ECONOMY: unknown price %s", argv[i] + 8);
+            }
+        }
+        else if (strncmp(argv[i], "--economy-sim", 13) == 0) {
+            economySim = true;
+            if (argv[i][13] == '=') economyConfig.runs = std::max(1, atoi(argv[i] + 14));
+        }
+        else if (strncmp(argv[i], "--economy-policy=", 17) == 0) {
+            for (int p = 0; p < BOT_POLICY_COUNT; p++) {
+                if (strcmp(BOT_POLICIES[p].name, argv[i] + 17) == 0) economyConfig.policies.push_back(p);
+            }
+        }
+        else if (strncmp(argv[i], "--economy-seconds=", 18) == 0) {
+            economyConfig.maxSeconds = std::max(1.0f, (float)atof(argv[i] + 18));
+        }
+        else if (strncmp(argv[i], "--economy-threads=", 18) == 0) {
+            economyConfig.threads = std::max(0, atoi(argv[i] + 18));
+        }
+        else if (strncmp(argv[i], "--economy-seed=", 15) == 0) {
+            economyConfig.seed = (unsigned int)strtoul(argv[i] + 15, nullptr, 10);
+        }
+        else if (strncmp(argv[i], "--capture=", 10) == 0) {
+            captureConfig.fileName = argv[i] + 10;
+        }
+        else if (strncmp(argv[i], "--capture-fps=", 14) == 0) {
+            captureConfig.fps = std::max(1, atoi(argv[i] + 14));
+        }
+        else if (strncmp(argv[i], "--rewind-check", 14) == 0) {
+            rewindCheckSeconds = REWIND_CHECK_DEFAULT_SECONDS;
+            if (argv[i][14] == '=') rewindCheckSeconds = std::max(PACING_SIM_DT, (float)atof(argv[i] + 15));
+        }
+    }
+
+    if (rewindCheckSeconds > 0) {
+        return RunRewindCheck(spawnConfig, economyConfig.pricing, economyConfig.seed, rewindCheckSeconds) ? 0 : 1;
+    }
+
+    if (economySim) {
+        RunEconomySimulator(economyConfig, spawnConfig);
+        return 0;
+    }
+
+    if (server) {
+        // Без InitWindow: ни GL-контекста, ни аудио, только симуляция
+        Game game(true);
+        game.ConfigureSpawnDirector(spawnConfig);
+        game.ConfigurePricing(economyConfig.pricing);
+        game.ConfigureRewind(std::max(0.0f, rewindSeconds));
+        game.RunServer(serverPort, loopbackClients, seededEnemies, maxTicks, loadFile);
+        return 0;
+    }
+
+    NetAddress serverAddress;
+    if (connectAddress && !ParseNetAddress(connectAddress, NET_DEFAULT_PORT, serverAddress)) {
+        TraceLog(LOG_ERROR, "NET: cannot resolve %s", connectAddress);
+        return 1;
+    }
+
     InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Odium - Survivor Game");
-    SetTargetFPS(60);
+    SetTargetFPS(PACING_GAME_FPS);
 
     Game game;
+    game.ConfigureSpawnDirector(spawnConfig);
+    game.ConfigureResolution(resolutionConfig);
+    game.ConfigurePacing(pacingMode, lowLatency);
+    game.ConfigurePricing(economyConfig.pricing);
+    game.ConfigureRewind(rewindSeconds < 0 ? REWIND_DEFAULT_SECONDS : rewindSeconds);
+    game.ConfigureCapture(captureConfig);
+    if (loadFile) game.LoadRun(loadFile);
+    if (connectAddress && !game.ConnectToServer(serverAddress)) {
+        TraceLog(LOG_ERROR, "NET: cannot open client socket");
+    }
     game.Run();
 
     CloseWindow();
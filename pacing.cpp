@@ -0,0 +1,95 @@
+﻿#include "pacing.h"
+
+void FramePacer::Configure(PacingMode newMode, bool newLateInput) {
+    mode = newMode;
+    lateInput = newLateInput;
+    applied = false;
+}
+
+int FramePacer::GetActiveFps() const {
+    switch (mode) {
+    case PACING_MODE_DISPLAY: {
+        int refreshRate = GetMonitorRefreshRate(GetCurrentMonitor());
+        return refreshRate > 0 ? refreshRate : PACING_GAME_FPS;
+    }
+    case PACING_MODE_UNCAPPED:
+        return 0;
+    default:
+        return PACING_GAME_FPS;
+    }
+}
+
+bool FramePacer::WaitForFrame() {
+    if (!lateInput || state != PACING_ACTIVE) return false;
+
+    int fps = GetActiveFps();
+    if (fps > 0) {
+        double period = 1.0 / fps;
+        double now = GetTime();
+        if (nextFrameTime == 0 || now > nextFrameTime + period) {
+            // Отстали больше чем на кадр - начинаем отсчет заново, без серии коротких кадров
+            nextFrameTime = now;
+        }
+        else if (nextFrameTime > now) {
+            WaitTime(nextFrameTime - now);
+        }
+        nextFrameTime += period;
+    }
+
+    PollInputEvents();
+    return true;
+}
+
+void FramePacer::Update(bool staticScreen, bool needsTimedRedraw) {
+    PacingState next;
+    if (staticScreen && !needsTimedRedraw) {
+        // Фокус, сворачивание и ввод - тоже события, так что ожидание покрывает и фон
+        next = PACING_EVENT_WAIT;
+    }
+    else if (IsWindowMinimized()) {
+        next = PACING_MINIMIZED;
+    }
+    else if (!IsWindowFocused()) {
+        next = PACING_UNFOCUSED;
+    }
+    else {
+        next = staticScreen ? PACING_STREAMING : PACING_ACTIVE;
+    }
+
+    if (!applied || next != state) {
+        Apply(next);
+        framesInState = 0;
+    }
+    framesInState++;
+}
+
+void FramePacer::Apply(PacingState newState) {
+    state = newState;
+    applied = true;
+
+    switch (state) {
+    case PACING_ACTIVE:
+        DisableEventWaiting();
+        // В режиме низкой задержки кадр ограничивает WaitForFrame, а не EndDrawing
+        SetTargetFPS(lateInput ? 0 : GetActiveFps());
+        nextFrameTime = 0;
+        break;
+    case PACING_EVENT_WAIT:
+        // Ограничение остается, чтобы поток движений мыши не разгонял цикл
+        SetTargetFPS(PACING_GAME_FPS);
+        EnableEventWaiting();
+        break;
+    case PACING_STREAMING:
+        DisableEventWaiting();
+        SetTargetFPS(PACING_STREAMING_FPS);
+        break;
+    case PACING_UNFOCUSED:
+        DisableEventWaiting();
+        SetTargetFPS(PACING_UNFOCUSED_FPS);
+        break;
+    case PACING_MINIMIZED:
+        DisableEventWaiting();
+        SetTargetFPS(PACING_MINIMIZED_FPS);
+        break;
+    }
+}
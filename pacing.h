@@ -0,0 +1,69 @@
+﻿#pragma once
+#include "raylib.h"
+
+const int PACING_GAME_FPS = 60;
+const int PACING_STREAMING_FPS = 20;  // Статичный экран, но играет музыка или идет загрузка
+const int PACING_UNFOCUSED_FPS = 10;
+const int PACING_MINIMIZED_FPS = 4;
+const float PACING_MAX_FRAME_TIME = 0.1f; // Шаг симуляции после ожидания или подвисания
+
+// Симуляция идет фиксированными тиками независимо от частоты кадров
+const int PACING_SIM_TICK_RATE = 60;
+const float PACING_SIM_DT = 1.0f / PACING_SIM_TICK_RATE;
+const int PACING_MAX_TICKS_PER_FRAME = 6;  // Больше - отставание сбрасывается, а не догоняется
+
+enum PacingMode {
+    PACING_MODE_FIXED = 0,  // Кадры с частотой симуляции
+    PACING_MODE_DISPLAY,    // Кадры с частотой монитора (120/144 Гц), позиции интерполируются
+    PACING_MODE_UNCAPPED    // Без ограничения
+};
+
+enum PacingState {
+    PACING_ACTIVE = 0,   // Геймплей: полная частота
+    PACING_EVENT_WAIT,   // Статичный экран: кадр только по событию ввода или окна
+    PACING_STREAMING,    // Статичный экран с таймером (музыка, загрузка): редкие кадры
+    PACING_UNFOCUSED,
+    PACING_MINIMIZED
+};
+
+// Управляет частотой кадров в зависимости от экрана и состояния окна.
+// На статичных экранах включается EnableEventWaiting: EndDrawing спит до
+// события, и цикл почти не тратит CPU. Музыке нужна регулярная подкачка
+// буфера, поэтому пока она играет (или грузятся ассеты), вместо ожидания
+// событий частота просто понижается.
+class FramePacer {
+public:
+    FramePacer() : state(PACING_ACTIVE), mode(PACING_MODE_FIXED), lateInput(false), applied(false),
+        framesInState(0), nextFrameTime(0) {}
+
+    // lateInput: ожидание кадра переносится из EndDrawing в WaitForFrame,
+    // чтобы ввод опрашивался прямо перед тиком и отрисовкой
+    void Configure(PacingMode newMode, bool newLateInput);
+
+    // Вызывать раз за итерацию цикла, до отрисовки
+    void Update(bool staticScreen, bool needsTimedRedraw);
+
+    // Режим низкой задержки: ждет начала кадра и заново опрашивает ввод.
+    // Возвращает true, если ввод был опрошен
+    bool WaitForFrame();
+
+    PacingState GetState() const { return state; }
+    PacingMode GetMode() const { return mode; }
+
+    // Частота кадров геймплея; 0 - без ограничения
+    int GetActiveFps() const;
+
+    // Время кадра отражает нагрузку: полная частота, и прошлый кадр не был ожиданием.
+    // Только такие кадры можно отдавать адаптивным регуляторам (разрешение, качество)
+    bool IsSteady() const { return state == PACING_ACTIVE && framesInState > 1; }
+
+private:
+    void Apply(PacingState newState);
+
+    PacingState state;
+    PacingMode mode;
+    bool lateInput;
+    bool applied;
+    int framesInState;
+    double nextFrameTime;
+};
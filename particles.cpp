@@ -0,0 +1,185 @@
+﻿#include "particles.h"
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PARTICLES_USE_SSE2 1
+#endif
+
+void ParticleSystem::Init(int newCapacity) {
+    capacity = (newCapacity + 3) / 4 * 4;
+    posX.assign(capacity, 0.0f);
+    posY.assign(capacity, 0.0f);
+    velX.assign(capacity, 0.0f);
+    velY.assign(capacity, 0.0f);
+    accelY.assign(capacity, 0.0f);
+    life.assign(capacity, 0.0f);
+    invMaxLife.assign(capacity, 0.0f);
+    effects.assign(capacity, 0);
+    Clear();
+}
+
+void ParticleSystem::Clear() {
+    std::fill(life.begin(), life.end(), 0.0f);
+    head = 0;
+    aliveCount = 0;
+    loadScale = 1.0f;
+    for (int e = 0; e < PARTICLE_EFFECT_COUNT; e++) {
+        effectAlive[e] = 0;
+        emitCarry[e] = 0;
+    }
+}
+
+float ParticleSystem::RandomFloat() {
+    // xorshift32: дешевле GetRandomValue и не трогает общий генератор
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return (rngState & 0xffffff) / 16777216.0f;
+}
+
+int ParticleSystem::Allowance(ParticleEffect effect, int wanted) const {
+    int total = budget - aliveCount;
+    int own = PARTICLE_EFFECTS[effect].cap - effectAlive[effect];
+    return std::max(0, std::min(wanted, std::min(total, own)));
+}
+
+void ParticleSystem::Spawn(ParticleEffect effect, Vector2 position, Vector2 velocity) {
+    // Кольцо: если слот еще жив, самая старая частица вытесняется
+    if (life[head] > 0) {
+        effectAlive[effects[head]]--;
+        aliveCount--;
+    }
+
+    const ParticleEffectDesc& desc = PARTICLE_EFFECTS[effect];
+    float duration = desc.life * (0.7f + 0.6f * RandomFloat());
+
+    posX[head] = position.x;
+    posY[head] = position.y;
+    velX[head] = velocity.x;
+    velY[head] = velocity.y;
+    accelY[head] = desc.rise;
+    life[head] = duration;
+    invMaxLife[head] = 1.0f / duration;
+    effects[head] = (unsigned char)effect;
+
+    effectAlive[effect]++;
+    aliveCount++;
+    head = (head + 1) % capacity;
+}
+
+void ParticleSystem::Emit(ParticleEffect effect, Vector2 position, float count) {
+    if (capacity == 0) return;
+
+    float scaled = count * loadScale + emitCarry[effect];
+    int wanted = (int)scaled;
+    emitCarry[effect] = scaled - wanted;
+
+    int allowed = Allowance(effect, wanted);
+    const ParticleEffectDesc& desc = PARTICLE_EFFECTS[effect];
+    for (int i = 0; i < allowed; i++) {
+        float angle = RandomFloat() * 2.0f * PI;
+        float speed = desc.speed * (0.4f + 0.6f * RandomFloat());
+        Spawn(effect, position, { cosf(angle) * speed, sinf(angle) * speed });
+    }
+}
+
+void ParticleSystem::EmitArc(Vector2 from, Vector2 to) {
+    if (capacity == 0) return;
+
+    float dx = to.x - from.x;
+    float dy = to.y - from.y;
+    float length = sqrtf(dx * dx + dy * dy);
+    if (length <= 0) return;
+
+    // При нагрузке дуга становится реже, но остается целой от начала до конца
+    int wanted = (int)(length / PARTICLE_ARC_STEP * loadScale) + 1;
+    int allowed = Allowance(PARTICLE_SPARK, wanted);
+
+    float normalX = -dy / length;
+    float normalY = dx / length;
+    const ParticleEffectDesc& desc = PARTICLE_EFFECTS[PARTICLE_SPARK];
+    for (int i = 0; i < allowed; i++) {
+        float t = (i + 0.5f) / allowed;
+        float jitter = (RandomFloat() - 0.5f) * 16.0f;
+        Vector2 position = { from.x + dx * t + normalX * jitter, from.y + dy * t + normalY * jitter };
+        float drift = (RandomFloat() - 0.5f) * 2.0f * desc.speed;
+        Spawn(PARTICLE_SPARK, position, { normalX * drift, normalY * drift });
+    }
+}
+
+void ParticleSystem::Update(float deltaTime, float frameTime) {
+    if (capacity == 0) return;
+
+    // Деградация: при долгих кадрах эмитим меньше, потом плавно возвращаемся
+    if (frameTime > PARTICLE_TARGET_FRAME_TIME) {
+        loadScale = std::max(0.1f, loadScale * 0.9f);
+    }
+    else {
+        loadScale = std::min(1.0f, loadScale + deltaTime * 0.5f);
+    }
+
+    float damping = std::max(0.0f, 1.0f - PARTICLE_DRAG * deltaTime);
+
+#ifdef PARTICLES_USE_SSE2
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    const __m128 damp = _mm_set1_ps(damping);
+    for (int i = 0; i < capacity; i += 4) {
+        __m128 vx = _mm_loadu_ps(&velX[i]);
+        __m128 vy = _mm_loadu_ps(&velY[i]);
+        __m128 ay = _mm_loadu_ps(&accelY[i]);
+
+        vy = _mm_add_ps(vy, _mm_mul_ps(ay, dt));
+        vx = _mm_mul_ps(vx, damp);
+        vy = _mm_mul_ps(vy, damp);
+
+        _mm_storeu_ps(&posX[i], _mm_add_ps(_mm_loadu_ps(&posX[i]), _mm_mul_ps(vx, dt)));
+        _mm_storeu_ps(&posY[i], _mm_add_ps(_mm_loadu_ps(&posY[i]), _mm_mul_ps(vy, dt)));
+        _mm_storeu_ps(&velX[i], vx);
+        _mm_storeu_ps(&velY[i], vy);
+        _mm_storeu_ps(&life[i], _mm_sub_ps(_mm_loadu_ps(&life[i]), dt));
+    }
+#else
+    for (int i = 0; i < capacity; i++) {
+        velY[i] += accelY[i] * deltaTime;
+        velX[i] *= damping;
+        velY[i] *= damping;
+        posX[i] += velX[i] * deltaTime;
+        posY[i] += velY[i] * deltaTime;
+        life[i] -= deltaTime;
+    }
+#endif
+
+    // Пересчет живых по видам (мертвые частицы просто остаются в кольце)
+    aliveCount = 0;
+    for (int e = 0; e < PARTICLE_EFFECT_COUNT; e++) effectAlive[e] = 0;
+    for (int i = 0; i < capacity; i++) {
+        if (life[i] <= 0) continue;
+        effectAlive[effects[i]]++;
+        aliveCount++;
+    }
+}
+
+void ParticleSystem::Draw(Vector2 cameraOffset, Vector2 viewSize) const {
+    if (aliveCount == 0) return;
+
+    // Все частицы - прямоугольники без текстуры, поэтому rlgl сводит их в один батч
+    BeginBlendMode(BLEND_ADDITIVE);
+    for (int i = 0; i < capacity; i++) {
+        if (life[i] <= 0) continue;
+
+        float x = posX[i] - cameraOffset.x;
+        float y = posY[i] - cameraOffset.y;
+        if (x < -10 || y < -10 || x > viewSize.x + 10 || y > viewSize.y + 10) continue;
+
+        const ParticleEffectDesc& desc = PARTICLE_EFFECTS[effects[i]];
+        float t = std::min(1.0f, life[i] * invMaxLife[i]);
+        float size = desc.size * (0.5f + 0.5f * t);
+
+        Color color = desc.color;
+        color.a = (unsigned char)(255 * t);
+        DrawRectangleV({ x - size / 2, y - size / 2 }, { size, size }, color);
+    }
+    EndBlendMode();
+}
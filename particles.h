@@ -0,0 +1,84 @@
+﻿#pragma once
+#include "raylib.h"
+#include <vector>
+
+// Виды частиц
+enum ParticleEffect {
+    PARTICLE_IMPACT = 0,  // Попадание и смерть врага
+    PARTICLE_EMBER,       // Угли от горящих врагов
+    PARTICLE_SPARK,       // Дуга цепной молнии
+    PARTICLE_WAVE,        // След волны Марса
+    PARTICLE_EFFECT_COUNT
+};
+
+struct ParticleEffectDesc {
+    int cap;          // Максимум живых частиц этого вида
+    float life;       // Время жизни (сек)
+    float speed;      // Начальная скорость
+    float rise;       // Ускорение по Y (отрицательное - вверх)
+    float size;
+    Color color;
+};
+
+const ParticleEffectDesc PARTICLE_EFFECTS[PARTICLE_EFFECT_COUNT] = {
+    { 1500, 0.35f, 220.0f,    0.0f, 5.0f, Color{ 255, 230, 180, 255 } },
+    { 1200, 0.80f,  30.0f, -120.0f, 4.0f, Color{ 255, 120, 20, 255 } },
+    {  800, 0.25f,  40.0f,    0.0f, 4.0f, Color{ 200, 220, 255, 255 } },
+    {  800, 0.45f,  60.0f,    0.0f, 6.0f, Color{ 255, 161, 0, 255 } },
+};
+
+const int PARTICLE_CAPACITY = 4096;               // Размер кольца, кратен 4 для SIMD
+const int PARTICLE_DEFAULT_BUDGET = 3000;         // Общий лимит живых частиц
+const float PARTICLE_DRAG = 3.0f;                 // Затухание скорости (1/сек)
+const float PARTICLE_TARGET_FRAME_TIME = 1.0f / 55.0f; // Дольше - начинаем эмитить меньше
+const float PARTICLE_ARC_STEP = 12.0f;            // Шаг частиц вдоль дуги молнии
+
+// Система частиц. Данные хранятся SoA-массивами в заранее выделенном кольце:
+// новые частицы пишутся по кругу поверх самых старых. Интеграция идет одним
+// SIMD-проходом (SSE2, иначе скалярно), отрисовка - одним батчем прямоугольников
+// в аддитивном режиме. При превышении бюджета или долгих кадрах частиц
+// эмитится меньше, а не теряются кадры.
+class ParticleSystem {
+public:
+    ParticleSystem() : capacity(0), head(0), budget(PARTICLE_DEFAULT_BUDGET), aliveCount(0),
+        loadScale(1.0f), rngState(0x9e3779b9u) {}
+
+    void Init(int newCapacity);
+    void Clear();
+
+    void SetBudget(int newBudget) { budget = newBudget; }
+    int GetBudget() const { return budget; }
+
+    // count может быть дробным: остаток переносится на следующие вызовы
+    void Emit(ParticleEffect effect, Vector2 position, float count);
+    void EmitArc(Vector2 from, Vector2 to);
+
+    void Update(float deltaTime, float frameTime);
+    void Draw(Vector2 cameraOffset, Vector2 viewSize) const;
+
+    int GetAliveCount() const { return aliveCount; }
+    float GetLoadScale() const { return loadScale; }
+
+private:
+    int Allowance(ParticleEffect effect, int wanted) const;
+    void Spawn(ParticleEffect effect, Vector2 position, Vector2 velocity);
+    float RandomFloat();
+
+    int capacity;
+    int head;
+    int budget;
+    int aliveCount;
+    int effectAlive[PARTICLE_EFFECT_COUNT] = {};
+    float emitCarry[PARTICLE_EFFECT_COUNT] = {};
+    float loadScale;
+    unsigned int rngState;
+
+    std::vector<float> posX;
+    std::vector<float> posY;
+    std::vector<float> velX;
+    std::vector<float> velY;
+    std::vector<float> accelY;
+    std::vector<float> life;
+    std::vector<float> invMaxLife;
+    std::vector<unsigned char> effects;
+};
@@ -0,0 +1,288 @@
+﻿#include "platform.h"
+
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#pragma comment(lib, "ws2_32.lib")
+#pragma comment(lib, "opengl32.lib")
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#endif
+
+bool MappedFile::Open(const char* fileName) {
+    Close();
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle = file;
+    mappingHandle = mapping;
+    data = (const unsigned char*)view;
+    size = (size_t)fileSize.QuadPart;
+#else
+    int file = open(fileName, O_RDONLY);
+    if (file < 0) return false;
+
+    struct stat info;
+    if (fstat(file, &info) != 0 || info.st_size == 0) {
+        close(file);
+        return false;
+    }
+
+    void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (view == MAP_FAILED) return false;
+
+    data = (const unsigned char*)view;
+    size = (size_t)info.st_size;
+#endif
+
+    return true;
+}
+
+void MappedFile::Close() {
+    if (!data) return;
+
+#if defined(_WIN32)
+    UnmapViewOfFile(data);
+    CloseHandle((HANDLE)mappingHandle);
+    CloseHandle((HANDLE)fileHandle);
+#else
+    munmap((void*)data, size);
+#endif
+
+    data = nullptr;
+    size = 0;
+    fileHandle = nullptr;
+    mappingHandle = nullptr;
+}
+
+bool ReplaceFileAtomic(const char* source, const char* target) {
+#if defined(_WIN32)
+    return MoveFileExA(source, target, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return rename(source, target) == 0;
+#endif
+}
+
+#if defined(_WIN32)
+typedef SOCKET NativeSocket;
+typedef int SocketLength;
+#else
+typedef int NativeSocket;
+typedef socklen_t SocketLength;
+#endif
+
+static bool InitSockets() {
+#if defined(_WIN32)
+    // WSAStartup считает вызовы сам, парный WSACleanup не обязателен до выхода
+    static bool started = false;
+    if (!started) {
+        WSADATA data;
+        started = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }
+    return started;
+#else
+    return true;
+#endif
+}
+
+bool ParseNetAddress(const char* text, unsigned short defaultPort, NetAddress& address) {
+    if (!InitSockets()) return false;
+
+    std::string host = text;
+    unsigned short port = defaultPort;
+    size_t colon = host.rfind(':');
+    if (colon != std::string::npos) {
+        port = (unsigned short)atoi(host.c_str() + colon + 1);
+        host.resize(colon);
+    }
+    if (host.empty() || port == 0) return false;
+
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host.c_str(), nullptr, &hints, &result) != 0 || !result) return false;
+
+    const sockaddr_in* resolved = (const sockaddr_in*)result->ai_addr;
+    address = NetAddress(ntohl(resolved->sin_addr.s_addr), port);
+    freeaddrinfo(result);
+    return true;
+}
+
+bool UdpSocket::Open(unsigned short bindPort) {
+    Close();
+    if (!InitSockets()) return false;
+
+    NativeSocket native = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+#if defined(_WIN32)
+    if (native == INVALID_SOCKET) return false;
+#else
+    if (native < 0) return false;
+#endif
+    handle = (unsigned long long)native;
+
+    sockaddr_in local;
+    std::memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(bindPort);
+    if (bind(native, (const sockaddr*)&local, sizeof(local)) != 0) {
+        Close();
+        return false;
+    }
+
+    // Снапшот большой орды - десятки датаграмм подряд, системных буферов по умолчанию мало
+    int bufferSize = 4 * 1024 * 1024;
+    setsockopt(native, SOL_SOCKET, SO_SNDBUF, (const char*)&bufferSize, sizeof(bufferSize));
+    setsockopt(native, SOL_SOCKET, SO_RCVBUF, (const char*)&bufferSize, sizeof(bufferSize));
+
+#if defined(_WIN32)
+    u_long nonBlocking = 1;
+    ioctlsocket(native, FIONBIO, &nonBlocking);
+#else
+    fcntl(native, F_SETFL, fcntl(native, F_GETFL, 0) | O_NONBLOCK);
+#endif
+
+    SocketLength length = sizeof(local);
+    getsockname(native, (sockaddr*)&local, &length);
+    port = ntohs(local.sin_port);
+    return true;
+}
+
+void UdpSocket::Close() {
+    if (handle == INVALID_HANDLE) return;
+
+#if defined(_WIN32)
+    closesocket((NativeSocket)handle);
+#else
+    close((NativeSocket)handle);
+#endif
+
+    handle = INVALID_HANDLE;
+    port = 0;
+}
+
+bool UdpSocket::Send(const NetAddress& to, const void* data, int size) {
+    if (handle == INVALID_HANDLE) return false;
+
+    sockaddr_in remote;
+    std::memset(&remote, 0, sizeof(remote));
+    remote.sin_family = AF_INET;
+    remote.sin_addr.s_addr = htonl(to.ip);
+    remote.sin_port = htons(to.port);
+    return sendto((NativeSocket)handle, (const char*)data, size, 0, (const sockaddr*)&remote, sizeof(remote)) == size;
+}
+
+int UdpSocket::Receive(void* buffer, int capacity, NetAddress& from) {
+    if (handle == INVALID_HANDLE) return -1;
+
+    sockaddr_in remote;
+    SocketLength length = sizeof(remote);
+    int received = (int)recvfrom((NativeSocket)handle, (char*)buffer, capacity, 0, (sockaddr*)&remote, &length);
+    if (received < 0) return -1;
+
+    from = NetAddress(ntohl(remote.sin_addr.s_addr), ntohs(remote.sin_port));
+    return received;
+}
+
+#if defined(_WIN32)
+bool IsAsyncInputSupported() {
+    return true;
+}
+
+bool IsAsyncWindowFocused(void* window) {
+    return window != nullptr && GetForegroundWindow() == (HWND)window;
+}
+
+bool IsAsyncKeyDown(int virtualKey) {
+    return (GetAsyncKeyState(virtualKey) & 0x8000) != 0;
+}
+
+bool GetAsyncCursor(void* window, float& x, float& y) {
+    POINT point;
+    if (!window || !GetCursorPos(&point) || !ScreenToClient((HWND)window, &point)) return false;
+    x = (float)point.x;
+    y = (float)point.y;
+    return true;
+}
+#else
+bool IsAsyncInputSupported() {
+    return false;
+}
+
+bool IsAsyncWindowFocused(void*) {
+    return false;
+}
+
+bool IsAsyncKeyDown(int) {
+    return false;
+}
+
+bool GetAsyncCursor(void*, float&, float&) {
+    return false;
+}
+#endif
+
+#if defined(_WIN32)
+void* GetGlProcAddress(const char* name) {
+    // wglGetProcAddress не отдает функции OpenGL 1.1 - они экспортируются из opengl32.dll
+    void* proc = (void*)wglGetProcAddress(name);
+    if (proc == nullptr || proc == (void*)1 || proc == (void*)2 || proc == (void*)3 || proc == (void*)-1) {
+        HMODULE library = GetModuleHandleA("opengl32.dll");
+        proc = library ? (void*)GetProcAddress(library, name) : nullptr;
+    }
+    return proc;
+}
+#else
+void* GetGlProcAddress(const char* name) {
+    // Контекст создан GLFW через GLX или EGL, библиотеки уже загружены в процесс
+    typedef void* (*ProcLoader)(const char*);
+    static ProcLoader glxLoader = (ProcLoader)dlsym(RTLD_DEFAULT, "glXGetProcAddressARB");
+    static ProcLoader eglLoader = (ProcLoader)dlsym(RTLD_DEFAULT, "eglGetProcAddress");
+
+    void* proc = glxLoader ? glxLoader(name) : nullptr;
+    if (!proc && eglLoader) proc = eglLoader(name);
+    if (!proc) proc = dlsym(RTLD_DEFAULT, name);
+    return proc;
+}
+#endif
@@ -0,0 +1,92 @@
+﻿#pragma once
+#include <cstddef>
+
+// Платформенные вещи, которые нельзя смешивать с raylib.h
+// (windows.h конфликтует с именами raylib), поэтому здесь без raylib.
+
+// Файл, отображенный в память только для чтения
+class MappedFile {
+public:
+    MappedFile() : data(nullptr), size(0), fileHandle(nullptr), mappingHandle(nullptr) {}
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const char* fileName);
+    void Close();
+
+    const unsigned char* GetData() const { return data; }
+    size_t GetSize() const { return size; }
+
+private:
+    const unsigned char* data;
+    size_t size;
+    void* fileHandle;
+    void* mappingHandle;
+};
+
+// Переименовывает source в target, заменяя target одним шагом: при сбое
+// на диске остается либо старый файл, либо новый
+bool ReplaceFileAtomic(const char* source, const char* target);
+
+// Адрес IPv4, ip и порт в порядке байт хоста
+struct NetAddress {
+    unsigned int ip;
+    unsigned short port;
+
+    NetAddress() : ip(0), port(0) {}
+    NetAddress(unsigned int newIp, unsigned short newPort) : ip(newIp), port(newPort) {}
+
+    bool operator==(const NetAddress& other) const { return ip == other.ip && port == other.port; }
+};
+
+const unsigned int NET_LOOPBACK_IP = 0x7f000001;  // 127.0.0.1
+
+// "host:port" или "host"; имя хоста резолвится через getaddrinfo
+bool ParseNetAddress(const char* text, unsigned short defaultPort, NetAddress& address);
+
+// Неблокирующий UDP-сокет
+class UdpSocket {
+public:
+    UdpSocket() : handle(INVALID_HANDLE), port(0) {}
+    ~UdpSocket() { Close(); }
+
+    UdpSocket(const UdpSocket&) = delete;
+    UdpSocket& operator=(const UdpSocket&) = delete;
+
+    // port 0 - любой свободный
+    bool Open(unsigned short bindPort);
+    void Close();
+
+    bool Send(const NetAddress& to, const void* data, int size);
+
+    // Размер принятой датаграммы или -1, если очередь пуста
+    int Receive(void* buffer, int capacity, NetAddress& from);
+
+    bool IsOpen() const { return handle != INVALID_HANDLE; }
+    unsigned short GetPort() const { return port; }
+
+private:
+    static const unsigned long long INVALID_HANDLE = ~0ull;
+
+    unsigned long long handle;
+    unsigned short port;
+};
+
+// Опрос клавиатуры и мыши в обход очереди сообщений окна: его можно звать
+// из любого потока, поэтому на нем работает поток сэмплирования ввода.
+// Коды клавиш платформенные (virtual-key на Windows). Где такого опроса
+// нет, IsAsyncInputSupported возвращает false
+bool IsAsyncInputSupported();
+
+// Окно (HWND из GetWindowHandle) в фокусе: чужие нажатия не считаются
+bool IsAsyncWindowFocused(void* window);
+bool IsAsyncKeyDown(int virtualKey);
+
+// Курсор в координатах клиентской области окна
+bool GetAsyncCursor(void* window, float& x, float& y);
+
+// Адрес функции OpenGL текущего контекста (для того, чего нет в rlgl).
+// nullptr, если драйвер ее не дает
+void* GetGlProcAddress(const char* name);
@@ -0,0 +1,17 @@
+#include "projectail.h"
+
+void ProjectileExpiryQueue::Push(Entity projectile, unsigned int expireTick) {
+    expiries.push({ expireTick, order++, projectile });
+}
+
+bool ProjectileExpiryQueue::PopExpired(unsigned int tick, Entity& projectile) {
+    if (expiries.empty() || expiries.top().tick > tick) return false;
+    projectile = expiries.top().projectile;
+    expiries.pop();
+    return true;
+}
+
+void ProjectileExpiryQueue::Clear() {
+    expiries = decltype(expiries)();
+    order = 0;
+}
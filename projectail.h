@@ -0,0 +1,47 @@
+﻿#pragma once
+#include "world.h"
+#include <queue>
+#include <vector>
+
+// Что делает снаряд, пролетевший всю дальность. Номера входят в снимки мира
+enum ProjectileExpireEffect {
+    EXPIRE_NONE = 0,
+    EXPIRE_EXPLOSION,    // Урон и эффекты снаряда всем врагам в радиусе
+};
+
+const float PROJECTILE_EXPLOSION_RADIUS = 90.0f;
+
+// Очередь истечения снарядов. Снаряд кладется один раз при создании с тиком,
+// на котором кончается его дальность; за тик смотрится только вершина кучи,
+// поэтому живые снаряды не перебираются ради проверки срока.
+// Записи снарядов, уничтоженных раньше (попадание, край карты), остаются до
+// своего тика - вызывающий отбрасывает их, когда World::Get не находит снаряд
+class ProjectileExpiryQueue {
+public:
+    ProjectileExpiryQueue() : order(0) {}
+
+    void Push(Entity projectile, unsigned int expireTick);
+
+    // По одному снаряду с expireTick <= tick; при равных тиках - в порядке добавления
+    bool PopExpired(unsigned int tick, Entity& projectile);
+
+    void Clear();
+    int GetSize() const { return (int)expiries.size(); }
+
+private:
+    struct Expiry {
+        unsigned int tick;
+        unsigned long long order;
+        Entity projectile;
+    };
+
+    // Вершина кучи - ближайшее истечение
+    struct ExpiresLater {
+        bool operator()(const Expiry& a, const Expiry& b) const {
+            return a.tick != b.tick ? a.tick > b.tick : a.order > b.order;
+        }
+    };
+
+    std::priority_queue<Expiry, std::vector<Expiry>, ExpiresLater> expiries;
+    unsigned long long order;
+};
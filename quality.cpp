@@ -0,0 +1,189 @@
+﻿#include "quality.h"
+#include "enemy.h"
+#include "platform.h"
+#include <algorithm>
+
+#if defined(_WIN32)
+#define QUALITY_GLAPI __stdcall
+#else
+#define QUALITY_GLAPI
+#endif
+
+// Синтетическая нагрузка: орда идет по полю потоков с расталкиванием
+// и рисуется с полосками здоровья в оффскрин-таргет размера окна
+struct QualityManager::BenchmarkRun {
+    World horde;
+    std::vector<Vector2> positions;
+    FlowField field;
+    RenderTexture2D target;
+    Vector2 viewOffset;
+    int frame;
+    double elapsed;        // Только время внутри шагов: кадры меню между ними не считаются
+    void (QUALITY_GLAPI* finish)();   // glFinish; без него - синхронное чтение таргета
+};
+
+void QualityManager::StartBenchmark() {
+    StopBenchmark();
+    benchmark = new BenchmarkRun();
+
+    Vector2 worldSize = { 2000, 2000 };
+    Vector2 center = { worldSize.x / 2, worldSize.y / 2 };
+
+    RegisterGameComponents(benchmark->horde);
+    for (int i = 0; i < QUALITY_BENCHMARK_ENEMIES; i++) {
+        CreateEnemy(benchmark->horde, Vector2{ (float)GetRandomValue(0, (int)worldSize.x - 1), (float)GetRandomValue(0, (int)worldSize.y - 1) });
+    }
+
+    benchmark->field.Init(worldSize, FLOW_FIELD_CELL_SIZE);
+    benchmark->field.Update(center);
+
+    benchmark->target = LoadRenderTexture(SCREEN_WIDTH, SCREEN_HEIGHT);
+    benchmark->viewOffset = { center.x - SCREEN_WIDTH / 2, center.y - SCREEN_HEIGHT / 2 };
+    benchmark->frame = 0;
+    benchmark->elapsed = 0;
+    benchmark->finish = (void (QUALITY_GLAPI*)())GetGlProcAddress("glFinish");
+}
+
+bool QualityManager::StepBenchmark(int frames) {
+    if (!benchmark) return false;
+
+    BenchmarkRun& run = *benchmark;
+    float deltaTime = 1.0f / 60.0f;
+
+    double startTime = GetTime();
+    for (int i = 0; i < frames && run.frame < QUALITY_BENCHMARK_FRAMES; i++, run.frame++) {
+        run.positions.clear();
+        run.horde.Each<EnemyTag, Placement>([&](EnemyTag&, Placement& placement) { run.positions.push_back(placement.position); });
+        run.field.BuildAgentGrid(run.positions);
+
+        int index = 0;
+        run.horde.Each<EnemyTag, Placement>([&](EnemyTag&, Placement& placement) {
+            Vector2 direction = run.field.GetDirection(placement.position);
+            Vector2 separation = run.field.GetSeparation(run.positions, index++);
+            placement.position.x += (direction.x * 110.0f + separation.x * ENEMY_SEPARATION_STRENGTH) * deltaTime;
+            placement.position.y += (direction.y * 110.0f + separation.y * ENEMY_SEPARATION_STRENGTH) * deltaTime;
+        });
+
+        BeginTextureMode(run.target);
+        ClearBackground(BLACK);
+        run.horde.Each<EnemyTag, Placement>([&](EnemyTag&, Placement& placement) {
+            int x = (int)(placement.position.x - run.viewOffset.x);
+            int y = (int)(placement.position.y - run.viewOffset.y);
+            DrawRectangle(x - 20, y - 20, 40, 40, BLUE);
+            DrawRectangle(x - 20, y - 30, 40, 5, RED);
+            DrawRectangle(x - 20, y - 30, 30, 5, GREEN);
+        });
+        EndTextureMode();
+    }
+
+    // Шаг ждет GPU: программные растеризаторы рисуют лениво, и без этого
+    // работа шага досталась бы кадру меню
+    if (run.finish) {
+        run.finish();
+    }
+    else {
+        Image image = LoadImageFromTexture(run.target.texture);
+        UnloadImage(image);
+    }
+    run.elapsed += GetTime() - startTime;
+
+    if (run.frame < QUALITY_BENCHMARK_FRAMES) return false;
+    FinishBenchmark();
+    return true;
+}
+
+void QualityManager::FinishBenchmark() {
+    benchmarkMs = (float)(benchmark->elapsed * 1000.0 / QUALITY_BENCHMARK_FRAMES);
+    StopBenchmark();
+
+    if (benchmarkMs < QUALITY_BENCHMARK_HIGH_MS) benchmarkTier = QUALITY_HIGH;
+    else if (benchmarkMs < QUALITY_BENCHMARK_MEDIUM_MS) benchmarkTier = QUALITY_MEDIUM;
+    else benchmarkTier = QUALITY_LOW;
+
+    // Ручной уровень не трогаем; автоматический мог уже опуститься по кадрам
+    if (automatic) {
+        tier = std::min(tier, benchmarkTier);
+        ResetWindow();
+    }
+    TraceLog(LOG_INFO, "QUALITY: benchmark %.2f ms/frame, tier %s", benchmarkMs, QUALITY_TIERS[benchmarkTier].name);
+}
+
+void QualityManager::StopBenchmark() {
+    if (!benchmark) return;
+    UnloadRenderTexture(benchmark->target);
+    delete benchmark;
+    benchmark = nullptr;
+}
+
+void QualityManager::SetAutomatic(bool enabled) {
+    automatic = enabled;
+    if (automatic) tier = benchmarkTier;
+    ResetWindow();
+}
+
+void QualityManager::SetTier(QualityTier newTier) {
+    automatic = false;
+    tier = newTier;
+    ResetWindow();
+}
+
+void QualityManager::ResetWindow() {
+    frameTimes.assign(QUALITY_WINDOW_FRAMES, 0.0f);
+    frameIndex = 0;
+    frameCount = 0;
+    evaluateTimer = 0;
+    steadyTime = 0;
+}
+
+float QualityManager::Percentile(float fraction) {
+    sorted.assign(frameTimes.begin(), frameTimes.begin() + frameCount);
+    int index = std::min(frameCount - 1, (int)(fraction * frameCount));
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
+bool QualityManager::Update(float frameTime) {
+    if (frameTimes.empty()) ResetWindow();
+
+    frameTimes[frameIndex] = frameTime;
+    frameIndex = (frameIndex + 1) % QUALITY_WINDOW_FRAMES;
+    frameCount = std::min(frameCount + 1, QUALITY_WINDOW_FRAMES);
+
+    cooldown = std::max(0.0f, cooldown - frameTime);
+    evaluateTimer += frameTime;
+    if (!automatic || evaluateTimer < QUALITY_EVALUATE_INTERVAL) return false;
+    evaluateTimer = 0;
+
+    // Пока окно не наполнилось наполовину, перцентиль слишком шумный
+    if (frameCount < QUALITY_WINDOW_FRAMES / 2) return false;
+
+    float p95 = Percentile(0.95f);
+
+    if (p95 > QUALITY_TARGET_FRAME_TIME * QUALITY_DOWNGRADE_RATIO) {
+        steadyTime = 0;
+        if (cooldown <= 0 && tier > QUALITY_LOW) {
+            tier = (QualityTier)(tier - 1);
+            cooldown = QUALITY_CHANGE_COOLDOWN;
+            ResetWindow();
+            TraceLog(LOG_INFO, "QUALITY: p95 %.1f ms, lowering to %s", p95 * 1000.0f, QUALITY_TIERS[tier].name);
+            return true;
+        }
+        return false;
+    }
+
+    if (p95 < QUALITY_TARGET_FRAME_TIME * QUALITY_UPGRADE_RATIO) {
+        steadyTime += QUALITY_EVALUATE_INTERVAL;
+    }
+    else {
+        steadyTime = 0;
+    }
+
+    if (steadyTime >= QUALITY_UPGRADE_DELAY && cooldown <= 0 && tier < benchmarkTier) {
+        tier = (QualityTier)(tier + 1);
+        cooldown = QUALITY_CHANGE_COOLDOWN;
+        ResetWindow();
+        TraceLog(LOG_INFO, "QUALITY: frame times steady, raising to %s", QUALITY_TIERS[tier].name);
+        return true;
+    }
+    return false;
+}
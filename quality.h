@@ -0,0 +1,98 @@
+﻿#pragma once
+#include "raylib.h"
+#include <vector>
+
+enum QualityTier {
+    QUALITY_LOW = 0,
+    QUALITY_MEDIUM,
+    QUALITY_HIGH,
+    QUALITY_TIER_COUNT
+};
+
+// Что меняется между уровнями качества
+struct QualitySettings {
+    const char* name;
+    bool enemyHealthBars;      // Полоски здоровья над каждым врагом
+    float minimapRefreshRate;  // Гц
+    int particleBudget;
+    float lodActiveRadius;     // Радиус полной симуляции врагов (не меньше радиуса боя 300)
+    bool parallaxBackground;   // Фон с параллаксом; без него рисуются только тайлы уровня
+};
+
+const QualitySettings QUALITY_TIERS[QUALITY_TIER_COUNT] = {
+    { "LOW",    false,  4.0f,  800, 380.0f, false },
+    { "MEDIUM", true,   8.0f, 1800, 440.0f, true },
+    { "HIGH",   true,  10.0f, 3000, 500.0f, true },
+};
+
+// Стартовый бенчмарк: симуляция и отрисовка сгенерированной орды
+const int QUALITY_BENCHMARK_ENEMIES = 800;
+const int QUALITY_BENCHMARK_FRAMES = 30;
+const int QUALITY_BENCHMARK_FRAMES_PER_STEP = 2;   // Кадров бенчмарка на кадр меню
+const float QUALITY_BENCHMARK_HIGH_MS = 6.0f;   // Быстрее - HIGH
+const float QUALITY_BENCHMARK_MEDIUM_MS = 12.0f; // Быстрее - MEDIUM, иначе LOW
+
+// Подстройка во время игры по перцентилям времени кадра
+const int QUALITY_WINDOW_FRAMES = 120;
+const float QUALITY_TARGET_FRAME_TIME = 1.0f / 60.0f;
+const float QUALITY_EVALUATE_INTERVAL = 1.0f;
+const float QUALITY_DOWNGRADE_RATIO = 1.3f;     // p95 дольше цели на 30% - понижаем
+const float QUALITY_UPGRADE_RATIO = 1.1f;       // p95 в пределах 10% от цели - кадр ровный
+const float QUALITY_UPGRADE_DELAY = 15.0f;      // Сек ровных кадров перед повышением
+const float QUALITY_CHANGE_COOLDOWN = 5.0f;
+
+// Менеджер качества: уровень выбирается стартовым бенчмарком и затем
+// понижается по 95-му перцентилю времени кадра за скользящее окно.
+// Повышение возможно только обратно до уровня, выбранного бенчмарком.
+class QualityManager {
+public:
+    QualityManager() : tier(QUALITY_HIGH), benchmarkTier(QUALITY_HIGH), automatic(true), benchmarkMs(0),
+        frameIndex(0), frameCount(0), evaluateTimer(0), cooldown(0), steadyTime(0), benchmark(nullptr) {}
+    ~QualityManager() { StopBenchmark(); }
+
+    QualityManager(const QualityManager&) = delete;
+    QualityManager& operator=(const QualityManager&) = delete;
+
+    // Бенчмарк идет по нескольку кадров за StepBenchmark, пока открыто меню,
+    // и не задерживает первый кадр. До его конца действует уровень по умолчанию.
+    // Нужен GL-контекст
+    void StartBenchmark();
+
+    // true на том шаге, где бенчмарк закончился и уровень мог смениться
+    bool StepBenchmark(int frames);
+    bool IsBenchmarkRunning() const { return benchmark != nullptr; }
+
+    // Возвращает true, если уровень изменился
+    bool Update(float frameTime);
+
+    void SetAutomatic(bool enabled);
+    void SetTier(QualityTier newTier);
+    bool IsAutomatic() const { return automatic; }
+
+    QualityTier GetTier() const { return tier; }
+    const QualitySettings& GetSettings() const { return QUALITY_TIERS[tier]; }
+    float GetBenchmarkMs() const { return benchmarkMs; }
+
+private:
+    struct BenchmarkRun;
+
+    void FinishBenchmark();
+    void StopBenchmark();
+    float Percentile(float fraction);
+    void ResetWindow();
+
+    QualityTier tier;
+    QualityTier benchmarkTier;
+    bool automatic;
+    float benchmarkMs;
+
+    std::vector<float> frameTimes;
+    std::vector<float> sorted;
+    int frameIndex;
+    int frameCount;
+    float evaluateTimer;
+    float cooldown;
+    float steadyTime;
+
+    BenchmarkRun* benchmark;
+};
@@ -0,0 +1,416 @@
+﻿#include "render.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    const int DEFAULT_FONT_SIZE = 10;
+}
+
+TextCache::TextRun& TextCache::GetRun(const char* text, int fontSize, bool needLayout) {
+    key.assign(text);
+    key.push_back('\x1f');
+    key.append(std::to_string(fontSize));
+
+    auto it = runs.find(key);
+    if (it == runs.end()) {
+        if ((int)runs.size() >= TEXT_CACHE_MAX_RUNS) {
+            runs.clear();
+        }
+        it = runs.emplace(key, TextRun()).first;
+        it->second.width = MeasureText(text, fontSize);
+    }
+
+    if (needLayout && !it->second.hasLayout) {
+        BuildLayout(it->second, text, fontSize);
+    }
+    return it->second;
+}
+
+void TextCache::BuildLayout(TextRun& run, const char* text, int fontSize) {
+    // Повторяет раскладку DrawText для однострочного текста
+    Font font = GetFontDefault();
+    if (fontSize < DEFAULT_FONT_SIZE) fontSize = DEFAULT_FONT_SIZE;
+    float spacing = (float)(fontSize / DEFAULT_FONT_SIZE);
+    float scale = (float)fontSize / font.baseSize;
+    float padding = (float)font.glyphPadding;
+    float offsetX = 0;
+
+    run.sources.clear();
+    run.destinations.clear();
+
+    for (const char* c = text; *c; c++) {
+        int codepoint = (unsigned char)*c;
+        int index = GetGlyphIndex(font, codepoint);
+
+        if (codepoint != ' ' && codepoint != '\t') {
+            Rectangle rec = font.recs[index];
+            run.sources.push_back({ rec.x - padding, rec.y - padding, rec.width + 2 * padding, rec.height + 2 * padding });
+            run.destinations.push_back({
+                offsetX + font.glyphs[index].offsetX * scale - padding * scale,
+                font.glyphs[index].offsetY * scale - padding * scale,
+                (rec.width + 2 * padding) * scale,
+                (rec.height + 2 * padding) * scale
+            });
+        }
+
+        if (font.glyphs[index].advanceX == 0) offsetX += font.recs[index].width * scale + spacing;
+        else offsetX += font.glyphs[index].advanceX * scale + spacing;
+    }
+
+    run.hasLayout = true;
+}
+
+int TextCache::Measure(const char* text, int fontSize) {
+    return GetRun(text, fontSize, false).width;
+}
+
+void TextCache::Draw(const char* text, int posX, int posY, int fontSize, Color color) {
+    // Многострочный и не-ASCII текст рисуется штатно
+    for (const char* c = text; *c; c++) {
+        if (*c == '\n' || (unsigned char)*c >= 0x80) {
+            DrawText(text, posX, posY, fontSize, color);
+            return;
+        }
+    }
+
+    Font font = GetFontDefault();
+    if (font.texture.id == 0) return;
+
+    const TextRun& run = GetRun(text, fontSize, true);
+    for (size_t i = 0; i < run.sources.size(); i++) {
+        Rectangle dest = run.destinations[i];
+        dest.x += posX;
+        dest.y += posY;
+        DrawTexturePro(font.texture, run.sources[i], dest, { 0, 0 }, 0, color);
+    }
+}
+
+void TextCache::DrawCentered(const char* text, int centerX, int posY, int fontSize, Color color) {
+    Draw(text, centerX - Measure(text, fontSize) / 2, posY, fontSize, color);
+}
+
+void RetainedHud::Init(int width, int height) {
+    Unload();
+    target = LoadRenderTexture(width, height);
+    dirty = true;
+}
+
+void RetainedHud::Unload() {
+    if (target.id != 0) {
+        UnloadRenderTexture(target);
+        target = {};
+    }
+    widgets.clear();
+}
+
+int RetainedHud::AddLabel(int x, int y, int fontSize, Color color, const std::string& text) {
+    HudWidget widget;
+    widget.x = x;
+    widget.y = y;
+    widget.fontSize = fontSize;
+    widget.color = color;
+    widget.prefix = text;
+    FormatText(widget);
+    widgets.push_back(widget);
+    dirty = true;
+    return (int)widgets.size() - 1;
+}
+
+int RetainedHud::AddValue(int x, int y, int fontSize, Color color, const std::string& prefix, const std::string& suffix) {
+    int id = AddLabel(x, y, fontSize, color, prefix);
+    widgets[id].valueCount = 1;
+    widgets[id].suffix = suffix;
+    FormatText(widgets[id]);
+    return id;
+}
+
+int RetainedHud::AddPair(int x, int y, int fontSize, Color color, const std::string& prefix, const std::string& separator) {
+    int id = AddLabel(x, y, fontSize, color, prefix);
+    widgets[id].valueCount = 2;
+    widgets[id].separator = separator;
+    FormatText(widgets[id]);
+    return id;
+}
+
+int RetainedHud::AddBar(int x, int y, int width, int height, Color fillColor, Color backColor) {
+    HudWidget widget;
+    widget.kind = HUD_BAR;
+    widget.x = x;
+    widget.y = y;
+    widget.width = width;
+    widget.height = height;
+    widget.color = fillColor;
+    widget.backColor = backColor;
+    widget.valueCount = 2;
+    widgets.push_back(widget);
+    dirty = true;
+    return (int)widgets.size() - 1;
+}
+
+void RetainedHud::SetValue(int widget, int value) {
+    HudWidget& w = widgets[widget];
+    if (w.value == value) return;
+
+    w.value = value;
+    FormatText(w);
+    dirty = true;
+}
+
+void RetainedHud::SetValues(int widget, int value, int secondValue) {
+    HudWidget& w = widgets[widget];
+    if (w.value == value && w.secondValue == secondValue) return;
+
+    w.value = value;
+    w.secondValue = secondValue;
+    FormatText(w);
+    dirty = true;
+}
+
+void RetainedHud::SetVisible(int widget, bool visible) {
+    if (widgets[widget].visible == visible) return;
+
+    widgets[widget].visible = visible;
+    dirty = true;
+}
+
+void RetainedHud::FormatText(HudWidget& widget) {
+    if (widget.kind != HUD_TEXT) return;
+
+    widget.text = widget.prefix;
+    if (widget.valueCount >= 1) widget.text += std::to_string(widget.value);
+    if (widget.valueCount >= 2) widget.text += widget.separator + std::to_string(widget.secondValue);
+    widget.text += widget.suffix;
+}
+
+void RetainedHud::Rebuild(TextCache& textCache) {
+    if (!dirty || target.id == 0) return;
+
+    BeginTextureMode(target);
+    ClearBackground(BLANK);
+    for (const auto& widget : widgets) {
+        if (!widget.visible) continue;
+
+        if (widget.kind == HUD_BAR) {
+            float percent = widget.secondValue > 0 ? (float)widget.value / widget.secondValue : 0;
+            percent = std::max(0.0f, std::min(1.0f, percent));
+            DrawRectangle(widget.x, widget.y, widget.width, widget.height, widget.backColor);
+            DrawRectangle(widget.x, widget.y, (int)(widget.width * percent), widget.height, widget.color);
+        }
+        else {
+            textCache.Draw(widget.text.c_str(), widget.x, widget.y, widget.fontSize, widget.color);
+        }
+    }
+    EndTextureMode();
+
+    dirty = false;
+}
+
+void RetainedHud::Draw(int posX, int posY) const {
+    if (target.id == 0) return;
+
+    // Текстуры рендер-таргетов перевернуты по Y
+    Rectangle source = { 0, 0, (float)target.texture.width, -(float)target.texture.height };
+    DrawTextureRec(target.texture, source, { (float)posX, (float)posY }, WHITE);
+}
+
+void Minimap::Init(int newSize, int newBins) {
+    Unload();
+    size = newSize;
+    bins = std::max(1, std::min(newSize, newBins));
+
+    target = LoadRenderTexture(size, size);
+
+    Image image = GenImageColor(bins, bins, DARKGREEN);
+    heatmap = LoadTextureFromImage(image);
+    UnloadImage(image);
+    SetTextureFilter(heatmap, TEXTURE_FILTER_POINT);
+
+    counts.assign(bins * bins, 0);
+    pixels.assign(bins * bins, DARKGREEN);
+    needsRefresh = true;
+}
+
+void Minimap::Unload() {
+    if (target.id != 0) {
+        UnloadRenderTexture(target);
+        target = {};
+    }
+    if (heatmap.id != 0) {
+        UnloadTexture(heatmap);
+        heatmap = {};
+    }
+}
+
+void Minimap::Update(float deltaTime, Vector2 mapSize, World& world, const std::vector<EnemySwarm>& swarms) {
+    refreshTimer += deltaTime;
+    float interval = refreshRate > 0 ? 1.0f / refreshRate : 0;
+    if (!needsRefresh && refreshTimer < interval) return;
+
+    refreshTimer = 0;
+    needsRefresh = false;
+
+    int total = world.Count<EnemyTag>();
+    for (const auto& swarm : swarms) total += swarm.count;
+
+    showingDensity = mode == MINIMAP_DENSITY || (mode == MINIMAP_AUTO && total >= MINIMAP_DENSITY_THRESHOLD);
+    if (showingDensity) {
+        RenderDensity(mapSize, world, swarms);
+    }
+    else {
+        RenderDots(mapSize, world, swarms);
+    }
+}
+
+void Minimap::RenderDots(Vector2 mapSize, World& world, const std::vector<EnemySwarm>& swarms) {
+    if (target.id == 0) return;
+
+    float scaleX = (float)size / mapSize.x;
+    float scaleY = (float)size / mapSize.y;
+
+    BeginTextureMode(target);
+    ClearBackground(DARKGREEN);
+
+    world.Each<EnemyTag, Placement>([&](EnemyTag&, Placement& placement) {
+        int enemyX = (int)(placement.position.x * scaleX);
+        int enemyY = (int)(placement.position.y * scaleY);
+
+        DrawRectangle(enemyX - 2, enemyY - 2, 4, 4, BLUE);
+    });
+
+    // Рои рисуются одной точкой, размер растет с числом участников
+    for (const auto& swarm : swarms) {
+        int swarmX = (int)(swarm.position.x * scaleX);
+        int swarmY = (int)(swarm.position.y * scaleY);
+        int swarmSize = 4 + (int)std::sqrt((float)swarm.count);
+
+        DrawRectangle(swarmX - swarmSize / 2, swarmY - swarmSize / 2, swarmSize, swarmSize, DARKBLUE);
+    }
+
+    EndTextureMode();
+}
+
+void Minimap::RenderDensity(Vector2 mapSize, World& world, const std::vector<EnemySwarm>& swarms) {
+    if (heatmap.id == 0) return;
+
+    std::fill(counts.begin(), counts.end(), 0);
+    float scaleX = (float)bins / mapSize.x;
+    float scaleY = (float)bins / mapSize.y;
+
+    world.Each<EnemyTag, Placement>([&](EnemyTag&, Placement& placement) {
+        int bx = std::max(0, std::min(bins - 1, (int)(placement.position.x * scaleX)));
+        int by = std::max(0, std::min(bins - 1, (int)(placement.position.y * scaleY)));
+        counts[by * bins + bx]++;
+    });
+
+    for (const auto& swarm : swarms) {
+        int bx = std::max(0, std::min(bins - 1, (int)(swarm.position.x * scaleX)));
+        int by = std::max(0, std::min(bins - 1, (int)(swarm.position.y * scaleY)));
+        counts[by * bins + bx] += swarm.count;
+    }
+
+    // Логарифмическая шкала: от синего к красному
+    float saturation = std::log2(1.0f + MINIMAP_DENSITY_SATURATION);
+    for (int i = 0; i < bins * bins; i++) {
+        if (counts[i] == 0) {
+            pixels[i] = DARKGREEN;
+            continue;
+        }
+
+        float t = std::min(1.0f, std::log2(1.0f + counts[i]) / saturation);
+        pixels[i] = Color{
+            (unsigned char)(40 + 215 * t),
+            (unsigned char)(80 * (1.0f - t) + 60 * t),
+            (unsigned char)(240 * (1.0f - t)),
+            255
+        };
+    }
+
+    UpdateTexture(heatmap, pixels.data());
+}
+
+void Minimap::Draw(int posX, int posY, Vector2 mapSize, Vector2 playerPosition) const {
+    Rectangle dest = { (float)posX, (float)posY, (float)size, (float)size };
+
+    if (showingDensity && heatmap.id != 0) {
+        DrawTexturePro(heatmap, { 0, 0, (float)bins, (float)bins }, dest, { 0, 0 }, 0, WHITE);
+    }
+    else if (target.id != 0) {
+        // Текстуры рендер-таргетов перевернуты по Y
+        DrawTexturePro(target.texture, { 0, 0, (float)size, -(float)size }, dest, { 0, 0 }, 0, WHITE);
+    }
+
+    DrawRectangleLines(posX, posY, size, size, WHITE);
+
+    int playerX = posX + (int)(playerPosition.x * size / mapSize.x);
+    int playerY = posY + (int)(playerPosition.y * size / mapSize.y);
+    DrawRectangle(playerX - 3, playerY - 3, 6, 6, RED);
+}
+
+void DynamicResolution::Init(int newWidth, int newHeight) {
+    Unload();
+    width = newWidth;
+    height = newHeight;
+    target = LoadRenderTexture(width, height);
+    SetTextureFilter(target.texture, TEXTURE_FILTER_BILINEAR);
+    scale = config.enabled ? config.maxScale : 1.0f;
+}
+
+void DynamicResolution::Unload() {
+    if (target.id != 0) {
+        UnloadRenderTexture(target);
+        target = {};
+    }
+}
+
+void DynamicResolution::Configure(const DynamicResolutionConfig& newConfig) {
+    config = newConfig;
+    config.minScale = std::max(0.25f, std::min(1.0f, config.minScale));
+    config.maxScale = std::max(config.minScale, std::min(1.0f, config.maxScale));
+    scale = config.enabled ? config.maxScale : 1.0f;
+    averageFrameTime = 0;
+    steadyTime = 0;
+}
+
+void DynamicResolution::Update(float frameTime) {
+    if (!config.enabled) return;
+
+    averageFrameTime = averageFrameTime == 0 ? frameTime : averageFrameTime * 0.9f + frameTime * 0.1f;
+    downCooldown = std::max(0.0f, downCooldown - frameTime);
+
+    if (averageFrameTime > config.targetFrameTime * RENDER_SCALE_MISS_RATIO) {
+        steadyTime = 0;
+        if (downCooldown <= 0 && scale > config.minScale) {
+            scale = std::max(config.minScale, scale - RENDER_SCALE_STEP);
+            downCooldown = RENDER_SCALE_DOWN_COOLDOWN;
+        }
+    }
+    else {
+        steadyTime += frameTime;
+        if (steadyTime >= RENDER_SCALE_UP_DELAY && scale < config.maxScale) {
+            scale = std::min(config.maxScale, scale + RENDER_SCALE_STEP);
+            steadyTime = 0;
+        }
+    }
+}
+
+void DynamicResolution::Begin() const {
+    BeginTextureMode(target);
+    ClearBackground(BLACK);
+
+    Camera2D camera = { { 0, 0 }, { 0, 0 }, 0, scale };
+    BeginMode2D(camera);
+}
+
+void DynamicResolution::End() const {
+    EndMode2D();
+    EndTextureMode();
+}
+
+void DynamicResolution::Draw() const {
+    // Мир занимает верхний левый угол таргета; по Y текстура перевернута
+    float renderWidth = (float)GetScaledWidth();
+    float renderHeight = (float)GetScaledHeight();
+    Rectangle source = { 0, height - renderHeight, renderWidth, -renderHeight };
+    Rectangle dest = { 0, 0, (float)width, (float)height };
+    DrawTexturePro(target.texture, source, dest, { 0, 0 }, 0, WHITE);
+}
@@ -1 +1,199 @@
-#pragma once
+﻿#pragma once
+#include "raylib.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "enemy.h"
+
+const int TEXT_CACHE_MAX_RUNS = 512;
+const int HUD_TEXTURE_WIDTH = 420;
+const int HUD_TEXTURE_HEIGHT = 300;
+
+const int MINIMAP_SIZE = 180;
+const int MINIMAP_DENSITY_BINS = 60;             // Не больше MINIMAP_SIZE
+const float MINIMAP_REFRESH_RATE = 10.0f;        // Гц
+const int MINIMAP_DENSITY_THRESHOLD = 300;       // В авто-режиме с этого числа врагов рисуется теплокарта
+const int MINIMAP_DENSITY_SATURATION = 32;       // Врагов в бине для максимального цвета
+
+const float RENDER_SCALE_STEP = 0.05f;
+const float RENDER_SCALE_DOWN_COOLDOWN = 0.25f;  // Сек между понижениями
+const float RENDER_SCALE_UP_DELAY = 2.0f;        // Сек ровных кадров перед повышением
+const float RENDER_SCALE_MISS_RATIO = 1.1f;      // Кадр дольше цели на 10% - промах
+
+// Кеш текстовых прогонов: для пары (строка, размер) один раз считаются ширина
+// (MeasureText) и раскладка глифов дефолтного шрифта, дальше рисуется без поиска глифов
+class TextCache {
+public:
+    int Measure(const char* text, int fontSize);
+    void Draw(const char* text, int posX, int posY, int fontSize, Color color);
+    void DrawCentered(const char* text, int centerX, int posY, int fontSize, Color color);
+    void Clear() { runs.clear(); }
+
+private:
+    struct TextRun {
+        int width = 0;
+        bool hasLayout = false;
+        std::vector<Rectangle> sources;
+        std::vector<Rectangle> destinations; // Относительно точки вывода
+    };
+
+    TextRun& GetRun(const char* text, int fontSize, bool needLayout);
+    void BuildLayout(TextRun& run, const char* text, int fontSize);
+
+    std::unordered_map<std::string, TextRun> runs;
+    std::string key;
+};
+
+enum HudWidgetKind {
+    HUD_TEXT = 0,
+    HUD_BAR
+};
+
+// Виджет HUD: строка собирается заново только при смене привязанных значений
+struct HudWidget {
+    HudWidgetKind kind = HUD_TEXT;
+    int x = 0;
+    int y = 0;
+    int fontSize = 20;
+    int width = 0;      // Для полосы
+    int height = 0;
+    Color color = WHITE;
+    Color backColor = BLANK;
+    std::string prefix;
+    std::string separator;
+    std::string suffix;
+    int valueCount = 0; // 0 - статичный текст, 1 - одно значение, 2 - значение/значение
+    int value = 0;
+    int secondValue = 0;
+    bool visible = true;
+    std::string text;
+};
+
+// HUD в режиме retained: виджеты рисуются в RenderTexture2D, которая
+// перерисовывается только если что-то изменилось, иначе это один блит за кадр
+class RetainedHud {
+public:
+    RetainedHud() : target({}), dirty(true) {}
+    ~RetainedHud() { Unload(); }
+
+    void Init(int width, int height);
+    void Unload();
+
+    int AddLabel(int x, int y, int fontSize, Color color, const std::string& text);
+    int AddValue(int x, int y, int fontSize, Color color, const std::string& prefix, const std::string& suffix = "");
+    int AddPair(int x, int y, int fontSize, Color color, const std::string& prefix, const std::string& separator);
+    int AddBar(int x, int y, int width, int height, Color fillColor, Color backColor);
+
+    void SetValue(int widget, int value);
+    void SetValues(int widget, int value, int secondValue);
+    void SetVisible(int widget, bool visible);
+
+    // Перерисовывает текстуру, если есть изменения; вызывать до BeginDrawing
+    void Rebuild(TextCache& textCache);
+    void Draw(int posX, int posY) const;
+
+private:
+    void FormatText(HudWidget& widget);
+
+    RenderTexture2D target;
+    bool dirty;
+    std::vector<HudWidget> widgets;
+};
+
+enum MinimapMode {
+    MINIMAP_AUTO = 0,
+    MINIMAP_DOTS,
+    MINIMAP_DENSITY,
+    MINIMAP_MODE_COUNT
+};
+
+// Миникарта, закешированная в текстуре и обновляемая с заданной частотой.
+// В режиме плотности враги раскладываются по бинам и загружаются теплокартой
+// одним UpdateTexture, поэтому стоимость не зависит от числа врагов.
+class Minimap {
+public:
+    Minimap() : target({}), heatmap({}), size(0), bins(0), refreshRate(MINIMAP_REFRESH_RATE),
+        refreshTimer(0), mode(MINIMAP_AUTO), showingDensity(false), needsRefresh(true) {}
+    ~Minimap() { Unload(); }
+
+    void Init(int newSize, int newBins);
+    void Unload();
+
+    void SetRefreshRate(float hz) { refreshRate = hz; }
+    float GetRefreshRate() const { return refreshRate; }
+    void SetMode(MinimapMode newMode) { mode = newMode; needsRefresh = true; }
+    void CycleMode() { SetMode((MinimapMode)((mode + 1) % MINIMAP_MODE_COUNT)); }
+    MinimapMode GetMode() const { return mode; }
+
+    // Перерисовывает кеш, если подошло время; вызывать до BeginDrawing
+    void Update(float deltaTime, Vector2 mapSize, World& world, const std::vector<EnemySwarm>& swarms);
+
+    // Блит кеша, рамка и точка игрока (игрок рисуется каждый кадр)
+    void Draw(int posX, int posY, Vector2 mapSize, Vector2 playerPosition) const;
+
+private:
+    void RenderDots(Vector2 mapSize, World& world, const std::vector<EnemySwarm>& swarms);
+    void RenderDensity(Vector2 mapSize, World& world, const std::vector<EnemySwarm>& swarms);
+
+    RenderTexture2D target;
+    Texture2D heatmap;
+    int size;
+    int bins;
+    float refreshRate;
+    float refreshTimer;
+    MinimapMode mode;
+    bool showingDensity;
+    bool needsRefresh;
+    std::vector<int> counts;
+    std::vector<Color> pixels;
+};
+
+struct DynamicResolutionConfig {
+    bool enabled = true;
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+    float targetFrameTime = 1.0f / 60.0f;
+};
+
+// Динамическое разрешение мирового прохода. Мир рисуется с масштабом scale
+// в левый верхний угол RenderTexture2D полного размера (через зум камеры),
+// затем растягивается на окно. Масштаб понижается, когда сглаженное время
+// кадра превышает цель, и осторожно повышается после серии ровных кадров:
+// при vsync запас по времени не виден, поэтому повышение идет пробами.
+class DynamicResolution {
+public:
+    DynamicResolution() : target({}), width(0), height(0), scale(1.0f), averageFrameTime(0),
+        downCooldown(0), steadyTime(0) {}
+    ~DynamicResolution() { Unload(); }
+
+    void Init(int newWidth, int newHeight);
+    void Unload();
+
+    void Configure(const DynamicResolutionConfig& newConfig);
+    const DynamicResolutionConfig& GetConfig() const { return config; }
+
+    void Update(float frameTime);
+
+    // Между Begin и End рисуется мир в экранных координатах окна
+    void Begin() const;
+    void End() const;
+
+    // Растягивает мир на окно; HUD рисуется после, в родном разрешении
+    void Draw() const;
+
+    float GetScale() const { return scale; }
+    bool IsActive() const { return config.enabled && target.id != 0; }
+
+private:
+    int GetScaledWidth() const { return (int)(width * scale); }
+    int GetScaledHeight() const { return (int)(height * scale); }
+
+    DynamicResolutionConfig config;
+    RenderTexture2D target;
+    int width;
+    int height;
+    float scale;
+    float averageFrameTime;
+    float downCooldown;
+    float steadyTime;
+};
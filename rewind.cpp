@@ -0,0 +1,217 @@
+﻿#include "rewind.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+static size_t ReadVarint(const unsigned char*& p) {
+    size_t value = 0;
+    for (int shift = 0;; shift += 7) {
+        unsigned char byte = *p++;
+        value |= (size_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+}
+
+void RewindBuffer::Init(int newMaxFrames, size_t byteCapacity) {
+    maxFrames = std::max(0, newMaxFrames);
+    capacity = maxFrames > 0 ? byteCapacity : 0;
+    data.assign(capacity, 0);
+    frames.assign(maxFrames, Frame());
+    Clear();
+}
+
+void RewindBuffer::Clear() {
+    firstFrame = 0;
+    frameCount = 0;
+    writeOffset = 0;
+    framesSinceKeyframe = 0;
+    hasPrevious = false;
+    previous.clear();
+}
+
+size_t RewindBuffer::GetUsedBytes() const {
+    size_t used = 0;
+    for (int i = 0; i < frameCount; i++) used += frames[FrameIndex(i)].size;
+    return used;
+}
+
+void RewindBuffer::DropOldest() {
+    firstFrame = (firstFrame + 1) % maxFrames;
+    frameCount--;
+}
+
+size_t RewindBuffer::Reserve(size_t size) {
+    size_t start = writeOffset;
+    if (start + size > capacity) start = 0;
+
+    // Кадры лежат в кольце по порядку записи, поэтому место освобождается вытеснением самых старых
+    for (;;) {
+        bool overlaps = false;
+        for (int i = 0; i < frameCount && !overlaps; i++) {
+            const Frame& frame = frames[FrameIndex(i)];
+            overlaps = frame.offset < start + size && start < frame.offset + frame.size;
+        }
+        if (!overlaps) break;
+        DropOldest();
+    }
+    return start;
+}
+
+static unsigned long long LoadWord(const unsigned char* bytes, size_t size, size_t offset) {
+    // Хвост за концом состояния считается нулями
+    unsigned long long word = 0;
+    if (offset + 8 <= size) {
+        std::memcpy(&word, bytes + offset, 8);
+    }
+    else if (offset < size) {
+        std::memcpy(&word, bytes + offset, size - offset);
+    }
+    return word;
+}
+
+void RewindBuffer::EncodeDelta() {
+    const unsigned char* cur = current.data();
+    const unsigned char* prev = previous.data();
+    size_t n = current.size();
+    size_t prevSize = previous.size();
+    size_t words = (n + 7) / 8;
+    size_t fastWords = std::min(n, prevSize) / 8;
+
+    // Худший случай: все слова изменились, плюс пара varint (до 4 байт каждый) на серию.
+    // Буфер только растет: повторный resize каждый тик обнулял бы его заново
+    size_t bound = words * 16 + 64;
+    if (encoded.size() < bound) encoded.resize(bound);
+    unsigned char* out = encoded.data();
+    size_t pos = 0;
+    auto writeVarint = [&](size_t value) {
+        while (value >= 0x80) {
+            out[pos++] = (unsigned char)(value | 0x80);
+            value >>= 7;
+        }
+        out[pos++] = (unsigned char)value;
+    };
+    auto diffWord = [&](size_t w) -> unsigned long long {
+        if (w < fastWords) {
+            unsigned long long a;
+            unsigned long long b;
+            std::memcpy(&a, cur + w * 8, 8);
+            std::memcpy(&b, prev + w * 8, 8);
+            return a ^ b;
+        }
+        return LoadWord(cur, n, w * 8) ^ LoadWord(prev, prevSize, w * 8);
+    };
+
+    // Пары (нулевых слов, слов литерала) и XOR-слова литерала
+    size_t w = 0;
+    while (w < words) {
+        size_t runStart = w;
+        while (w < fastWords && std::memcmp(cur + w * 8, prev + w * 8, 8) == 0) w++;
+        while (w < words && diffWord(w) == 0) w++;
+        size_t zeroRun = w - runStart;
+
+        size_t literalStart = w;
+        size_t literalPos = pos + 20;  // Место под два varint перед литералом
+        unsigned long long word;
+        while (w < words && (word = diffWord(w)) != 0) {
+            std::memcpy(out + literalPos + (w - literalStart) * 8, &word, 8);
+            w++;
+        }
+        size_t literalWords = w - literalStart;
+
+        writeVarint(zeroRun);
+        writeVarint(literalWords);
+        std::memmove(out + pos, out + literalPos, literalWords * 8);
+        pos += literalWords * 8;
+    }
+    encodedSize = pos;
+}
+
+bool RewindBuffer::Capture(unsigned int tick) {
+    if (!IsEnabled()) return false;
+    auto start = std::chrono::steady_clock::now();
+
+    bool keyframe = !hasPrevious || frameCount == 0 || framesSinceKeyframe + 1 >= REWIND_KEYFRAME_INTERVAL;
+    const unsigned char* source = current.data();
+    size_t size = current.size();
+    if (!keyframe) {
+        EncodeDelta();
+        source = encoded.data();
+        size = encodedSize;
+    }
+
+    if (size > capacity) {
+        Clear();
+        return false;
+    }
+
+    if (frameCount == maxFrames) DropOldest();
+    size_t offset = Reserve(size);
+    if (size > 0) std::memcpy(&data[offset], source, size);
+
+    Frame& frame = frames[FrameIndex(frameCount)];
+    frame.tick = tick;
+    frame.offset = offset;
+    frame.size = size;
+    frame.stateSize = current.size();
+    frame.keyframe = keyframe;
+    frameCount++;
+    writeOffset = offset + size;
+    framesSinceKeyframe = keyframe ? 0 : framesSinceKeyframe + 1;
+
+    // Дельты, чей ключевой кадр вытеснен, восстановить уже нельзя
+    while (frameCount > 0 && !frames[firstFrame].keyframe) DropOldest();
+
+    // Записанное состояние становится базой следующей дельты без копирования
+    std::swap(current, previous);
+    hasPrevious = true;
+
+    lastCaptureMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+bool RewindBuffer::Restore(unsigned int tick, std::vector<unsigned char>& out, unsigned int& restoredTick) {
+    int target = frameCount - 1;
+    while (target >= 0 && (int)(frames[FrameIndex(target)].tick - tick) > 0) target--;
+    if (target < 0) return false;
+
+    int key = target;
+    while (key >= 0 && !frames[FrameIndex(key)].keyframe) key--;
+    if (key < 0) return false;
+
+    const Frame& keyFrame = frames[FrameIndex(key)];
+    out.assign(data.begin() + keyFrame.offset, data.begin() + keyFrame.offset + keyFrame.size);
+
+    for (int order = key + 1; order <= target; order++) {
+        const Frame& frame = frames[FrameIndex(order)];
+        // Дельта считалась по словам: на время применения состояние дополняется до кратного 8
+        out.resize((frame.stateSize + 7) / 8 * 8);
+
+        const unsigned char* p = &data[frame.offset];
+        const unsigned char* end = p + frame.size;
+        unsigned char* target = out.data();
+        size_t w = 0;
+        while (p < end) {
+            w += ReadVarint(p);
+            size_t literalWords = ReadVarint(p);
+            for (size_t k = 0; k < literalWords; k++, w++, p += 8) {
+                unsigned long long a;
+                unsigned long long b;
+                std::memcpy(&a, target + w * 8, 8);
+                std::memcpy(&b, p, 8);
+                a ^= b;
+                std::memcpy(target + w * 8, &a, 8);
+            }
+        }
+        out.resize(frame.stateSize);
+    }
+
+    // Будущее после восстановленного тика отбрасывается
+    const Frame& restored = frames[FrameIndex(target)];
+    restoredTick = restored.tick;
+    writeOffset = restored.offset + restored.size;
+    frameCount = target + 1;
+    framesSinceKeyframe = target - key;
+    previous = out;
+    hasPrevious = true;
+    return true;
+}
@@ -0,0 +1,72 @@
+﻿#pragma once
+#include <vector>
+#include <cstddef>
+
+const float REWIND_DEFAULT_SECONDS = 10.0f;
+const int REWIND_KEYFRAME_INTERVAL = 30;              // Тиков между полными снимками
+const size_t REWIND_DEFAULT_BYTES = 48u * 1024 * 1024;
+const float REWIND_STEP_SECONDS = 1.0f;               // Шаг перемотки по клавише
+const float REWIND_HITCH_FRAME_TIME = 0.1f;           // Кадр дольше этого считается рывком
+const float REWIND_CHECK_WARMUP_SECONDS = 20.0f;      // --rewind-check: забег до снимка...
+const float REWIND_CHECK_DEFAULT_SECONDS = 5.0f;      // ...и сколько прогнать после него дважды
+
+// Кольцевой буфер снимков состояния. Раз в REWIND_KEYFRAME_INTERVAL тиков
+// снимок пишется целиком, между ними - XOR с прошлым тиком по 8-байтным
+// словам, сжатый по нулевым сериям: неизменившиеся слова почти ничего не стоят. Память под
+// данные и индекс выделяется один раз в Init; при нехватке места вытесняются
+// самые старые кадры вместе с дельтами, которые без них не восстановить.
+class RewindBuffer {
+public:
+    RewindBuffer() : capacity(0), maxFrames(0), firstFrame(0), frameCount(0), writeOffset(0),
+        framesSinceKeyframe(0), hasPrevious(false), encodedSize(0), lastCaptureMs(0) {}
+
+    void Init(int newMaxFrames, size_t byteCapacity);
+    void Clear();
+    bool IsEnabled() const { return maxFrames > 0; }
+
+    // Состояние пишется прямо в буфер записи, затем Capture запоминает его
+    // для тика. false, если снимок больше всего буфера
+    std::vector<unsigned char>& GetCaptureBuffer() { return current; }
+    bool Capture(unsigned int tick);
+
+    // Восстанавливает состояние тика (или ближайшего более раннего) в out и
+    // отбрасывает кадры новее него: запись дальше продолжается от восстановленного
+    bool Restore(unsigned int tick, std::vector<unsigned char>& out, unsigned int& restoredTick);
+
+    bool IsEmpty() const { return frameCount == 0; }
+    unsigned int GetOldestTick() const { return frames[firstFrame].tick; }
+    unsigned int GetNewestTick() const { return frames[FrameIndex(frameCount - 1)].tick; }
+    int GetFrameCount() const { return frameCount; }
+    size_t GetUsedBytes() const;
+    double GetLastCaptureMs() const { return lastCaptureMs; }
+
+private:
+    struct Frame {
+        unsigned int tick;
+        size_t offset;
+        size_t size;        // Байт в кольце
+        size_t stateSize;   // Размер состояния после применения
+        bool keyframe;
+    };
+
+    int FrameIndex(int order) const { return (firstFrame + order) % maxFrames; }
+    void DropOldest();
+    void EncodeDelta();
+    size_t Reserve(size_t size);
+
+    std::vector<unsigned char> data;
+    size_t capacity;
+    std::vector<Frame> frames;
+    int maxFrames;
+    int firstFrame;
+    int frameCount;
+    size_t writeOffset;
+    int framesSinceKeyframe;
+
+    std::vector<unsigned char> current;
+    std::vector<unsigned char> previous;   // Состояние последнего записанного тика
+    bool hasPrevious;
+    std::vector<unsigned char> encoded;
+    size_t encodedSize;
+    double lastCaptureMs;
+};
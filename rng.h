@@ -0,0 +1,34 @@
+﻿#pragma once
+
+// Генератор игровой логики (xorshift32). Состояние GetRandomValue спрятано
+// внутри raylib, а здесь оно - одно число: его можно положить в снимок
+// перемотки или сейв и после загрузки получить те же броски.
+class GameRandom {
+public:
+    GameRandom() : state(0x9e3779b9u) {}
+
+    void Seed(unsigned int seed) { state = seed != 0 ? seed : 0x9e3779b9u; }
+
+    unsigned int Next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // Целое из [min, max] включительно, как GetRandomValue
+    int Range(int min, int max) {
+        if (max < min) {
+            int swap = min;
+            min = max;
+            max = swap;
+        }
+        return min + (int)(Next() % ((unsigned int)(max - min) + 1u));
+    }
+
+    unsigned int GetState() const { return state; }
+    void SetState(unsigned int newState) { Seed(newState); }
+
+private:
+    unsigned int state;
+};
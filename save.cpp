@@ -0,0 +1,90 @@
+﻿#include "save.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+unsigned long long ChecksumSave(const unsigned char* data, size_t size) {
+    // FNV-1a, но по словам, а не по байтам
+    unsigned long long hash = 14695981039346656037ull;
+    size_t words = size / 8;
+    for (size_t i = 0; i < words; i++) {
+        unsigned long long word;
+        std::memcpy(&word, data + i * 8, 8);
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    for (size_t i = words * 8; i < size; i++) {
+        hash = (hash ^ data[i]) * 1099511628211ull;
+    }
+    return hash ^ size;
+}
+
+bool WriteSaveFile(const char* fileName, const SaveLayout& layout, const std::vector<unsigned char>& payload) {
+    SaveFileHeader header = {};
+    header.magic = SAVE_MAGIC;
+    header.version = SAVE_VERSION;
+    header.layout = layout;
+    header.payloadSize = payload.size();
+    header.checksum = ChecksumSave(payload.data(), payload.size());
+
+    std::string tempName = std::string(fileName) + ".tmp";
+    FILE* file = fopen(tempName.c_str(), "wb");
+    if (!file) return false;
+
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+        (payload.empty() || fwrite(payload.data(), payload.size(), 1, file) == 1);
+    written = (fclose(file) == 0) && written;
+    if (!written) {
+        remove(tempName.c_str());
+        return false;
+    }
+
+    if (!ReplaceFileAtomic(tempName.c_str(), fileName)) {
+        remove(tempName.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool SaveFile::Open(const char* fileName, const SaveLayout& expected) {
+    payload = nullptr;
+    payloadSize = 0;
+
+    if (!file.Open(fileName)) {
+        error = "cannot open file";
+        return false;
+    }
+    if (file.GetSize() < sizeof(SaveFileHeader)) {
+        error = "file too short";
+        return false;
+    }
+
+    SaveFileHeader header;
+    std::memcpy(&header, file.GetData(), sizeof(header));
+    if (header.magic != SAVE_MAGIC) {
+        error = "not a save file";
+        return false;
+    }
+    if (header.version != SAVE_VERSION) {
+        error = "unsupported version";
+        return false;
+    }
+    if (std::memcmp(&header.layout, &expected, sizeof(SaveLayout)) != 0) {
+        error = "saved by a build with a different layout";
+        return false;
+    }
+    if (header.payloadSize != file.GetSize() - sizeof(SaveFileHeader)) {
+        error = "truncated file";
+        return false;
+    }
+
+    const unsigned char* data = file.GetData() + sizeof(SaveFileHeader);
+    if (ChecksumSave(data, (size_t)header.payloadSize) != header.checksum) {
+        error = "checksum mismatch";
+        return false;
+    }
+
+    payload = data;
+    payloadSize = (size_t)header.payloadSize;
+    error = "";
+    return true;
+}
@@ -0,0 +1,56 @@
+﻿#pragma once
+#include "platform.h"
+#include <vector>
+#include <cstddef>
+
+const unsigned int SAVE_MAGIC = 0x5653444f;   // "ODSV"
+const unsigned int SAVE_VERSION = 3;
+const char* const SAVE_QUICK_FILE = "quicksave.odsv";
+
+// Раскладка записей, из которых собран снимок мира. Столбцы компонентов лежат
+// в файле как в памяти, поэтому сейв другой сборки с иной раскладкой структур
+// отвергается целиком, а не читается со сдвигом.
+struct SaveLayout {
+    unsigned int headerSize;
+    unsigned int componentLayout;   // World::GetLayoutHash
+    unsigned int swarmSize;
+};
+
+// Заголовок файла; сразу за ним идет снимок мира (тот же, что пишет перемотка). Размер кратен 8, чтобы массивы в
+// отображенном файле оставались выровненными.
+struct SaveFileHeader {
+    unsigned int magic;
+    unsigned int version;
+    SaveLayout layout;
+    unsigned int reserved;
+    unsigned long long payloadSize;
+    unsigned long long checksum;
+};
+
+static_assert(sizeof(SaveFileHeader) % 8 == 0, "SaveFileHeader must keep the payload 8-byte aligned");
+
+// Хэш по 8-байтным словам: 100k сущностей проверяются за пару миллисекунд
+unsigned long long ChecksumSave(const unsigned char* data, size_t size);
+
+// Пишет во временный файл и подменяет им старый, чтобы сбой посреди записи
+// не портил предыдущий сейв
+bool WriteSaveFile(const char* fileName, const SaveLayout& layout, const std::vector<unsigned char>& payload);
+
+// Сейв, отображенный в память. Open проверяет заголовок, версию, раскладку
+// и контрольную сумму; снимок мира читается прямо из отображения.
+class SaveFile {
+public:
+    SaveFile() : payload(nullptr), payloadSize(0), error("") {}
+
+    bool Open(const char* fileName, const SaveLayout& expected);
+
+    const unsigned char* GetPayload() const { return payload; }
+    size_t GetPayloadSize() const { return payloadSize; }
+    const char* GetError() const { return error; }
+
+private:
+    MappedFile file;
+    const unsigned char* payload;
+    size_t payloadSize;
+    const char* error;
+};
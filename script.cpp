@@ -0,0 +1,80 @@
+﻿#include "script.h"
+#include <algorithm>
+
+void ScriptScheduler::Start(ScriptTask task) {
+    std::coroutine_handle<> handle = task.handle;
+    task.handle = nullptr;
+    if (!handle) return;
+
+    scripts.push_back(handle);
+    Resume(handle);
+}
+
+void ScriptScheduler::Clear() {
+    for (auto handle : scripts) handle.destroy();
+    scripts.clear();
+    timers = decltype(timers)();
+    killWaits = decltype(killWaits)();
+    enemyWaits = decltype(enemyWaits)();
+    conditions.clear();
+    ready.clear();
+    time = 0;
+    kills = 0;
+    enemies = 0;
+    order = 0;
+    resumes = 0;
+}
+
+void ScriptScheduler::Reset(double newTime, int killCount, int enemyCount) {
+    Clear();
+    time = newTime;
+    kills = killCount;
+    enemies = enemyCount;
+}
+
+void ScriptScheduler::Resume(std::coroutine_handle<> handle) {
+    resumes++;
+    handle.resume();
+    if (handle.done()) {
+        scripts.erase(std::find(scripts.begin(), scripts.end(), handle));
+        handle.destroy();
+    }
+}
+
+void ScriptScheduler::Update(float deltaTime, int killCount, int enemyCount) {
+    time += deltaTime;
+    kills = killCount;
+    enemies = enemyCount;
+
+    // Сначала собираем всех готовых: ожидания, добавленные возобновленными
+    // сценариями, проверяются уже в следующем тике
+    ready.clear();
+    while (!timers.empty() && timers.top().wakeTime <= time) {
+        ready.push_back(timers.top().handle);
+        timers.pop();
+    }
+    while (!killWaits.empty() && killWaits.top().threshold <= kills) {
+        ready.push_back(killWaits.top().handle);
+        killWaits.pop();
+    }
+    while (!enemyWaits.empty() && enemyWaits.top().threshold > enemies) {
+        ready.push_back(enemyWaits.top().handle);
+        enemyWaits.pop();
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < conditions.size(); i++) {
+        if (conditions[i].condition()) {
+            ready.push_back(conditions[i].handle);
+        }
+        else {
+            if (kept != i) conditions[kept] = std::move(conditions[i]);
+            kept++;
+        }
+    }
+    conditions.resize(kept);
+
+    for (size_t i = 0; i < ready.size(); i++) {
+        Resume(ready[i]);
+    }
+}
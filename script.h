@@ -0,0 +1,160 @@
+﻿#pragma once
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <queue>
+#include <vector>
+
+class ScriptScheduler;
+
+// Сценарий - корутина, которая ждет co_await-ом время, число убийств,
+// число врагов или произвольное условие. Кадр корутины принадлежит
+// планировщику: задача только передает его в ScriptScheduler::Start.
+class ScriptTask {
+public:
+    struct promise_type {
+        ScriptTask get_return_object() { return ScriptTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    ScriptTask(ScriptTask&& other) noexcept : handle(other.handle) { other.handle = nullptr; }
+    ScriptTask(const ScriptTask&) = delete;
+    ScriptTask& operator=(const ScriptTask&) = delete;
+    ~ScriptTask() { if (handle) handle.destroy(); }
+
+private:
+    friend class ScriptScheduler;
+    explicit ScriptTask(std::coroutine_handle<promise_type> newHandle) : handle(newHandle) {}
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+// Планировщик сценариев. Ожидания лежат в очередях по своему условию: таймеры -
+// в куче по времени пробуждения, убийства и число врагов - в кучах по порогу.
+// За тик проверяются только вершины куч, поэтому спящие сценарии ничего не
+// стоят; опрашиваются лишь ожидания произвольного условия (Until).
+// Сценарии с одинаковым моментом пробуждения возобновляются в порядке засыпания.
+class ScriptScheduler {
+public:
+    ScriptScheduler() : time(0), kills(0), enemies(0), order(0), resumes(0) {}
+    ~ScriptScheduler() { Clear(); }
+
+    // Запускает сценарий до первого ожидания
+    void Start(ScriptTask task);
+
+    // Уничтожает все сценарии и ожидания; время и счетчики обнуляются
+    void Clear();
+
+    // Clear с заданными часами и счетчиками последнего тика - для сценариев,
+    // которые продолжаются с сохраненной точки
+    void Reset(double newTime, int killCount, int enemyCount);
+
+    // Продвигает время и возобновляет сценарии, чье условие выполнено.
+    // killCount - убийства за забег (не тратятся в магазине), enemyCount - враги на карте
+    void Update(float deltaTime, int killCount, int enemyCount);
+
+    struct TimeAwaiter {
+        ScriptScheduler* scheduler;
+        double wakeTime;
+        bool await_ready() const { return false; }
+        void await_suspend(std::coroutine_handle<> handle) { scheduler->timers.push({ wakeTime, scheduler->order++, handle }); }
+        void await_resume() const {}
+    };
+
+    struct KillsAwaiter {
+        ScriptScheduler* scheduler;
+        int target;
+        bool await_ready() const { return scheduler->kills >= target; }
+        void await_suspend(std::coroutine_handle<> handle) { scheduler->killWaits.push({ target, scheduler->order++, handle }); }
+        void await_resume() const {}
+    };
+
+    struct EnemiesBelowAwaiter {
+        ScriptScheduler* scheduler;
+        int limit;
+        bool await_ready() const { return scheduler->enemies < limit; }
+        void await_suspend(std::coroutine_handle<> handle) { scheduler->enemyWaits.push({ limit, scheduler->order++, handle }); }
+        void await_resume() const {}
+    };
+
+    struct ConditionAwaiter {
+        ScriptScheduler* scheduler;
+        std::function<bool()> condition;
+        bool await_ready() const { return condition(); }
+        void await_suspend(std::coroutine_handle<> handle) { scheduler->conditions.push_back({ std::move(condition), handle }); }
+        void await_resume() const {}
+    };
+
+    // co_await scheduler.Seconds(2.5f) - пробуждение в первом тике, где время дошло до цели
+    TimeAwaiter Seconds(float seconds) { return { this, time + seconds }; }
+    TimeAwaiter At(double wakeTime) { return { this, wakeTime }; }
+
+    // co_await scheduler.Kills(n) - пока убийств за забег не станет не меньше n
+    KillsAwaiter Kills(int total) { return { this, total }; }
+    KillsAwaiter MoreKills(int count) { return { this, kills + count }; }
+
+    // co_await scheduler.EnemiesBelow(n) - пока врагов на карте не станет меньше n
+    EnemiesBelowAwaiter EnemiesBelow(int limit) { return { this, limit }; }
+
+    // co_await scheduler.Until(...) - условие проверяется раз за тик
+    ConditionAwaiter Until(std::function<bool()> condition) { return { this, std::move(condition) }; }
+
+    double GetTime() const { return time; }
+    int GetKills() const { return kills; }
+    int GetEnemies() const { return enemies; }
+    int GetScriptCount() const { return (int)scripts.size(); }
+    long long GetResumeCount() const { return resumes; }
+
+private:
+    struct TimedWait {
+        double wakeTime;
+        unsigned long long order;
+        std::coroutine_handle<> handle;
+    };
+
+    struct ThresholdWait {
+        int threshold;
+        unsigned long long order;
+        std::coroutine_handle<> handle;
+    };
+
+    struct ConditionWait {
+        std::function<bool()> condition;
+        std::coroutine_handle<> handle;
+    };
+
+    // Вершина кучи - ближайшее пробуждение
+    struct WakesLater {
+        bool operator()(const TimedWait& a, const TimedWait& b) const {
+            return a.wakeTime != b.wakeTime ? a.wakeTime > b.wakeTime : a.order > b.order;
+        }
+    };
+    struct NeedsMoreKills {
+        bool operator()(const ThresholdWait& a, const ThresholdWait& b) const {
+            return a.threshold != b.threshold ? a.threshold > b.threshold : a.order > b.order;
+        }
+    };
+    struct NeedsFewerEnemies {
+        bool operator()(const ThresholdWait& a, const ThresholdWait& b) const {
+            return a.threshold != b.threshold ? a.threshold < b.threshold : a.order > b.order;
+        }
+    };
+
+    void Resume(std::coroutine_handle<> handle);
+
+    double time;
+    int kills;
+    int enemies;
+    unsigned long long order;
+    long long resumes;
+
+    std::vector<std::coroutine_handle<>> scripts;   // Все живые кадры, для Clear
+    std::priority_queue<TimedWait, std::vector<TimedWait>, WakesLater> timers;
+    std::priority_queue<ThresholdWait, std::vector<ThresholdWait>, NeedsMoreKills> killWaits;
+    std::priority_queue<ThresholdWait, std::vector<ThresholdWait>, NeedsFewerEnemies> enemyWaits;
+    std::vector<ConditionWait> conditions;
+    std::vector<std::coroutine_handle<>> ready;
+};
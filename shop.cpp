@@ -0,0 +1,54 @@
+﻿#include "shop.h"
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+void BuildShopItems(const ShopPricing& pricing, std::vector<ShopItem>& items) {
+    items.clear();
+    items.push_back({ SHOP_ITEM_MOON_SHARD, "Moon Shard", "-2% Attack Cooldown\nStacks", pricing.itemGoldPrice, 0, true, 1 });
+    items.push_back({ SHOP_ITEM_BOOTS_OF_TRAVEL, "Boots of Travel", "+3% Movement Speed\nStacks", pricing.itemGoldPrice, 0, true, 1 });
+    items.push_back({ SHOP_ITEM_DOOM_HEART, "Doom Heart", "+1 Enemy per Spawn\nStacks", pricing.itemGoldPrice, 0, true, 1 });
+    items.push_back({ SHOP_ITEM_POWER_CRYSTAL, "Power Crystal", "+2% Total Damage\nStacks", pricing.itemGoldPrice, 0, true, 1 });
+    items.push_back({ SHOP_ITEM_POCKET_HEROES, "Pocket Heroes", "Random Companion\nAny star level", 0, pricing.pocketHeroesKillsPrice, true, 2 });
+    items.push_back({ SHOP_ITEM_REFRESH_TOKEN, "Refresh Token", "Free Shop Refresh\n(0-6 uses)", pricing.itemGoldPrice, 0, true, 1 });
+}
+
+const char* GetShopItemName(const std::vector<ShopItem>& items, int id) {
+    for (const auto& item : items) {
+        if (item.id == id) return item.name.c_str();
+    }
+    return "Unknown";
+}
+
+int GetCompanionGoldPrice(const ShopPricing& pricing, int purchaseCount) {
+    // Симулятор экономики доводит число покупок до сотен: цена упирается в INT_MAX, а не переполняется
+    double price = pricing.companionGoldPrice * std::pow((double)pricing.companionGoldGrowth, (double)purchaseCount);
+    if (!(price < (double)INT_MAX)) return INT_MAX;
+    return (int)price;
+}
+
+int GetCompanionKillsPrice(const ShopPricing& pricing, int purchaseCount) {
+    return pricing.companionKillsPrice + purchaseCount * pricing.companionKillsStep;
+}
+
+bool SetShopPrice(ShopPricing& pricing, const char* assignment) {
+    const char* equals = strchr(assignment, '=');
+    if (!equals) return false;
+
+    std::string name(assignment, equals - assignment);
+    float value = (float)atof(equals + 1);
+
+    if (name == "item") pricing.itemGoldPrice = (int)value;
+    else if (name == "pocket-heroes") pricing.pocketHeroesKillsPrice = (int)value;
+    else if (name == "third-slot") pricing.thirdSlotKillsPrice = (int)value;
+    else if (name == "companion") pricing.companionGoldPrice = (int)value;
+    else if (name == "companion-growth") pricing.companionGoldGrowth = value;
+    else if (name == "companion-kills") pricing.companionKillsPrice = (int)value;
+    else if (name == "companion-kills-step") pricing.companionKillsStep = (int)value;
+    else if (name == "refresh") pricing.refreshKillsPrice = (int)value;
+    else if (name == "refresh-step") pricing.refreshKillsStep = (int)value;
+    else if (name == "refresh-interval") pricing.refreshInterval = value;
+    else return false;
+    return true;
+}
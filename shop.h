@@ -1 +1,59 @@
-#pragma once
+﻿#pragma once
+#include <string>
+#include <vector>
+
+// id предметов магазина
+enum ShopItemId {
+    SHOP_ITEM_MOON_SHARD = 1,
+    SHOP_ITEM_BOOTS_OF_TRAVEL,
+    SHOP_ITEM_DOOM_HEART,
+    SHOP_ITEM_POWER_CRYSTAL,
+    SHOP_ITEM_POCKET_HEROES,
+    SHOP_ITEM_REFRESH_TOKEN
+};
+
+const int SHOP_ITEM_COUNT = 6;
+const int SHOP_SLOT_COUNT = 3;
+
+// Структура для предметов магазина
+struct ShopItem {
+    int id = 0;
+    std::string name;
+    std::string description;
+    int goldPrice = 0;
+    int killsPrice = 0;
+    bool available = true;
+    int tier = 1;
+};
+
+struct ActiveShopItems {
+    ShopItem slot1;
+    ShopItem slot2;
+    ShopItem slot3;
+    float refreshTimer = 0;
+    int manualRefreshCost = 20;
+    int freeRefreshesLeft = 6;
+};
+
+// Все цены экономики в одном месте, чтобы симулятор мог их подбирать
+struct ShopPricing {
+    int itemGoldPrice = 400;               // Все предметы за золото
+    int pocketHeroesKillsPrice = 40;
+    int thirdSlotKillsPrice = 60;          // Третий слот всегда продается за убийства
+    int companionGoldPrice = 300;          // Случайный компаньон: цена первой покупки...
+    float companionGoldGrowth = 2.0f;      // ...умножается на это за каждую покупку
+    int companionKillsPrice = 30;
+    int companionKillsStep = 10;
+    int refreshKillsPrice = 20;            // Ручное обновление, дорожает на столько же
+    int refreshKillsStep = 20;
+    float refreshInterval = 60.0f;         // Автоматическое обновление, сек
+};
+
+void BuildShopItems(const ShopPricing& pricing, std::vector<ShopItem>& items);
+const char* GetShopItemName(const std::vector<ShopItem>& items, int id);
+
+int GetCompanionGoldPrice(const ShopPricing& pricing, int purchaseCount);
+int GetCompanionKillsPrice(const ShopPricing& pricing, int purchaseCount);
+
+// "name=value" из флага --price; false, если такой цены нет
+bool SetShopPrice(ShopPricing& pricing, const char* assignment);
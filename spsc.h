@@ -0,0 +1,44 @@
+﻿#pragma once
+#include <atomic>
+
+// Кольцевая очередь без блокировок на одного писателя и одного читателя.
+// Push зовет только поток-писатель, Pop - только поток-читатель. Емкость -
+// степень двойки; при полной очереди Push возвращает false, и писатель сам
+// решает, ждать или выбросить элемент
+template <typename T, int CAPACITY>
+class SpscQueue {
+    static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    SpscQueue() : head(0), tail(0) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    bool Push(const T& item) {
+        unsigned int write = tail.load(std::memory_order_relaxed);
+        if (write - head.load(std::memory_order_acquire) == (unsigned int)CAPACITY) return false;
+        items[write & (CAPACITY - 1)] = item;
+        tail.store(write + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Pop(T& item) {
+        unsigned int read = head.load(std::memory_order_relaxed);
+        if (read == tail.load(std::memory_order_acquire)) return false;
+        item = items[read & (CAPACITY - 1)];
+        head.store(read + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Приблизительно, если звать не из потока-читателя
+    int GetSize() const {
+        return (int)(tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire));
+    }
+
+private:
+    // Счетчики на разных кеш-линиях, чтобы потоки не толкались за одну
+    alignas(64) std::atomic<unsigned int> head;   // Читатель
+    alignas(64) std::atomic<unsigned int> tail;   // Писатель
+    alignas(64) T items[CAPACITY];
+};
@@ -0,0 +1,165 @@
+﻿// Утилита сборки пака ассетов.
+// Использование: assetpack <output.pak> <image> [image ...]
+// Мелкие картинки пакуются полками в один атлас (страница 0),
+// крупные (фоны) пишутся отдельными страницами. Все пиксели хранятся
+// декодированными в RGBA8, чтобы игра грузила их без декодирования PNG.
+#include "../../assetpack.h"
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+namespace {
+    const int ATLAS_WIDTH = 1024;
+    const int ATLAS_MAX_SPRITE = 320;   // Больше этого - отдельная страница
+    const int ATLAS_PADDING = 2;
+
+    struct InputImage {
+        std::string name;
+        Image image;
+        int page = -1;
+        int x = 0;
+        int y = 0;
+    };
+
+    std::string BaseName(const char* path) {
+        std::string name = path;
+        size_t slash = name.find_last_of("/\\");
+        if (slash != std::string::npos) name = name.substr(slash + 1);
+        for (auto& c : name) c = (char)std::tolower((unsigned char)c);
+        return name;
+    }
+
+    size_t AlignOffset(size_t offset) {
+        return (offset + ASSET_PIXEL_ALIGNMENT - 1) / ASSET_PIXEL_ALIGNMENT * ASSET_PIXEL_ALIGNMENT;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        printf("usage: assetpack <output.pak> <image> [image ...]\n");
+        return 1;
+    }
+
+    SetTraceLogLevel(LOG_WARNING);
+
+    std::vector<InputImage> inputs;
+    for (int i = 2; i < argc; i++) {
+        Image image = LoadImage(argv[i]);
+        if (image.data == nullptr) {
+            printf("assetpack: failed to load %s\n", argv[i]);
+            return 1;
+        }
+        ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+        InputImage input;
+        input.name = BaseName(argv[i]);
+        input.image = image;
+        if ((int)input.name.size() >= ASSET_NAME_LENGTH) {
+            printf("assetpack: name too long: %s\n", input.name.c_str());
+            return 1;
+        }
+        inputs.push_back(input);
+    }
+
+    // Полочная упаковка атласа: сортируем по высоте, заполняем строки слева направо
+    std::vector<InputImage*> atlasItems;
+    for (auto& input : inputs) {
+        if (input.image.width <= ATLAS_MAX_SPRITE && input.image.height <= ATLAS_MAX_SPRITE) {
+            atlasItems.push_back(&input);
+        }
+    }
+    std::sort(atlasItems.begin(), atlasItems.end(),
+        [](const InputImage* a, const InputImage* b) { return a->image.height > b->image.height; });
+
+    int shelfX = 0;
+    int shelfY = 0;
+    int shelfHeight = 0;
+    for (auto* item : atlasItems) {
+        if (shelfX + item->image.width > ATLAS_WIDTH) {
+            shelfY += shelfHeight + ATLAS_PADDING;
+            shelfX = 0;
+            shelfHeight = 0;
+        }
+        item->page = 0;
+        item->x = shelfX;
+        item->y = shelfY;
+        shelfX += item->image.width + ATLAS_PADDING;
+        shelfHeight = std::max(shelfHeight, item->image.height);
+    }
+
+    int atlasHeight = 1;
+    while (atlasHeight < shelfY + shelfHeight) atlasHeight *= 2;
+
+    std::vector<AssetPackPage> pages;
+    std::vector<Image> pageImages;
+    if (!atlasItems.empty()) {
+        Image atlas = GenImageColor(ATLAS_WIDTH, atlasHeight, BLANK);
+        for (auto* item : atlasItems) {
+            Rectangle source = { 0, 0, (float)item->image.width, (float)item->image.height };
+            Rectangle dest = { (float)item->x, (float)item->y, (float)item->image.width, (float)item->image.height };
+            ImageDraw(&atlas, item->image, source, dest, WHITE);
+        }
+        pages.push_back({ (unsigned int)atlas.width, (unsigned int)atlas.height, 0 });
+        pageImages.push_back(atlas);
+    }
+
+    for (auto& input : inputs) {
+        if (input.page == 0) continue;
+
+        input.page = (int)pages.size();
+        pages.push_back({ (unsigned int)input.image.width, (unsigned int)input.image.height, 0 });
+        pageImages.push_back(input.image);
+    }
+
+    std::vector<AssetPackRegion> regions;
+    for (const auto& input : inputs) {
+        AssetPackRegion region = {};
+        strncpy(region.name, input.name.c_str(), ASSET_NAME_LENGTH - 1);
+        region.page = (unsigned int)input.page;
+        region.x = (float)input.x;
+        region.y = (float)input.y;
+        region.width = (float)input.image.width;
+        region.height = (float)input.image.height;
+        regions.push_back(region);
+    }
+
+    AssetPackHeader header = { ASSET_PACK_MAGIC, ASSET_PACK_VERSION, (unsigned int)pages.size(), (unsigned int)regions.size() };
+
+    size_t offset = sizeof(header) + pages.size() * sizeof(AssetPackPage) + regions.size() * sizeof(AssetPackRegion);
+    for (auto& page : pages) {
+        offset = AlignOffset(offset);
+        page.offset = offset;
+        offset += (size_t)page.width * page.height * 4;
+    }
+
+    FILE* out = fopen(argv[1], "wb");
+    if (!out) {
+        printf("assetpack: cannot write %s\n", argv[1]);
+        return 1;
+    }
+
+    fwrite(&header, sizeof(header), 1, out);
+    fwrite(pages.data(), sizeof(AssetPackPage), pages.size(), out);
+    fwrite(regions.data(), sizeof(AssetPackRegion), regions.size(), out);
+
+    static const unsigned char zeros[ASSET_PIXEL_ALIGNMENT] = {};
+    for (size_t i = 0; i < pages.size(); i++) {
+        long position = ftell(out);
+        fwrite(zeros, 1, (size_t)(pages[i].offset - position), out);
+        fwrite(pageImages[i].data, 4, (size_t)pages[i].width * pages[i].height, out);
+    }
+    fclose(out);
+
+    printf("assetpack: %s - %d pages (atlas %dx%d), %d regions\n", argv[1], (int)pages.size(),
+        atlasItems.empty() ? 0 : ATLAS_WIDTH, atlasItems.empty() ? 0 : atlasHeight, (int)regions.size());
+
+    // Остальные страницы - это сами исходные картинки, они выгружаются ниже
+    if (!atlasItems.empty()) UnloadImage(pageImages[0]);
+    for (auto& input : inputs) {
+        UnloadImage(input.image);
+    }
+    return 0;
+}
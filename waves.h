@@ -0,0 +1,60 @@
+﻿#pragma once
+
+// Параметры волн для сценариев (см. Game::WaveScript). Между волнами враги
+// по-прежнему подтекают по одному раз в trickleInterval
+struct WavePlan {
+    float trickleInterval = 0.6f;     // Фоновый спавн, сек
+    float firstWaveDelay = 30.0f;     // Первая волна после начала забега
+    float waveInterval = 45.0f;       // Пауза после зачистки волны
+    int baseSize = 8;                 // Врагов в первой волне...
+    int sizeGrowth = 3;               // ...и на столько больше в каждой следующей
+    int eliteEvery = 3;               // Каждая такая волна - элитная
+    int clearPercent = 75;            // Волна считается зачищенной после стольких процентов убийств
+    float bannerTime = 2.5f;          // Сколько висит надпись о начале волны
+};
+
+inline int GetWaveSize(const WavePlan& plan, int wave) {
+    return plan.baseSize + plan.sizeGrowth * (wave - 1);
+}
+
+// Элитных врагов в волне: по одному на каждую пройденную элитную волну
+inline int GetWaveElites(const WavePlan& plan, int wave) {
+    return wave % plan.eliteEvery == 0 ? wave / plan.eliteEvery : 0;
+}
+
+enum WaveScriptId {
+    WAVE_SCRIPT_TRICKLE = 0,
+    WAVE_SCRIPT_WAVE,
+    WAVE_SCRIPT_SHOP,
+    WAVE_SCRIPT_COUNT
+};
+
+enum WavePhase {
+    WAVE_PHASE_DELAY = 0,   // Пауза перед следующей волной
+    WAVE_PHASE_CLEAR        // Волна выпущена, ждем зачистки
+};
+
+// Точки, с которых продолжаются сценарии волн. Лежат в снимке мира, поэтому
+// перемотка и загрузка продолжают отсчеты, а не начинают их заново.
+// Время - по часам планировщика сценариев
+struct WaveScriptState {
+    double nextTrickleTime;
+    int trickleWaitingRoom;        // Таймер вышел, ждем, пока враги поредеют
+    int wavePhase;                 // WavePhase
+    double waveDeadline;           // WAVE_PHASE_DELAY: выпуск следующей волны
+    int waveKillTarget;            // WAVE_PHASE_CLEAR: убийства за забег для зачистки
+    double nextShopRefreshTime;
+    // Порядок засыпания сценариев: при одном моменте пробуждения они
+    // после восстановления возобновляются в прежнем порядке
+    unsigned long long sleepOrder[WAVE_SCRIPT_COUNT];
+    unsigned long long sleepCount;
+};
+
+inline WaveScriptState GetStartingWaveScripts(const WavePlan& plan, float shopRefreshInterval) {
+    WaveScriptState state = {};
+    state.nextTrickleTime = plan.trickleInterval;
+    state.wavePhase = WAVE_PHASE_DELAY;
+    state.waveDeadline = plan.firstWaveDelay;
+    state.nextShopRefreshTime = shopRefreshInterval;
+    return state;
+}
@@ -0,0 +1,231 @@
+﻿#include "world.h"
+
+namespace {
+    size_t AlignColumn(size_t offset) {
+        return (offset + WORLD_COLUMN_ALIGNMENT - 1) / WORLD_COLUMN_ALIGNMENT * WORLD_COLUMN_ALIGNMENT;
+    }
+
+    void AppendWord(std::vector<unsigned char>& out, unsigned int value) {
+        const unsigned char* bytes = (const unsigned char*)&value;
+        out.insert(out.end(), bytes, bytes + sizeof(value));
+    }
+
+    bool ReadWord(const unsigned char*& data, const unsigned char* end, unsigned int& value) {
+        if (end - data < (ptrdiff_t)sizeof(value)) return false;
+        std::memcpy(&value, data, sizeof(value));
+        data += sizeof(value);
+        return true;
+    }
+}
+
+Archetype::Archetype(ComponentMask newMask, const int* sizes)
+    : mask(newMask), aliveOffset(0), chunkCapacity(1), chunkBytes(0), rowCount(0), deadCount(0) {
+    int rowBytes = (int)sizeof(Entity) + 1;
+    int columns = 2;
+    for (int c = 0; c < WORLD_MAX_COMPONENTS; c++) {
+        componentSizes[c] = Has(c) ? sizes[c] : 0;
+        columnOffsets[c] = 0;
+        if (Has(c)) {
+            rowBytes += componentSizes[c];
+            columns++;
+        }
+    }
+
+    // Сколько строк влезает в чанк с учетом выравнивания каждого столбца
+    chunkCapacity = std::max(1, (WORLD_CHUNK_BYTES - columns * WORLD_COLUMN_ALIGNMENT) / rowBytes);
+
+    size_t offset = (size_t)chunkCapacity * sizeof(Entity);
+    aliveOffset = (int)offset;
+    offset = AlignColumn(offset + chunkCapacity);
+    for (int c = 0; c < WORLD_MAX_COMPONENTS; c++) {
+        if (!Has(c)) continue;
+        columnOffsets[c] = (int)offset;
+        offset = AlignColumn(offset + (size_t)chunkCapacity * componentSizes[c]);
+    }
+    chunkBytes = offset;
+}
+
+Archetype::~Archetype() {
+    for (unsigned char* chunk : chunks) delete[] chunk;
+}
+
+int Archetype::AddRow(Entity entity) {
+    int row = rowCount++;
+    int chunk = row / chunkCapacity;
+    if (chunk == (int)chunks.size()) {
+        chunks.push_back(new unsigned char[chunkBytes]);
+    }
+    GetEntities(chunk)[row % chunkCapacity] = entity;
+    GetAlive(chunk)[row % chunkCapacity] = 1;
+    return row;
+}
+
+void Archetype::KillRow(int row) {
+    unsigned char& alive = GetAlive(row / chunkCapacity)[row % chunkCapacity];
+    if (alive) {
+        alive = 0;
+        deadCount++;
+    }
+}
+
+World::World() : needsFlush(false) {
+    std::memset(componentSizes, 0, sizeof(componentSizes));
+}
+
+Archetype* World::GetArchetype(ComponentMask mask, int& index) {
+    for (int a = 0; a < (int)archetypes.size(); a++) {
+        if (archetypes[a]->GetMask() == mask) {
+            index = a;
+            return archetypes[a].get();
+        }
+    }
+
+    archetypes.emplace_back(new Archetype(mask, componentSizes));
+    index = (int)archetypes.size() - 1;
+    return archetypes.back().get();
+}
+
+bool World::IsAlive(Entity entity) const {
+    if (entity.index >= locations.size()) return false;
+    const Location& location = locations[entity.index];
+    return location.archetype >= 0 && location.generation == entity.generation;
+}
+
+void World::Destroy(Entity entity) {
+    if (!IsAlive(entity)) return;
+
+    Location& location = locations[entity.index];
+    archetypes[location.archetype]->KillRow(location.row);
+    location.archetype = -1;
+    if (++location.generation == 0) location.generation = 1;
+    freeIndices.push_back(entity.index);
+    needsFlush = true;
+}
+
+void World::Flush() {
+    if (!needsFlush) return;
+    needsFlush = false;
+
+    for (auto& archetype : archetypes) {
+        archetype->Compact([this](Entity entity, int row) { locations[entity.index].row = row; });
+    }
+}
+
+void World::Clear() {
+    for (auto& archetype : archetypes) archetype->Clear();
+    locations.clear();
+    freeIndices.clear();
+    needsFlush = false;
+}
+
+unsigned int World::GetLayoutHash() const {
+    unsigned int hash = 2166136261u;
+    for (int c = 0; c < WORLD_MAX_COMPONENTS; c++) {
+        hash = (hash ^ (unsigned int)componentSizes[c]) * 16777619u;
+    }
+    return hash;
+}
+
+void World::Serialize(std::vector<unsigned char>& out) {
+    Flush();
+
+    // Таблица слотов целиком: после загрузки новые сущности получат те же
+    // индексы и поколения, что и в записанном забеге
+    AppendWord(out, (unsigned int)locations.size());
+    for (const Location& location : locations) AppendWord(out, location.generation);
+    AppendWord(out, (unsigned int)freeIndices.size());
+    for (unsigned int index : freeIndices) AppendWord(out, index);
+
+    unsigned int used = 0;
+    for (const auto& archetype : archetypes) {
+        if (archetype->GetRowCount() > 0) used++;
+    }
+    AppendWord(out, used);
+
+    for (const auto& archetype : archetypes) {
+        int rows = archetype->GetRowCount();
+        if (rows == 0) continue;
+        AppendWord(out, archetype->GetMask());
+        AppendWord(out, (unsigned int)rows);
+
+        int capacity = archetype->GetChunkCapacity();
+        for (int chunk = 0; chunk * capacity < rows; chunk++) {
+            int size = std::min(capacity, rows - chunk * capacity);
+            const unsigned char* entities = (const unsigned char*)archetype->GetEntities(chunk);
+            out.insert(out.end(), entities, entities + size * sizeof(Entity));
+        }
+        for (int c = 0; c < WORLD_MAX_COMPONENTS; c++) {
+            if (!archetype->Has(c)) continue;
+            int componentSize = archetype->GetComponentSize(c);
+            for (int chunk = 0; chunk * capacity < rows; chunk++) {
+                int size = std::min(capacity, rows - chunk * capacity);
+                const unsigned char* column = archetype->GetColumn(chunk, c);
+                out.insert(out.end(), column, column + (size_t)size * componentSize);
+            }
+        }
+    }
+}
+
+bool World::Deserialize(const unsigned char*& data, const unsigned char* end) {
+    Clear();
+
+    unsigned int slotCount;
+    if (!ReadWord(data, end, slotCount) || (size_t)(end - data) / sizeof(unsigned int) < slotCount) return false;
+    locations.resize(slotCount);
+    for (Location& location : locations) {
+        ReadWord(data, end, location.generation);
+        location.archetype = -1;
+        location.row = 0;
+    }
+
+    unsigned int freeCount;
+    if (!ReadWord(data, end, freeCount) || (size_t)(end - data) / sizeof(unsigned int) < freeCount) return false;
+    freeIndices.resize(freeCount);
+    for (unsigned int& index : freeIndices) {
+        ReadWord(data, end, index);
+        if (index >= slotCount) return false;
+    }
+
+    unsigned int used;
+    if (!ReadWord(data, end, used)) return false;
+    for (unsigned int u = 0; u < used; u++) {
+        unsigned int mask;
+        unsigned int rows;
+        if (!ReadWord(data, end, mask) || !ReadWord(data, end, rows)) return false;
+
+        size_t rowBytes = sizeof(Entity);
+        for (int c = 0; c < WORLD_MAX_COMPONENTS; c++) {
+            if (!(mask & (1u << c))) continue;
+            if (componentSizes[c] == 0) return false;
+            rowBytes += componentSizes[c];
+        }
+        if ((size_t)(end - data) / rowBytes < rows) return false;
+
+        int archetypeIndex;
+        Archetype* archetype = GetArchetype(mask, archetypeIndex);
+        if (archetype->GetRowCount() != 0) return false;
+
+        for (unsigned int r = 0; r < rows; r++) {
+            Entity entity;
+            std::memcpy(&entity, data, sizeof(Entity));
+            data += sizeof(Entity);
+            if (entity.index >= slotCount || locations[entity.index].archetype >= 0 ||
+                locations[entity.index].generation != entity.generation) return false;
+
+            locations[entity.index].archetype = archetypeIndex;
+            locations[entity.index].row = archetype->AddRow(entity);
+        }
+
+        int capacity = archetype->GetChunkCapacity();
+        for (int c = 0; c < WORLD_MAX_COMPONENTS; c++) {
+            if (!archetype->Has(c)) continue;
+            int componentSize = archetype->GetComponentSize(c);
+            for (int chunk = 0; chunk * capacity < (int)rows; chunk++) {
+                int size = std::min(capacity, (int)rows - chunk * capacity);
+                std::memcpy(archetype->GetColumn(chunk, c), data, (size_t)size * componentSize);
+                data += (size_t)size * componentSize;
+            }
+        }
+    }
+    return true;
+}
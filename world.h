@@ -0,0 +1,279 @@
+﻿#pragma once
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+
+const int WORLD_MAX_COMPONENTS = 32;
+const int WORLD_CHUNK_BYTES = 16 * 1024;
+const int WORLD_COLUMN_ALIGNMENT = 16;
+
+typedef unsigned int ComponentMask;
+
+// Хендл сущности: слот в таблице и его поколение. Поколение растет при
+// каждом удалении, поэтому старый хендл не попадет в новую сущность на том же слоте
+struct Entity {
+    unsigned int index;
+    unsigned int generation;   // 0 - пустой хендл
+
+    Entity() : index(0), generation(0) {}
+    Entity(unsigned int i, unsigned int g) : index(i), generation(g) {}
+
+    bool IsNull() const { return generation == 0; }
+    bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const Entity& other) const { return !(*this == other); }
+};
+
+// Компонент - простая структура с постоянным COMPONENT_ID: по id строится
+// маска архетипа и раскладка в снимках, поэтому id не должны меняться между сборками
+template <typename T>
+ComponentMask ComponentBit() {
+    static_assert(T::COMPONENT_ID >= 0 && T::COMPONENT_ID < WORLD_MAX_COMPONENTS, "Component id out of range");
+    return 1u << T::COMPONENT_ID;
+}
+
+template <typename... C>
+ComponentMask ComponentMaskOf() {
+    ComponentMask mask = 0;
+    using expand = int[];
+    (void)expand{ 0, (mask |= ComponentBit<C>(), 0)... };
+    return mask;
+}
+
+// Все сущности с одинаковым набором компонентов. Строки лежат в чанках по
+// WORLD_CHUNK_BYTES, внутри чанка каждый компонент - отдельным массивом:
+// система, читающая только позиции, не тянет в кеш здоровье и таймеры.
+// Удаленная строка только помечается, место освобождает Compact.
+class Archetype {
+public:
+    Archetype(ComponentMask newMask, const int* componentSizes);
+    ~Archetype();
+
+    ComponentMask GetMask() const { return mask; }
+    bool Has(int component) const { return (mask & (1u << component)) != 0; }
+
+    int GetRowCount() const { return rowCount; }
+    int GetAliveCount() const { return rowCount - deadCount; }
+    int GetChunkCapacity() const { return chunkCapacity; }
+    int GetComponentSize(int component) const { return componentSizes[component]; }
+
+    Entity* GetEntities(int chunk) const { return (Entity*)chunks[chunk]; }
+    unsigned char* GetAlive(int chunk) const { return chunks[chunk] + aliveOffset; }
+    unsigned char* GetColumn(int chunk, int component) const { return chunks[chunk] + columnOffsets[component]; }
+
+    template <typename T>
+    T* Column(int chunk) const { return (T*)GetColumn(chunk, T::COMPONENT_ID); }
+
+    void* GetComponent(int row, int component) const {
+        return GetColumn(row / chunkCapacity, component) + (size_t)(row % chunkCapacity) * componentSizes[component];
+    }
+    Entity GetEntity(int row) const { return GetEntities(row / chunkCapacity)[row % chunkCapacity]; }
+
+    // Новая живая строка в конце; компоненты не инициализируются
+    int AddRow(Entity entity);
+    void KillRow(int row);
+
+    // Сдвигает живые строки на место удаленных, сохраняя порядок.
+    // Для каждой перенесенной строки вызывает moved(entity, newRow)
+    template <typename F>
+    void Compact(F moved);
+
+    void Clear() { rowCount = 0; deadCount = 0; }
+
+private:
+    ComponentMask mask;
+    int componentSizes[WORLD_MAX_COMPONENTS];
+    int columnOffsets[WORLD_MAX_COMPONENTS];
+    int aliveOffset;
+    int chunkCapacity;
+    size_t chunkBytes;
+    int rowCount;
+    int deadCount;
+    std::vector<unsigned char*> chunks;   // Выделенные чанки живут до разрушения архетипа
+};
+
+// Хранилище сущностей. Системы перебирают только архетипы, содержащие нужные
+// компоненты, и получают ссылки прямо в столбцы чанков.
+// Create во время перебора безопасен: новые строки в текущий проход не попадают.
+// Destroy сразу скрывает сущность от перебора и Get, а память строк
+// освобождает Flush (раз за тик), сохраняя порядок создания - от него
+// зависят детерминизм симуляции и порядок сетевых id.
+class World {
+public:
+    World();
+
+    template <typename T>
+    void RegisterComponent() {
+        static_assert(std::is_trivially_copyable<T>::value, "Components are copied as bytes");
+        componentSizes[T::COMPONENT_ID] = (int)sizeof(T);
+    }
+
+    template <typename... C>
+    Entity Create(const C&... components);
+
+    void Destroy(Entity entity);
+    bool IsAlive(Entity entity) const;
+
+    // nullptr, если сущность удалена или у нее нет такого компонента
+    template <typename T>
+    T* Get(Entity entity) const;
+
+    // Уплотняет архетипы, в которых есть удаленные строки
+    void Flush();
+
+    // Удаляет все сущности; чанки остаются выделенными для следующего забега
+    void Clear();
+
+    // Сущности, у которых есть все перечисленные компоненты
+    template <typename... C>
+    int Count() const;
+
+    // fn(C&...) для каждой живой сущности с компонентами C...
+    template <typename... C, typename F>
+    void Each(F&& fn);
+
+    // То же с хендлом сущности первым аргументом: fn(Entity, C&...)
+    template <typename... C, typename F>
+    void EachEntity(F&& fn);
+
+    // Дописывает в out таблицу хендлов и все архетипы столбцами; перед
+    // записью делает Flush. Deserialize заменяет мир целиком и сдвигает data
+    // за прочитанное; false, если данные обрезаны или не сходятся с компонентами
+    void Serialize(std::vector<unsigned char>& out);
+    bool Deserialize(const unsigned char*& data, const unsigned char* end);
+
+    // Хэш размеров зарегистрированных компонентов: сейв с другой раскладкой не читается
+    unsigned int GetLayoutHash() const;
+
+private:
+    struct Location {
+        unsigned int generation;
+        int archetype;   // -1 - слот свободен
+        int row;
+    };
+
+    Archetype* GetArchetype(ComponentMask mask, int& index);
+
+    template <typename F, typename... C>
+    static void RunChunk(F& fn, const Entity* entities, const unsigned char* alive, int size, C*... columns) {
+        for (int i = 0; i < size; i++) {
+            if (alive[i]) fn(entities[i], columns[i]...);
+        }
+    }
+
+    template <typename... C, typename F>
+    void ForEachChunk(F& fn);
+
+    int componentSizes[WORLD_MAX_COMPONENTS];
+    std::vector<std::unique_ptr<Archetype>> archetypes;
+    std::vector<Location> locations;   // По индексу сущности
+    std::vector<unsigned int> freeIndices;
+    bool needsFlush;
+};
+
+template <typename F>
+void Archetype::Compact(F moved) {
+    if (deadCount == 0) return;
+
+    int write = 0;
+    for (int read = 0; read < rowCount; read++) {
+        int readChunk = read / chunkCapacity;
+        int readSlot = read % chunkCapacity;
+        if (!GetAlive(readChunk)[readSlot]) continue;
+
+        if (write != read) {
+            int writeChunk = write / chunkCapacity;
+            int writeSlot = write % chunkCapacity;
+            Entity entity = GetEntities(readChunk)[readSlot];
+            GetEntities(writeChunk)[writeSlot] = entity;
+            GetAlive(writeChunk)[writeSlot] = 1;
+            for (int c = 0; c < WORLD_MAX_COMPONENTS; c++) {
+                if (!Has(c) || componentSizes[c] == 0) continue;
+                std::memcpy(GetColumn(writeChunk, c) + (size_t)writeSlot * componentSizes[c],
+                    GetColumn(readChunk, c) + (size_t)readSlot * componentSizes[c], componentSizes[c]);
+            }
+            moved(entity, write);
+        }
+        write++;
+    }
+    rowCount = write;
+    deadCount = 0;
+}
+
+template <typename... C>
+Entity World::Create(const C&... components) {
+    using expand = int[];
+    (void)expand{ 0, (RegisterComponent<C>(), 0)... };
+
+    int archetypeIndex;
+    Archetype* archetype = GetArchetype(ComponentMaskOf<C...>(), archetypeIndex);
+
+    unsigned int index;
+    if (!freeIndices.empty()) {
+        index = freeIndices.back();
+        freeIndices.pop_back();
+    }
+    else {
+        index = (unsigned int)locations.size();
+        locations.push_back({ 1, -1, 0 });
+    }
+
+    Location& location = locations[index];
+    Entity entity(index, location.generation);
+    location.archetype = archetypeIndex;
+    location.row = archetype->AddRow(entity);
+
+    (void)expand{ 0, (*(C*)archetype->GetComponent(location.row, C::COMPONENT_ID) = components, 0)... };
+    return entity;
+}
+
+template <typename T>
+T* World::Get(Entity entity) const {
+    if (!IsAlive(entity)) return nullptr;
+    const Location& location = locations[entity.index];
+    const Archetype& archetype = *archetypes[location.archetype];
+    if (!archetype.Has(T::COMPONENT_ID)) return nullptr;
+    return (T*)archetype.GetComponent(location.row, T::COMPONENT_ID);
+}
+
+template <typename... C>
+int World::Count() const {
+    ComponentMask mask = ComponentMaskOf<C...>();
+    int count = 0;
+    for (const auto& archetype : archetypes) {
+        if ((archetype->GetMask() & mask) == mask) count += archetype->GetAliveCount();
+    }
+    return count;
+}
+
+template <typename... C, typename F>
+void World::ForEachChunk(F& fn) {
+    ComponentMask mask = ComponentMaskOf<C...>();
+
+    // Размеры фиксируются до перебора: созданное внутри fn ждет следующего прохода
+    int archetypeCount = (int)archetypes.size();
+    for (int a = 0; a < archetypeCount; a++) {
+        Archetype& archetype = *archetypes[a];
+        if ((archetype.GetMask() & mask) != mask || archetype.GetAliveCount() == 0) continue;
+
+        int rows = archetype.GetRowCount();
+        int capacity = archetype.GetChunkCapacity();
+        for (int chunk = 0; chunk * capacity < rows; chunk++) {
+            int size = std::min(capacity, rows - chunk * capacity);
+            RunChunk(fn, archetype.GetEntities(chunk), archetype.GetAlive(chunk), size, archetype.Column<C>(chunk)...);
+        }
+    }
+}
+
+template <typename... C, typename F>
+void World::Each(F&& fn) {
+    auto call = [&fn](Entity, C&... components) { fn(components...); };
+    ForEachChunk<C...>(call);
+}
+
+template <typename... C, typename F>
+void World::EachEntity(F&& fn) {
+    ForEachChunk<C...>(fn);
+}